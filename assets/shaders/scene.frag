@@ -23,21 +23,25 @@ layout(binding = 1) uniform UniformLights
 }
 lights;
 
+// materials of every model, indexed by the model's material
+layout(constant_id = 1) const uint materialCount = 1;
+
 layout(binding = 2) uniform sampler2D shadowMap;
-layout(binding = 3) uniform sampler2D diffuseMap;
-layout(binding = 4) uniform sampler2D normalMap;
-layout(binding = 5) uniform sampler2D roughnessMap;
-layout(binding = 6) uniform sampler2D metallicMap;
-layout(binding = 7) uniform sampler2D aoMap;
-layout(binding = 8) uniform samplerCube irradianceMap;
-layout(binding = 9) uniform samplerCube radianceMap;
-layout(binding = 10) uniform sampler2D brdfMap;
+layout(binding = 3) uniform sampler2D diffuseMaps[materialCount];
+layout(binding = 4) uniform sampler2D normalMaps[materialCount];
+// ao in red, roughness in green, metallic in blue
+layout(binding = 5) uniform sampler2D ormMaps[materialCount];
+layout(binding = 6) uniform samplerCube irradianceMap;
+layout(binding = 7) uniform samplerCube radianceMap;
+layout(binding = 8) uniform sampler2D brdfMap;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inUV;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec4 lightPos;
 layout(location = 4) in vec4 camPos;
+// the same for a whole draw so it may index the maps
+layout(location = 5) flat in uint inMaterial;
 
 layout(location = 0) out vec4 outColor;
 
@@ -46,7 +50,7 @@ layout(location = 0) out vec4 outColor;
 vec3 getNormal(vec3 position, vec3 normal)
 {
     // Perturb normal, see http://www.thetenthplanet.de/archives/1180
-    vec3 tangentNormal = texture(normalMap, inUV).xyz * 2.F - 1.F;
+    vec3 tangentNormal = texture(normalMaps[inMaterial], inUV).xyz * 2.F - 1.F;
 
     vec3 q1 = dFdx(position);
     vec3 q2 = dFdy(position);
@@ -134,10 +138,11 @@ vec3 iblBRDF(vec3 N, vec3 V, vec3 baseColor, float roughness, float metallic)
 
 void main()
 {
-    vec3 baseColor = texture(diffuseMap, inUV).rgb;
-    float metallic = texture(metallicMap, inUV).r;
-    float roughness = texture(roughnessMap, inUV).r;
-    float ambientOcclusion = texture(aoMap, inUV).r;
+    vec3 baseColor = texture(diffuseMaps[inMaterial], inUV).rgb;
+    vec3 orm = texture(ormMaps[inMaterial], inUV).rgb;
+    float ambientOcclusion = orm.r;
+    float roughness = orm.g;
+    float metallic = orm.b;
 
     vec3 N = getNormal(inPosition, inNormal);      // Normal vector
     vec3 V = normalize(vec3(camPos) - inPosition); // Vector from camera to model
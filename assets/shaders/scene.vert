@@ -2,18 +2,34 @@
 
 layout(binding = 0) uniform UniformVertex
 {
-    mat4 model;
     mat4 view;
     mat4 projection;
-    mat4 lightMVP;
-    mat4 normalMatrix;
+    mat4 lightViewProjection;
     vec4 camPos;
-    float uvScale;
 }
 vertexBuffer;
 
+// per model, read with the draw's first instance
+struct Instance
+{
+    mat4 model;
+    mat4 normalMatrix;
+    float uvScale;
+    uint material;
+};
+
+layout(std430, binding = 9) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+// set for meshes using the packed vertex layout
+layout(constant_id = 0) const bool packedVertices = false;
+
+// packed positions arrive in the mesh's snorm box, the model matrix scales them back
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inUV;
+// packed normals are octahedral encoded in xy
 layout(location = 2) in vec3 inNormal;
 
 layout(location = 0) out vec4 outPosition;
@@ -21,19 +37,33 @@ layout(location = 1) out vec2 outUV;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec4 lightWorldPos;
 layout(location = 4) out vec4 camPos;
+layout(location = 5) flat out uint outMaterial;
 
 const mat4 biasMat = mat4(0.5, 0.0, 0.0, 0.0, //
                           0.0, 0.5, 0.0, 0.0, //
                           0.0, 0.0, 1.0, 0.0, //
                           0.5, 0.5, 0.0, 1.0);
 
+vec3 octDecode(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    // unfold the lower hemisphere
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
+
 void main()
 {
-    outUV = inUV * vertexBuffer.uvScale;
-    outNormal = normalize(mat3(vertexBuffer.normalMatrix) * inNormal);
+    Instance instance = instances[gl_InstanceIndex];
+    vec3 normal = packedVertices ? octDecode(inNormal.xy) : inNormal;
+    outUV = inUV * instance.uvScale;
+    outNormal = normalize(mat3(instance.normalMatrix) * normal);
     camPos = vertexBuffer.camPos;
+    outMaterial = instance.material;
     
-    outPosition =  vertexBuffer.model * vec4(inPosition, 1.0);
-    lightWorldPos = biasMat * vertexBuffer.lightMVP * vec4(inPosition, 1.0);
+    outPosition =  instance.model * vec4(inPosition, 1.0);
+    lightWorldPos = biasMat * vertexBuffer.lightViewProjection * outPosition;
     gl_Position = vertexBuffer.projection * vertexBuffer.view * outPosition;
 }
\ No newline at end of file
@@ -8,14 +8,27 @@ layout(location = 0) out vec4 outPosition;
 
 layout(binding = 0) uniform UniformShadow
 {
-    mat4 model;
     mat4 view;
     mat4 projection;
 }
 shadowBuffer;
 
+// per model, read with the draw's first instance
+struct Instance
+{
+    mat4 model;
+    mat4 normalMatrix;
+    float uvScale;
+    uint material;
+};
+
+layout(std430, binding = 1) readonly buffer Instances
+{
+    Instance instances[];
+};
+
 void main()
 {
-    outPosition = shadowBuffer.view * shadowBuffer.model * vec4(inPosition, 1.0);
+    outPosition = shadowBuffer.view * instances[gl_InstanceIndex].model * vec4(inPosition, 1.0);
     gl_Position = shadowBuffer.projection * outPosition;
 }
\ No newline at end of file
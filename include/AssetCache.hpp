@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tat
+{
+
+// Directory of cooked assets named by a hash of everything they were cooked from
+// A key covers the bytes of each source, the import settings and the cooker's version, so entries never go stale,
+// changing any of them just looks up a different entry
+// Entries are written to a temporary file then renamed, other threads and instances only ever see whole entries
+class AssetCache
+{
+  public:
+    // an empty path turns the cache off
+    void create(const std::string &path);
+
+    // file of the entry cooked from sources with settings by version, it may not exist yet
+    // empty if the cache is off or a source can't be read
+    auto entry(const std::vector<std::string> &sources, const std::string &settings, uint32_t version,
+               const std::string &extension) const -> std::string;
+    // write is given a temporary file to fill, which then becomes entry
+    // false and a warning if anything throws, a cache that can't be written only costs the next start an import
+    auto store(const std::string &entry, const std::function<void(const std::string &)> &write) const -> bool;
+
+    // file to read the texture source from
+    // textures that can't be mapped are stored as a dds that can, the first time they are read
+    auto texture(const std::string &source) const -> std::string;
+
+  private:
+    std::string path{};
+};
+
+} // namespace tat
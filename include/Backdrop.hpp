@@ -16,6 +16,7 @@
 
 #include "Camera.hpp"
 #include "Collection.hpp"
+#include "Records.hpp"
 
 namespace tat
 {
@@ -28,6 +29,10 @@ struct UniformBack
 class Backdrop : public Entry
 {
   public:
+    using Record = BackdropRecord;
+    // config this loads from, set by the collection
+    Record record{};
+
     Backdrop() = default;
     virtual ~Backdrop();
     glm::vec3 light{};
@@ -43,6 +48,15 @@ class Backdrop : public Entry
 
     void recreate();
     void cleanup();
+    // reads the cube maps again and points the descriptor sets at them, the device must be idle
+    // false and a warning if they can't be read, the previous maps are kept
+    auto reload() -> bool override;
+    // destroys the maps, descriptors and pipeline, no frame in flight may use them
+    void unload() override;
+    // every face and level of the maps
+    auto residentBytes() -> uint64_t override;
+    // rebuilds the pipeline from the shader files, the device must be idle
+    void reloadPipeline();
 
     void draw(vk::CommandBuffer commandBuffer, uint32_t currentImage);
     void update(uint32_t currentImage);
@@ -1,10 +1,16 @@
 #pragma once
 
-#include <map>
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <spdlog/spdlog.h>
+
+#include "ThreadPool.hpp"
+
 namespace tat
 {
 
@@ -18,14 +24,52 @@ class Entry
     bool loaded = false;
     // load should set loaded to true in derived class after loading
     virtual void load(){};
+    // load split in two for loading in parallel
+    // decode reads and parses files on a worker, it must not touch the gpu or other entries
+    // upload then runs on the main thread and sets loaded, entries that don't split load there
+    virtual void decode(){};
+    virtual void upload()
+    {
+        load();
+    };
+    // releases what load made and clears loaded, the entry itself stays and may be loaded again
+    virtual void unload()
+    {
+        loaded = false;
+    };
+    // reads the files of a loaded entry again in place, false if that failed
+    virtual auto reload() -> bool
+    {
+        unload();
+        load();
+        return loaded;
+    };
+    // bytes of gpu memory the entry holds while loaded, unloading it frees them
+    virtual auto residentBytes() -> uint64_t
+    {
+        return 0;
+    };
     // name is set on construction of the collection
     std::string name{};
 };
 
+// refers to an entry of a Collection<T> until it is removed
+// a slot reused by a later entry has another generation so stale handles find nothing, as does a default handle
+template <class T> struct Handle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+};
+
 // Collection is a lazy loading container
 // Objects in collection must be derived from Entry
+// and have a Record type their json converts to, stored in their record member
 // Until get or load is called the entry is not loaded
 // get will load and return the entry or return an already loaded entry
+// decode and upload load many entries at once, decoding them on a thread pool
+// Entries are allocated one by one so pointers to them stay valid until they are removed,
+// entries may be added, unloaded and removed while running from the main thread
+// The frame each entry was last got is kept so the least recently used can be unloaded when memory runs low
 // type: this should be the type that holds T in state
 // ie backdrops for Backdrop
 template <class T> class Collection
@@ -40,70 +84,251 @@ template <class T> class Collection
         // get state
         auto &state = State::instance();
 
-        int32_t index = 0;
-        for (auto &[key, _] : state.at(type).items())
+        auto &entries = state.at(type);
+        slots.reserve(entries.size());
+        names.reserve(entries.size());
+        for (auto &[key, value] : entries.items())
         { // iterate through type in state
-            T t{};
-            t.name = key;
-            collection.push_back(t);
-            // store name,index in map for getting index later
-            names.insert(std::make_pair(key, index));
-            ++index;
+            // entries read their typed record from here on
+            add(key, value.template get<typename T::Record>());
         }
     };
 
-    // returns ptr to loaded entry
-    // loads entry if it is not loaded
-    auto get(const std::string &name) -> T *
+    // adds an entry that isn't loaded yet
+    // if name is already in the collection that entry is kept and its handle returned
+    auto add(const std::string &name, const typename T::Record &record) -> Handle<T>
     {
-        int32_t index = getIndex(name);
-        return load(index);
+        auto existing = handle(name);
+        if (existing.generation != 0)
+        {
+            return existing;
+        }
+
+        uint32_t index = 0;
+        if (free.empty())
+        {
+            index = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+        else
+        { // reuse a removed entry's slot
+            index = free.back();
+            free.pop_back();
+        }
+        auto &slot = slots[index];
+        slot.entry = std::make_unique<T>();
+        slot.entry->name = name;
+        slot.entry->record = record;
+        slot.lastUse = 0;
+        names.emplace(name, index);
+        return {index, slot.generation};
     }
 
-    // return index of entry if exists, -1 otherwise
-    // does not load entry
-    auto getIndex(const std::string &name) -> int32_t
+    // destroys the entry, nothing may use it or its resources any more
+    // false if the handle is stale
+    auto remove(Handle<T> handle) -> bool
+    {
+        auto *entry = find(handle);
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        names.erase(entry->name);
+        auto &slot = slots[handle.index];
+        slot.entry.reset();
+        // 0 is left for default handles
+        slot.generation = slot.generation == UINT32_MAX ? 1 : slot.generation + 1;
+        free.push_back(handle.index);
+        return true;
+    }
+
+    // handle of the named entry, a default handle if there is none
+    auto handle(const std::string &name) const -> Handle<T>
     {
         auto it = names.find(name);
-        if (it != names.end())
-        { // if name is found return value of map (index)
-            return it->second;
+        if (it == names.end())
+        {
+            return {};
         }
-        // else return -1
-        return -1;
+        return {it->second, slots[it->second].generation};
     }
 
-    // loads entry at index if not loaded and return ptr to it
-    // if index does not exist it returns item at index 0
-    auto load(int32_t index) -> T *
+    // returns ptr to entry if the handle is current, nullptr otherwise
+    // does not load entry
+    auto find(Handle<T> handle) -> T *
     {
-        if (index > collection.size() || index < 0)
-        { // return null if index out of range
+        if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation)
+        {
             return nullptr;
         }
-        // load default entry so we always have an entry
-        auto entry = &collection[index];
+        return slots[handle.index].entry.get();
+    }
 
-        if (entry->loaded == true)
-        { // if already loaded return
-            return entry;
+    auto find(const std::string &name) -> T *
+    {
+        return find(handle(name));
+    }
+
+    // returns ptr to loaded entry and marks it used this frame
+    // loads entry if it is not loaded, nullptr if the handle is stale
+    auto get(Handle<T> handle) -> T *
+    {
+        auto *entry = find(handle);
+        if (entry == nullptr)
+        {
+            return nullptr;
+        }
+        if (!entry->loaded)
+        {
+            entry->load();
         }
-        // otherwise load the material
-        entry->load();
+        slots[handle.index].lastUse = State::instance().engine.frameCount;
         return entry;
     }
 
+    auto get(const std::string &name) -> T *
+    {
+        return get(handle(name));
+    }
+
+    // releases the entry's resources, pointers to it stay valid and get loads it again
+    // nothing may use its resources any more, including frames in flight
+    // false if the handle is stale or the scene draws the entry, its models would keep pointing at what is released
+    auto unload(Handle<T> handle) -> bool
+    {
+        auto *entry = find(handle);
+        if (entry == nullptr || !drawable(entry))
+        {
+            return false;
+        }
+        if (entry->loaded)
+        {
+            entry->unload();
+        }
+        return true;
+    }
+
+    // reads a loaded entry's files again in place or loads one that isn't
+    // false if that failed or the handle is stale, the device must be idle
+    // entries the scene draws are refused, Scene's reload functions also rewrite what refers to them
+    auto reload(Handle<T> handle) -> bool
+    {
+        auto *entry = find(handle);
+        if (entry == nullptr || !drawable(entry))
+        {
+            return false;
+        }
+        if (!entry->loaded)
+        {
+            entry->load();
+            return entry->loaded;
+        }
+        return entry->reload();
+    }
+
+    // loaded entry with the frame it was last got and the gpu memory it holds
+    struct Resident
+    {
+        Handle<T> handle{};
+        T *entry = nullptr;
+        uint64_t lastUse = 0;
+        uint64_t bytes = 0;
+    };
+
+    // every loaded entry, in slot order
+    auto resident() -> std::vector<Resident>
+    {
+        std::vector<Resident> entries{};
+        for (uint32_t index = 0; index < slots.size(); ++index)
+        {
+            auto &slot = slots[index];
+            if (slot.entry && slot.entry->loaded)
+            {
+                entries.push_back({{index, slot.generation}, slot.entry.get(), slot.lastUse,
+                                   slot.entry->residentBytes()});
+            }
+        }
+        return entries;
+    }
+
+    // entry being decoded on a worker
+    struct Decoding
+    {
+        T *entry = nullptr;
+        uint32_t index = 0;
+        std::future<void> decoded{};
+    };
+
+    // queues decode of every named entry that isn't loaded yet, unknown and repeated names are skipped
+    // pass the result to upload once other work has been queued
+    // entries may be added meanwhile, but none of those queued may be removed or unloaded
+    auto decode(const std::vector<std::string> &names, ThreadPool &pool) -> std::vector<Decoding>
+    {
+        std::vector<Decoding> decoding{};
+        std::vector<bool> queued(slots.size(), false);
+        for (auto &name : names)
+        {
+            auto current = handle(name);
+            auto *entry = find(current);
+            if (entry == nullptr || queued[current.index] || entry->loaded)
+            {
+                continue;
+            }
+            queued[current.index] = true;
+            decoding.push_back({entry, current.index, pool.submit([entry]() { entry->decode(); })});
+        }
+        return decoding;
+    }
+
+    // uploads entries in the order they were queued as each finishes decoding, main thread only
+    // every entry's copies are flushed as one batch so the gpu works while later entries decode
+    // rethrows the first exception thrown by a decode
+    void upload(std::vector<Decoding> &decoding)
+    {
+        auto &engine = State::instance().engine;
+        for (auto &job : decoding)
+        {
+            job.decoded.get();
+            job.entry->upload();
+            slots[job.index].lastUse = engine.frameCount;
+            engine.uploader.flush();
+        }
+        decoding.clear();
+    }
+
     // destroys collection
     void destroy()
     {
-        collection.clear();
+        slots.clear();
+        free.clear();
         names.clear();
     }
 
   private:
-    std::vector<T> collection{};
-    // map of names to index
-    std::map<std::string, int32_t> names{};
+    // false and a warning if the scene draws entry
+    static auto drawable(const T *entry) -> bool
+    {
+        if (State::instance().scene.references(entry))
+        {
+            spdlog::warn("{} is drawn by the scene, it can't be unloaded or reloaded from its collection", entry->name);
+            return false;
+        }
+        return true;
+    }
+
+    struct Slot
+    {
+        std::unique_ptr<T> entry{};
+        // bumped when the entry is removed
+        uint32_t generation = 1;
+        // frame the entry was last got
+        uint64_t lastUse = 0;
+    };
+    std::vector<Slot> slots{};
+    // slots of removed entries
+    std::vector<uint32_t> free{};
+    // map of names to slot index
+    std::unordered_map<std::string, uint32_t> names{};
 };
 
-} // namespace tat
\ No newline at end of file
+} // namespace tat
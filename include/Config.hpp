@@ -15,14 +15,44 @@ class Config
   public:
     void create(const std::string &path);
 
+    // config file in the directory of each entry of these collections
+    static constexpr auto backdropFile = "backdrop.json";
+    static constexpr auto materialFile = "material.json";
+    static constexpr auto meshFile = "mesh.json";
+
+    // the config file at path merged over the defaults of collection, as create stores it in state
+    // throws if it can't be read or parsed
+    auto entry(const std::string &collection, const std::string &path) const -> json;
+
   private:
+    // config file of one entry of a collection
+    struct Source
+    {
+        std::string collection;
+        std::string name;
+        std::string path;
+        json parsed;
+    };
+
     static void loadSettings(const std::string &path);
     static void loadPlayer(const std::string &path);
     static void loadScene(const std::string &path);
-    void loadBackdrops(const std::string &path);
-    void loadMaterials(const std::string &path);
-    void loadMeshes(const std::string &path);
-    void loadModels(const std::string &path);
+    // adds the config of every entry under path to sources, file is the config in each entry's directory
+    // or empty when the entries are json files in path itself, everything looked at goes in manifest
+    static void findSources(const std::string &collection, const std::string &path, const std::string &file,
+                            std::vector<Source> &sources, json &manifest);
+    // parses sources in parallel and merges them over the defaults of their collection
+    void loadSources(std::vector<Source> &sources);
+    // parsed merged over the defaults of collection
+    auto merge(const std::string &collection, json &parsed) const -> json;
+
+    // state merged on an earlier start, if nothing in its manifest or the defaults changed since
+    auto loadSnapshot(const std::string &snapshot, const std::string &path) -> bool;
+    void saveSnapshot(const std::string &snapshot, const std::string &path, const json &manifest);
+    // every default below, a snapshot made with others is stale
+    auto defaults() const -> json;
+    // converts the merged json to the typed records in state
+    static void readRecords();
 
     // Default configs
     json settings = {{"zNear", 0.1},                                 //
@@ -32,12 +62,33 @@ class Config
                      {"window", {1024, 768}},                        //
                      {"vsync", true},                                //
                      {"shadowSize", 1024},                           //
+                     {"recordModelsOnThread", false},                //
+                     {"headless", false},                            //
+                     {"headlessFrames", 1000},                       //
+                     {"dumpFrames", json::array()},                  //
+                     {"dumpPath", "logs/"},                          //
+                     {"statsPath", "logs/frames.csv"},               //
+                     {"profiler", true},                             //
+                     {"profilerLog", ""},                            //
+                     {"simulationRate", 60},                         //
+                     {"simulationThread", false},                    //
+                     {"stagingSize", 64},                            // MiB
+                     {"loadThreads", 0},                             // 0 is one per core
+                     {"textureStartSize", 128},                      // pixels, 0 loads every level
+                     {"textureBudget", 256},                         // MiB
+                     {"meshletMinTriangles", 1024},                  //
+                     {"lodPixelError", 1.0},                         //
+                     {"shadowLodBias", 1},                           //
+                     {"hotReload", true},                            // reloads assets when their files change
+                     {"memoryWatermark", 0.9},                       // of the gpu budget, 0 never unloads assets
                      {"brdfPath", "assets/brdf.dds"},                //
                      {"playerConfig", "assets/configs/player.json"}, //
                      {"sceneConfig", "assets/configs/scene.json"},   //
                      {"materialsPath", "assets/materials/"},         //
                      {"meshesPath", "assets/meshes/"},               //
                      {"backdropsPath", "assets/backdrops/"},
+                     {"cachePath", "cache/"},                        // cooked assets, empty turns the cache off
+                     {"configSnapshot", "cache/config.msgpack"},     // merged configs, empty turns it off
                      {"modelsPath", "assets/models/"}}; //
 
     json player = {{"height", 1.7},             //
@@ -60,11 +111,15 @@ class Config
                      {"normal", "normal.dds"},       //
                      {"metallic", "metallic.dds"},   //
                      {"roughness", "roughness.dds"}, //
-                     {"ao", "ao.dds"},
+                     {"ao", "ao.dds"},               //
+                     {"orm", "orm.dds"},             // ao, roughness and metallic packed by TextureCooker
                      {"scale", 1}}; //
 
-    json mesh = {{"file", "default.glb"}, //
-                 {"size", {2, 2, 2}}};    //
+    // vertexLayout is full, packed or auto, auto packs when positions and UVs stay within tolerance
+    json mesh = {{"file", "default.glb"},      //
+                 {"vertexLayout", "auto"},     //
+                 {"positionTolerance", 0.001}, //
+                 {"uvTolerance", 0.001}};      //
 
     json model = {{"mesh", "default"},     //
                   {"material", "default"}, //
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+#include "engine/Buffer.hpp"
+
+#include "Frustum.hpp"
+#include "Model.hpp"
+
+namespace tat
+{
+
+// layouts match cull.comp and meshlet.comp, std430
+struct CullObject
+{
+    glm::mat4 model;
+    glm::vec4 bounds; // model space sphere, xyz center w radius
+    // level of detail each pass draws from the shared index buffer
+    uint32_t colorFirst;
+    uint32_t colorCount;
+    uint32_t shadowFirst;
+    uint32_t shadowCount;
+    // where the model's meshlet indices start in this image's compacted indices
+    uint32_t firstIndex;
+    // drawn from the compacted indices in the color pass
+    uint32_t clustered;
+    // passed the cpu frustum test for the color pass this frame
+    uint32_t visible;
+    // VertexLayout of the mesh, picks the list its draws are appended to
+    uint32_t layout;
+    // first vertex of the mesh in its layout's shared vertex buffer
+    int32_t vertexOffset;
+    std::array<uint32_t, 3> pad;
+};
+
+struct CullFrame
+{
+    std::array<glm::vec4, 6> colorPlanes;
+    std::array<glm::vec4, 6> shadowPlanes;
+    glm::vec4 camera; // world space
+    uint32_t count;
+    uint32_t jobCount;
+    // models in the color then shadow half of the visible buffer
+    uint32_t colorCount;
+    uint32_t shadowCount;
+    // first index of this image's compacted indices in the shared index buffer
+    uint32_t clusterBase;
+    // objects start 16 byte aligned
+    std::array<uint32_t, 3> pad;
+};
+
+// Frustum culls models on the GPU and writes the draws of those it keeps
+// Meshes of the models are moved into one vertex buffer per vertex layout and one index buffer,
+// so the models of a layout are drawn by a single indirect draw per pass however many there are
+// once copied the meshes' own buffers are freed, so each mesh is held on the gpu once
+// Bounds and transforms are written to a storage buffer each frame along with the models the cpu frustum pass
+// kept for each pass, a compute pass tests only those against the camera and light frustums again with their
+// bounding spheres and appends a draw of each survivor to the list of its pass and layout, counting them
+// a draw's first instance is its model's index, the shaders read the model's transform and material with it
+// the count drives the draw with VK_KHR_draw_indirect_count, without it every model the cpu kept is drawn
+// and the list is cleared first so the draws past the survivors draw nothing
+// Models whose mesh has meshlets are culled again per meshlet for the color pass, a second pass tests
+// every meshlet of a visible model against the frustum and its normal cone and appends the survivors'
+// indices to this image's compacted indices at the end of the index buffer, which the model's color draw reads
+// shadows draw those models whole, and meshlets only cover the full detail level
+// so coarser levels of detail are drawn whole as well
+class Culler
+{
+  public:
+    void create(std::vector<Model *> &models);
+    // meshes whose geometry only lived in the shared buffers are unloaded with them
+    void destroy();
+    // rebuilds after meshes were reloaded in place, the others are copied out of the current shared buffers
+    // the device must be idle
+    void reloadMeshes();
+    void reloadPipeline();
+
+    // writes this image's frustums, model transforms, the models each pass keeps and the level of detail it draws
+    void update(uint32_t currentImage, std::vector<glm::mat4> &transforms, const Frustum &colorFrustum,
+                const Frustum &shadowFrustum, glm::vec3 camera, const std::vector<uint32_t> &visibleColor,
+                const std::vector<uint32_t> &visibleShadow, const std::vector<uint32_t> &colorLods,
+                const std::vector<uint32_t> &shadowLods);
+    // records the cull pass, must be outside a render pass and before the draws
+    void dispatch(vk::CommandBuffer commandBuffer, uint32_t currentImage);
+
+    // geometry of every model, bind both before drawing a layout's list
+    auto vertices(uint32_t layout) -> vk::Buffer
+    {
+        return geometry->vertices[layout].buffer;
+    };
+    auto indices() -> vk::Buffer
+    {
+        return geometry->indices.buffer;
+    };
+    // records the draws dispatch wrote for the models of a vertex layout, as of the last update
+    void drawColor(vk::CommandBuffer commandBuffer, uint32_t currentImage, uint32_t layout);
+    void drawShadow(vk::CommandBuffer commandBuffer, uint32_t currentImage, uint32_t layout);
+
+  private:
+    static constexpr uint32_t groupSize = 64;
+    // per dispatch dimension, the minimum every device supports
+    static constexpr uint32_t maxGroups = 65535;
+    // color lists then shadow lists, one per vertex layout
+    // the cull shaders get vertexLayoutCount as a specialization constant and derive the same lists
+    static constexpr uint32_t listCount = 2 * vertexLayoutCount;
+
+    std::vector<Model *> *models = nullptr;
+    uint32_t count = 0;
+    // models in the larger of the two visible lists as of the last update, one invocation each
+    uint32_t visibleCount = 0;
+    // models the cpu kept for each list as of the last update, the most draws it can get
+    std::array<uint32_t, listCount> listSizes{};
+
+    struct ObjectIndices
+    {
+        uint32_t firstIndex = 0;
+        bool meshlets = false;
+        // where the mesh starts in the shared buffers
+        int32_t vertexOffset = 0;
+        uint32_t meshIndex = 0;
+    };
+    std::vector<ObjectIndices> objectIndices{};
+    // one per meshlet of every clustered model, object then meshlet index
+    uint32_t jobCount = 0;
+    uint32_t indexCapacity = 0;
+
+    // where a mesh starts in the shared buffers
+    struct Placement
+    {
+        int32_t vertexOffset = 0;
+        uint32_t firstIndex = 0;
+    };
+    struct Geometry
+    {
+        std::array<Buffer, vertexLayoutCount> vertices{};
+        // indices of every mesh, then compacted indices for each swapchain image
+        Buffer indices{};
+        std::unordered_map<Mesh *, Placement> placed{};
+    };
+    std::unique_ptr<Geometry> geometry{};
+    vk::DeviceSize clusterStart = 0;
+
+    // a region of each per swapchain image, bound with dynamic offsets
+    Buffer objectBuffer{};
+    // the lists, then the counts of the lists and the color draw each model got for meshlet.comp
+    Buffer drawBuffer{};
+    Buffer visibleBuffer{};
+    vk::DeviceSize objectStride = 0;
+    vk::DeviceSize drawStride = 0;
+    vk::DeviceSize slotOffset = 0;
+    vk::DeviceSize indexStride = 0;
+    vk::DeviceSize visibleStride = 0;
+
+    // jobs, meshlets, meshlet vertices then meshlet triangles of every clustered mesh, static
+    Buffer meshletBuffer{};
+    std::array<vk::DeviceSize, 4> meshletOffsets{};
+    std::array<vk::DeviceSize, 4> meshletSizes{};
+
+    vk::DescriptorPool pool = nullptr;
+    vk::DescriptorSetLayout layout = nullptr;
+    vk::DescriptorSet set = nullptr;
+    vk::PipelineLayout pipelineLayout = nullptr;
+    vk::Pipeline pipeline = nullptr;
+    vk::ShaderModule shader = nullptr;
+    vk::Pipeline meshletPipeline = nullptr;
+    vk::ShaderModule meshletShader = nullptr;
+
+    void createMeshlets();
+    // copies each mesh from its own buffers, or from previous when it has none, then frees its own buffers
+    void createGeometry(const Geometry *previous);
+    void createBuffers();
+    void createDescriptors();
+    void createPipeline();
+    // everything but the geometry
+    void destroyPasses();
+    void destroyPipeline();
+    void draw(vk::CommandBuffer commandBuffer, uint32_t currentImage, uint32_t list);
+};
+
+} // namespace tat
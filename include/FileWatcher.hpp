@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <unordered_map>
+#else
+#include <filesystem>
+#include <map>
+#endif
+
+namespace tat
+{
+
+// Reports files written under a set of directories and their subdirectories
+// Uses inotify on linux, elsewhere the directories are scanned for newer write times every scanInterval seconds
+// Paths are the watched directory followed by the path below it with forward slashes
+class FileWatcher
+{
+  public:
+    FileWatcher() = default;
+    ~FileWatcher();
+    FileWatcher(const FileWatcher &) = delete;
+    auto operator=(const FileWatcher &) -> FileWatcher & = delete;
+
+    // directories must end in a slash, ones that don't exist are skipped
+    void create(const std::vector<std::string> &directories);
+    void destroy();
+
+    // files written or moved in since the last call, never blocks
+    auto changes() -> std::vector<std::string>;
+
+  private:
+#ifdef __linux__
+    int descriptor = -1;
+    // directory of each watch
+    std::unordered_map<int, std::string> watches{};
+
+    // adds directory and every directory below it
+    void watch(const std::string &directory);
+#else
+    static constexpr float scanInterval = 1.F;
+    std::vector<std::string> directories{};
+    std::map<std::string, std::filesystem::file_time_type> times{};
+    float lastScan = 0.F;
+
+    // appends files newer than the last scan to changed when given
+    void scan(std::vector<std::string> *changed);
+#endif
+};
+
+} // namespace tat
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+namespace tat
+{
+
+// axis aligned boxes as center and half extent, structure of arrays so several are tested at once
+// storage is padded to a multiple of the simd width, padding is never reported visible
+class Bounds
+{
+  public:
+    // storage is only reallocated when count changes, boxes not set since keep their old values
+    void resize(size_t count);
+    // box around a model space box after transform
+    void set(size_t index, const glm::mat4 &transform, const glm::vec3 &center, const glm::vec3 &extent);
+
+    auto size() const -> size_t
+    {
+        return count;
+    };
+
+  private:
+    friend class Frustum;
+    size_t count = 0;
+    std::vector<float> centerX{};
+    std::vector<float> centerY{};
+    std::vector<float> centerZ{};
+    std::vector<float> extentX{};
+    std::vector<float> extentY{};
+    std::vector<float> extentZ{};
+};
+
+class Frustum
+{
+  public:
+    // planes of a zero to one depth clip space, normalized, pointing inwards
+    std::array<glm::vec4, 6> planes{};
+
+    void extract(const glm::mat4 &viewProjection);
+
+    // replaces visible with the indices of boxes at least partly inside
+    // runs eight boxes at a time with AVX when the cpu has it, four with SSE, one otherwise
+    void cull(const Bounds &bounds, std::vector<uint32_t> &visible) const;
+
+    // widest batch cull handles at once
+    static constexpr size_t width = 8;
+
+  private:
+    // checked once at runtime, builds don't need -mavx
+    static auto hasAvx() -> bool;
+    void cullAvx(const Bounds &bounds, std::vector<uint32_t> &visible) const;
+    void cullSse(const Bounds &bounds, std::vector<uint32_t> &visible) const;
+    void cullScalar(const Bounds &bounds, std::vector<uint32_t> &visible) const;
+};
+
+} // namespace tat
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <set>
+#include <string>
+
+#include "FileWatcher.hpp"
+
+namespace tat
+{
+
+// Reloads assets while running when their files change
+// Files under the materials, meshes and backdrops paths belong to the entry named by their first directory,
+// an edited config of an entry is merged over the defaults again and replaces its record,
+// compiled shaders are matched to the pipelines built from them by file name
+// Changes are gathered until none arrive for settleTime seconds, then applied together between frames
+// with the device idle, so only entries that are loaded and pipelines that use a shader are rebuilt
+// An asset that can't be reloaded warns and keeps what it had
+class HotReload
+{
+  public:
+    void create();
+    void destroy();
+
+    // call once per frame on the main thread before the frame is drawn
+    void update();
+
+  private:
+    // shader paths are written out where their pipelines are created
+    static constexpr auto shadersPath = "assets/shaders/";
+    // editors and compilers may write a file more than once when saving
+    static constexpr float settleTime = 0.25F;
+
+    FileWatcher watcher{};
+    std::set<std::string> pending{};
+    float lastChange = 0.F;
+
+    void apply();
+};
+
+} // namespace tat
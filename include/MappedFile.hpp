@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace tat
+{
+
+// read only memory map of a whole file, unmapped when closed or destroyed
+class MappedFile
+{
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    auto operator=(const MappedFile &) -> MappedFile & = delete;
+
+    // false if the file doesn't exist, is empty or can't be mapped
+    auto open(const std::string &path) -> bool;
+    void close();
+    // starts reading the whole file in the background so later reads don't wait on the disk
+    void prefetch() const;
+
+    auto data() const -> const uint8_t *
+    {
+        return mapped;
+    };
+    auto size() const -> size_t
+    {
+        return length;
+    };
+
+  private:
+    const uint8_t *mapped = nullptr;
+    size_t length = 0;
+#ifdef WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+} // namespace tat
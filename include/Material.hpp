@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
 #include <string>
@@ -8,6 +9,7 @@
 #include "engine/Image.hpp"
 
 #include "Collection.hpp"
+#include "Records.hpp"
 
 namespace tat
 {
@@ -15,19 +17,38 @@ namespace tat
 class Material : public Entry
 {
   public:
+    using Record = MaterialRecord;
+    // config this loads from, set by the collection
+    Record record{};
+
     void load() override;
+    void decode() override;
+    void upload() override;
     virtual ~Material();
+    // reads the files again into new images, the device must be idle
+    // false and a warning if they can't be read, the previous images are kept
+    auto reload() -> bool override;
+    // destroys the images, no frame in flight may use them
+    void unload() override;
+    // levels resident in the images
+    auto residentBytes() -> uint64_t override;
 
     Image diffuse;
     Image normal;
-    Image metallic;
-    Image roughness;
-    Image ao;
+    // ao in red, roughness in green and metallic in blue
+    Image orm;
 
     float scale = 1.F;
 
+    auto images() -> std::array<Image *, 3>
+    {
+        return {&diffuse, &normal, &orm};
+    };
+    // uploads a decoded image from the file's level firstLevel and creates its sampler
+    static void uploadImage(Image *image, uint32_t firstLevel);
+
   private:
-    void loadImage(const std::string &file, Image *image);
+    void decodeImage(const std::string &path, Image *image);
 };
 
 } // namespace tat
\ No newline at end of file
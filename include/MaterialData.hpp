@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tat
+{
+
+// ao, roughness and metallic of a material packed into the red, green and blue of one BC7 texture
+// The three are unrelated, so each block gives whichever of them fits the shared color line worst its own endpoints
+// At a byte per texel the packed map takes a third of the three BC3 sources it replaces
+// Sources may be BC1, BC3 or 8 bit rgba, only their red channel is used
+// Packed by the texture cooker or, when no current one exists, by the material on load
+class MaterialData
+{
+  public:
+    // file name of the packed map next to the sources
+    static constexpr auto ormFile = "orm.dds";
+    // bump whenever packing or encoding changes so cached maps are packed again
+    static constexpr uint32_t version = 3;
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 0;
+    // BC7 blocks of every level, finest first
+    std::vector<uint8_t> blocks{};
+
+    // throws if the sources can't be read or differ in size
+    void pack(const std::string &ao, const std::string &roughness, const std::string &metallic);
+    // writes blocks as a dds file
+    void cook(const std::string &path) const;
+
+    // true if path exists in the packed format and was written after every source
+    static auto current(const std::string &path, const std::vector<std::string> &sources) -> bool;
+};
+
+} // namespace tat
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <memory>
+
 #include "engine/Buffer.hpp"
 #include "engine/Vertex.hpp"
 
 #include "Collection.hpp"
+#include "Records.hpp"
+#include "MappedFile.hpp"
+#include "MeshData.hpp"
 
 
 namespace tat
@@ -12,16 +17,47 @@ namespace tat
 class Mesh : public Entry
 {
   public:
+    using Record = MeshRecord;
+    // config this loads from, set by the collection
+    Record record{};
+
     void load() override;
+    void decode() override;
+    void upload() override;
     virtual ~Mesh() = default;
+    // reads the file again and replaces the buffers, the device must be idle
+    // false and a warning if it can't be read, what was loaded is kept
+    auto reload() -> bool override;
+    // destroys the buffers and drops the levels of detail and meshlets, no frame in flight may use them
+    void unload() override;
+    // vertices and indices, in its own buffers or its share of the scene's shared buffers
+    auto residentBytes() -> uint64_t override;
+    // frees the vertex and index buffers once the scene's copy of them finished
+    void release();
+    // full size of the bounding box, computed from the vertices
     glm::vec3 size{};
+    // bounding box in model space as center and half extent
+    glm::vec3 center{};
+    glm::vec3 extent{};
+    // bounding sphere in model space, xyz center w radius
+    glm::vec4 bounds{};
 
-    struct
-    {
-        std::vector<Vertex> vertices{};
-        std::vector<uint32_t> indices{};
-    } data;
+    // only the gpu keeps the vertices and indices
+    uint32_t vertexCount = 0;
+    // of every level of detail
+    uint32_t indexCount = 0;
+    // ranges of the index buffer, full mesh first then coarser and coarser
+    std::vector<Lod> lods{};
+    VertexLayout layout = VertexLayout::Full;
+    // applied before the model matrix, unpacks positions of packed meshes
+    glm::mat4 dequantize{1.F};
 
+    // clusters culled on the gpu, only kept for meshes with at least meshletMinTriangles
+    std::vector<Meshlet> meshlets{};
+    std::vector<uint32_t> meshletVertices{};
+    std::vector<uint8_t> meshletTriangles{};
+
+    // empty once the scene holds the mesh, a reload fills them until the scene copies them again
     struct
     {
         Buffer vertex{};
@@ -29,7 +65,17 @@ class Mesh : public Entry
     } buffers;
 
   private:
-    void import(const std::string &file);
+    // file read by decode waiting for upload, vertices and indices point into file or data
+    struct Decoded
+    {
+        MappedFile file{};
+        MeshData data{};
+        const void *vertices = nullptr;
+        const void *indices = nullptr;
+    };
+    std::shared_ptr<Decoded> decoded{};
+
+    void createBuffers(const void *vertices, const void *indices);
 };
 
 }; // namespace tat
\ No newline at end of file
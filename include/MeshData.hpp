@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "engine/Vertex.hpp"
+
+#include "MappedFile.hpp"
+#include "MeshOptimizer.hpp"
+
+namespace tat
+{
+
+// range of the shared index buffer drawn for one level of detail
+// error is how far the surface may have moved, relative to the bounding sphere radius
+struct Lod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+};
+
+// layout of a cooked mesh file, streams follow at their offsets aligned for direct upload
+struct CookedMesh
+{
+    static constexpr std::array<char, 4> magicValue = {'T', 'A', 'T', 'M'};
+    // bump whenever the layout or vertex format changes so old files are recooked
+    static constexpr uint32_t currentVersion = 6;
+    static constexpr uint64_t alignment = 16;
+
+    std::array<char, 4> magic = magicValue;
+    uint32_t version = currentVersion;
+    uint32_t vertexStride = sizeof(Vertex);
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    VertexLayout layout = VertexLayout::Full;
+    // source file it was cooked from, stale when either differs
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    // hash of the importSettings it was cooked with, stale when they change
+    uint64_t settingsHash = 0;
+    uint64_t vertexOffset = 0;
+    uint64_t indexOffset = 0;
+    uint32_t meshletCount = 0;
+    uint32_t meshletVertexCount = 0;
+    // bytes, triangles are 8 bit indices
+    uint32_t meshletTriangleSize = 0;
+    uint32_t lodCount = 0;
+    uint64_t meshletOffset = 0;
+    uint64_t meshletVertexOffset = 0;
+    uint64_t meshletTriangleOffset = 0;
+    uint64_t lodOffset = 0;
+    glm::vec4 bounds{};
+    glm::vec3 center{};
+    glm::vec3 extent{};
+};
+
+// cpu side mesh, imported with assimp at runtime or by the cooker
+class MeshData
+{
+  public:
+    // most levels including the full mesh, each has about half the triangles of the last
+    static constexpr size_t maxLods = 5;
+    // meshes this small aren't simplified any further
+    static constexpr size_t minLodTriangles = 64;
+    // most a single level may move the surface, relative to the bounding sphere radius
+    static constexpr float lodMaxError = 0.05F;
+
+    std::vector<Vertex> vertices{};
+    // every level of detail one after another, the full mesh first
+    std::vector<uint32_t> indices{};
+    std::vector<Lod> lods{};
+    // vertices in the packed layout, only filled when selectLayout packed them
+    std::vector<PackedVertex> packed{};
+    VertexLayout layout = VertexLayout::Full;
+
+    std::vector<Meshlet> meshlets{};
+    std::vector<uint32_t> meshletVertices{};
+    std::vector<uint8_t> meshletTriangles{};
+
+    // box as center and half extent, sphere as xyz center w radius, all model space
+    glm::vec3 center{};
+    glm::vec3 extent{};
+    glm::vec4 bounds{};
+
+    // post transform cache efficiency as imported and after optimize
+    CacheStatistics original{};
+    CacheStatistics optimized{};
+
+    // imports, optimizes and builds meshlets and levels of detail
+    void import(const std::string &path);
+    void computeBounds();
+    // appends simplified levels to indices, meshlets only cover the full mesh so build them first
+    void buildLods();
+    // reorders triangles for the vertex cache then overdraw, and vertices for fetch locality
+    void optimize();
+    // requested is "full", "packed" or "auto", auto packs only if every position and UV
+    // stays within its tolerance of the original, call after import
+    void selectLayout(const std::string &requested, float positionTolerance, float uvTolerance);
+    // vertices in the selected layout
+    auto vertexData() const -> const void *;
+    // writes a cooked file for source imported with settings to path
+    void cook(const std::string &source, const std::string &settings, const std::string &path);
+
+    // where the cooked file shipped with source lives
+    static auto cookedPath(const std::string &source) -> std::string;
+    // everything besides the source and version that changes what import and selectLayout produce
+    static auto importSettings(const std::string &requested, float positionTolerance, float uvTolerance)
+        -> std::string;
+    // header of file if it is a cooked mesh of the current version matching source and the import settings
+    // otherwise nullptr, an empty source skips checking it is current for cache entries keyed by its bytes
+    static auto cooked(const MappedFile &file, const std::string &source, const std::string &settings)
+        -> const CookedMesh *;
+    // maps packed positions from the snorm box back to model space
+    static auto dequantize(const glm::vec3 &center, const glm::vec3 &extent) -> glm::mat4;
+};
+
+} // namespace tat
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "engine/Vertex.hpp"
+
+namespace tat
+{
+
+// post transform cache efficiency of an index buffer, lower is better for both
+// acmr is vertex shader runs per triangle, from 3 down to about 0.5 for a regular grid
+// atvr is vertex shader runs per unique vertex, 1 is perfect
+struct CacheStatistics
+{
+    float acmr = 0.F;
+    float atvr = 0.F;
+};
+
+// cluster of at most maxMeshletVertices vertices and maxMeshletTriangles triangles, layout matches meshlet.comp
+// triangles are 8 bit indices into the meshlet's vertices, which index the mesh's vertices
+struct Meshlet
+{
+    glm::vec4 bounds; // model space sphere, xyz center w radius
+    glm::vec4 cone;   // xyz normal axis, w cutoff, every triangle faces away from views inside the cone
+    uint32_t vertexOffset;
+    uint32_t triangleOffset; // in bytes, 4 byte aligned
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
+
+// Offline triangle and vertex reordering for indexed triangle lists, run at import
+// Passes are meant to run in order: cache, overdraw then fetch
+class MeshOptimizer
+{
+  public:
+    // fifo size used when measuring, close to what current hardware keeps
+    static constexpr uint32_t fifoSize = 16;
+    // lru size the cache pass scores against
+    static constexpr uint32_t cacheSize = 32;
+    // limits commonly used for mesh shaders, triangles fit 8 bit local indices
+    static constexpr uint32_t maxMeshletVertices = 64;
+    static constexpr uint32_t maxMeshletTriangles = 124;
+
+    // simulates a fifo cache of fifoSize
+    static auto analyze(const std::vector<uint32_t> &indices, size_t vertexCount) -> CacheStatistics;
+
+    // reorders triangles for post transform cache hits, Forsyth's linear speed algorithm
+    static void optimizeCache(std::vector<uint32_t> &indices, size_t vertexCount);
+
+    // splits the cache ordered triangles into clusters at cache flushes and draws outward facing clusters first
+    // the new order is kept only if acmr stays within threshold of the cache ordered one
+    static void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices,
+                                 float threshold = 1.05F);
+
+    // renumbers vertices in order of first use and drops unreferenced ones
+    static void optimizeFetch(std::vector<uint32_t> &indices, std::vector<Vertex> &vertices);
+
+    // fewer triangles drawing the same vertices, quadric error metric edge collapses onto existing vertices
+    // stops at targetIndexCount or when the next collapse would move the surface more than maxError
+    // vertices on borders and attribute seams never move, error is set to the largest collapse made
+    static auto simplify(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices,
+                         size_t targetIndexCount, float maxError, float &error) -> std::vector<uint32_t>;
+
+    // splits triangles into meshlets in index order, so run after the other passes
+    static void buildMeshlets(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices,
+                              std::vector<Meshlet> &meshlets, std::vector<uint32_t> &meshletVertices,
+                              std::vector<uint8_t> &meshletTriangles);
+};
+
+} // namespace tat
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <memory>
 
 #include "engine/Buffer.hpp"
 #include "engine/Image.hpp"
 
 #include "Collection.hpp"
+#include "Records.hpp"
 #include "Material.hpp"
 #include "Mesh.hpp"
 #include "Object.hpp"
@@ -16,13 +18,10 @@ namespace tat
 
 struct UniformVert
 {
-    glm::mat4 model;
     glm::mat4 view;
     glm::mat4 projection;
-    glm::mat4 lightMVP;
-    glm::mat4 normalMatrix;
+    glm::mat4 lightViewProjection;
     glm::vec4 camPos;
-    float uvScale;
 };
 struct UniformFrag
 {
@@ -34,36 +33,50 @@ struct UniformFrag
 
 struct UniformShad
 {
-    glm::mat4 model;
     glm::mat4 view;
     glm::mat4 projection;
 };
 
+// per model, an array of these is read from a storage buffer with the draw's first instance, std430
+struct ModelInstance
+{
+    glm::mat4 model;
+    glm::mat4 normalMatrix;
+    float uvScale;
+    // index into the scene's material textures
+    uint32_t material;
+    std::array<uint32_t, 2> pad;
+};
+
 class Model : public Object, public Entry
 {
   public:
+    using Record = ModelRecord;
+    // config this loads from, set by the collection
+    Record record{};
+
     void load() override;
+    // back to a default object so the next load places it from its record again
+    void unload() override;
 
     virtual ~Model() = default;
 
     Image *irradianceMap;
     Image *radianceMap;
 
-    std::vector<vk::DescriptorSet> colorSets;
-    std::vector<Buffer> vertBuffers;
-    std::vector<Buffer> fragBuffers;
-    std::vector<vk::DescriptorSet> shadowSets;
-    std::vector<Buffer> shadBuffers;
-
-    void createColorSets(vk::DescriptorPool pool, vk::DescriptorSetLayout layout);
-    void createShadowSets(vk::DescriptorPool pool, vk::DescriptorSetLayout layout);
-    void createUniformBuffers();
+    // size follows the mesh's again after it was reloaded, hold the simulation lock
+    void updateSize();
 
     inline auto getMesh() -> Mesh *
     {
         return mesh;
     };
 
+    inline auto getMaterial() -> Material *
+    {
+        return material;
+    };
+
     inline auto uvScale() -> float
     {
         return material->scale;
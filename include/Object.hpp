@@ -19,6 +19,12 @@ class Object
         return m_position;
     };
 
+    // position between the last two updates, alpha in [0, 1]
+    auto position(float alpha) -> glm::vec3
+    {
+        return glm::mix(m_lastPosition, m_position, alpha);
+    };
+
     auto rotation() -> glm::vec3
     {
         return m_rotation;
@@ -34,6 +40,11 @@ class Object
         return M;
     };
 
+    // model matrix between the last two updates, alpha in [0, 1]
+    auto model(float alpha) -> glm::mat4;
+    // nothing to interpolate until the next update
+    void settle();
+
     auto view() -> glm::mat4
     {
         return V;
@@ -65,6 +76,7 @@ class Object
     glm::mat4 S; // scale matrix
 
     glm::vec3 m_position = glm::vec3(0.F);
+    glm::vec3 m_lastPosition = glm::vec3(0.F); // position before the last update
     glm::vec3 m_rotation = glm::vec3(0.F);
     glm::vec3 m_scale = glm::vec3(1.F);
     glm::vec3 m_size = glm::vec3(0.F);
@@ -11,7 +11,8 @@ class Player : public Object
     void create();
     static void destroy();
 
-    void move(glm::vec2 direction, float deltaTime);
+    // camera rotation is passed in so this can run off the main thread
+    void move(glm::vec2 direction, glm::vec3 rotation, float deltaTime);
     void jump();
 
     auto height() -> float
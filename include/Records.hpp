@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace tat
+{
+
+// Typed mirrors of the records in state json
+// json is still what configs and snapshots are read from and written to, Config converts it once
+// after merging, then everything reads members instead of walking the tree by key
+// members are named after their json key, from_json expects every key so defaults stay in Config
+
+struct SettingsRecord
+{
+    float zNear = 0.F;
+    float zFar = 0.F;
+    float FoV = 0.F;
+    float mouseSensitivity = 0.F;
+    std::array<int32_t, 2> window{};
+    bool vsync = false;
+    uint32_t shadowSize = 0;
+    bool recordModelsOnThread = false;
+    bool headless = false;
+    int32_t headlessFrames = 0;
+    std::vector<int32_t> dumpFrames{};
+    std::string dumpPath{};
+    std::string statsPath{};
+    bool profiler = false;
+    std::string profilerLog{};
+    float simulationRate = 0.F;
+    bool simulationThread = false;
+    uint64_t stagingSize = 0;
+    size_t loadThreads = 0;
+    uint32_t textureStartSize = 0;
+    uint64_t textureBudget = 0;
+    uint32_t meshletMinTriangles = 0;
+    float lodPixelError = 0.F;
+    uint32_t shadowLodBias = 0;
+    bool hotReload = false;
+    float memoryWatermark = 0.F;
+    std::string brdfPath{};
+    std::string playerConfig{};
+    std::string sceneConfig{};
+    std::string materialsPath{};
+    std::string meshesPath{};
+    std::string backdropsPath{};
+    std::string cachePath{};
+    std::string configSnapshot{};
+    std::string modelsPath{};
+};
+
+struct PlayerRecord
+{
+    float height = 0.F;
+    float mass = 0.F;
+    float velocityMax = 0.F;
+    float timeToReachVMax = 0.F;
+    float timeToStopFromVMax = 0.F;
+    float jumpHeight = 0.F;
+};
+
+struct SceneRecord
+{
+    std::string backdrop{};
+    std::vector<std::string> models{};
+};
+
+struct BackdropRecord
+{
+    std::string color{};
+    std::string radiance{};
+    std::string irradiance{};
+    glm::vec3 light{};
+    float brightness = 0.F;
+};
+
+struct MaterialRecord
+{
+    std::string diffuse{};
+    std::string normal{};
+    std::string metallic{};
+    std::string roughness{};
+    std::string ao{};
+    std::string orm{};
+    float scale = 0.F;
+};
+
+struct MeshRecord
+{
+    std::string file{};
+    std::string vertexLayout{};
+    float positionTolerance = 0.F;
+    float uvTolerance = 0.F;
+};
+
+struct ModelRecord
+{
+    std::string mesh{};
+    std::string material{};
+    float mass = 0.F;
+    glm::vec3 position{};
+    glm::vec3 rotation{};
+    glm::vec3 scale{};
+};
+
+void from_json(const json &j, SettingsRecord &settings);
+void to_json(json &j, const SettingsRecord &settings);
+void from_json(const json &j, PlayerRecord &player);
+void to_json(json &j, const PlayerRecord &player);
+void from_json(const json &j, SceneRecord &scene);
+void to_json(json &j, const SceneRecord &scene);
+void from_json(const json &j, BackdropRecord &backdrop);
+void to_json(json &j, const BackdropRecord &backdrop);
+void from_json(const json &j, MaterialRecord &material);
+void to_json(json &j, const MaterialRecord &material);
+void from_json(const json &j, MeshRecord &mesh);
+void to_json(json &j, const MeshRecord &mesh);
+void from_json(const json &j, ModelRecord &model);
+void to_json(json &j, const ModelRecord &model);
+
+} // namespace tat
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace tat
+{
+
+// Unloads materials, meshes and backdrops the scene doesn't use when gpu memory runs low
+// Each frame device local usage is checked against the allocator's budget, once it passes memoryWatermark of it
+// the least recently used entries nothing in the scene references are unloaded, oldest first,
+// until the memory they held covers the excess
+// Only entries no frame in flight can have used are unloaded, the next get loads them again
+class Residency
+{
+  public:
+    void create();
+
+    // call once per frame on the main thread before the frame is drawn
+    void update();
+
+  private:
+    // fraction of the budget, 0 turns unloading off
+    float watermark = 0.F;
+    // set once the excess couldn't be covered so the warning isn't repeated every frame
+    bool warned = false;
+};
+
+} // namespace tat
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <vector>
 #include <string>
+#include <unordered_set>
 
 #ifdef WIN32
 #define NOMINMAX
@@ -14,9 +17,12 @@
 
 #include "engine/Image.hpp"
 #include "engine/Pipeline.hpp"
+#include "engine/UniformArena.hpp"
 
 #include "Backdrop.hpp"
+#include "Culler.hpp"
 #include "Model.hpp"
+#include "TextureStreamer.hpp"
 
 namespace tat
 {
@@ -28,6 +34,8 @@ class Scene
     Image shadow{};
     Image brdf{};
     Backdrop *backdrop = nullptr;
+    // per frame model uniforms
+    UniformArena uniforms{};
 
     float shadowSize = 1024.F;
 
@@ -35,35 +43,114 @@ class Scene
     void create();
     void cleanup();
     void recreate();
+    // draws the models the cull pass kept, one indirect draw per vertex layout whatever the number of models
+    // backdrop is drawn separately
     void drawColor(vk::CommandBuffer commandBuffer, uint32_t currentImage);
     void drawShadow(vk::CommandBuffer commandBuffer, uint32_t currentImage);
-    void update(uint32_t currentImage, float deltaTime);
+    // models inside the camera and light frustums as of the last update
+    auto colorCount() -> size_t
+    {
+        return visibleColor.size();
+    };
+    auto shadowCount() -> size_t
+    {
+        return visibleShadow.size();
+    };
+    // culls models on the gpu, recorded before the shadow pass
+    void cull(vk::CommandBuffer commandBuffer, uint32_t currentImage);
+    // advances model physics by one simulation step
+    void step(float deltaTime);
+    // writes interpolated transforms into this image's uniforms
+    void update(uint32_t currentImage);
+
+    // reload assets in place and rebuild only the descriptor sets and pipelines made from them
+    // called between frames while the device is idle
+    void reloadMaterial(Material *material);
+    void reloadMeshes(const std::vector<Mesh *> &meshes);
+    void reloadBackdrop();
+    void reloadPipelines(bool color, bool shadow, bool cull);
+
+    // backdrop, models and their materials and meshes, none of which may be unloaded
+    auto referenced() -> std::unordered_set<const Entry *>;
+    // whether entry is one of those
+    auto references(const Entry *entry) -> bool;
 
   private:
-    Pipeline colorPipeline;
-    Pipeline shadowPipeline;
+    // indexed by VertexLayout
+    std::array<Pipeline, vertexLayoutCount> colorPipelines{};
+    std::array<Pipeline, vertexLayoutCount> shadowPipelines{};
 
     vk::DescriptorPool colorPool = nullptr;
     vk::DescriptorSetLayout colorLayout = nullptr;
     vk::DescriptorPool shadowPool = nullptr;
     vk::DescriptorSetLayout shadowLayout = nullptr;
 
+    // every model is drawn with one set per pass, uniforms live in the arena and are bound with dynamic offsets
+    // so one set of each serves every swapchain image
+    vk::DescriptorSet colorSet = nullptr;
+    // rewritten while the bound one may still be in use when streamed textures are swapped in
+    vk::DescriptorSet spareColorSet = nullptr;
+    vk::DescriptorSet shadowSet = nullptr;
+
     UniformVert vertBuffer{};
     UniformFrag fragBuffer{};
     UniformShad shadBuffer{};
+    std::vector<ModelInstance> instances{};
+
+    // dynamic offsets of the uniforms and model instances written by the last update
+    uint32_t vertOffset = 0;
+    uint32_t fragOffset = 0;
+    uint32_t shadOffset = 0;
+    uint32_t instanceOffset = 0;
 
     std::vector<Model *> models{};
+    // materials of the models once each, the shaders index their textures with materialIndices
+    std::vector<Material *> materials{};
+    std::vector<uint32_t> materialIndices{};
+    // size of the texture arrays, which can't be empty
+    auto materialCount() -> uint32_t
+    {
+        return std::max<uint32_t>(1, static_cast<uint32_t>(materials.size()));
+    };
+    Culler culler{};
+    // world space boxes of every model, culled on the cpu so only visible models are recorded
+    Bounds bounds{};
+    Frustum colorFrustum{};
+    Frustum shadowFrustum{};
+    std::vector<uint32_t> visibleColor{};
+    std::vector<uint32_t> visibleShadow{};
+    // interpolated model matrices for the frame being drawn
+    std::vector<glm::mat4> transforms{};
+    // level of detail of each model for each pass, index into its mesh's lods
+    std::vector<uint32_t> colorLods{};
+    std::vector<uint32_t> shadowLods{};
+    // screen pixels a level's error may cover before a finer level is drawn
+    float lodPixelError = 1.F;
+    // levels coarser than the color pass that shadows draw
+    uint32_t shadowLodBias = 1;
+    // width on screen in pixels of each visible model, 0 for the rest
+    std::vector<float> screenSizes{};
+    TextureStreamer streamer{};
 
     void createBrdf();
     void createShadow();
 
     void loadModels();
+    void createUniforms();
+    // picks levels of detail and screen sizes from the projected size of the last update's transforms
+    void selectLods();
     void loadBackdrop();
 
     void createColorPool();
     void createColorLayouts();
     void createColorPipeline();
     void createColorSets();
+    // points the spare color set at the materials' current images and binds it from now on
+    // the spare must not have been bound for Engine::maxFramesInFlight frames
+    void swapColorSets();
+    // rewrites both color sets, only while the device is idle
+    void updateColorSets();
+    void writeColorSet(vk::DescriptorSet set);
 
     void createShadowPool();
     void createShadowLayouts();
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+namespace tat
+{
+
+// Steps player and scene physics at a fixed rate independent of the frame rate
+// Rendering interpolates between the last two steps using alpha
+// Steps either run on the main thread from update or on their own thread
+class Simulation
+{
+  public:
+    void create();
+    void destroy();
+
+    // advances simulation time, steps are only run here when not threaded
+    void update(float frameTime);
+
+    // input for the next step, latched by the main thread
+    void setInput(glm::vec2 direction, glm::vec3 rotation, bool jump);
+
+    // hold while reading anything the simulation writes
+    auto lock() -> std::unique_lock<std::mutex>
+    {
+        return std::unique_lock<std::mutex>(mutex);
+    };
+
+    // fraction of a step since the last one, only valid while locked
+    auto alpha() -> float;
+
+  private:
+    float step = 1.F / 60.F;
+    // most steps caught up at once, anything past this is dropped so a long frame can't spiral
+    int32_t maxSteps = 5;
+    float accumulator = 0.F;
+    float lastStep = 0.F;
+
+    bool threaded = false;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::mutex mutex;
+
+    struct
+    {
+        glm::vec2 direction = glm::vec2(0.F);
+        glm::vec3 rotation = glm::vec3(0.F);
+        bool jump = false;
+    } input;
+
+    void stepOnce();
+    void run();
+};
+
+} // namespace tat
@@ -15,10 +15,15 @@ using json = nlohmann::json;
 
 #include "overlay/Overlay.hpp"
 
+#include "AssetCache.hpp"
 #include "Camera.hpp"
 #include "Collection.hpp"
+#include "HotReload.hpp"
 #include "Player.hpp"
+#include "Records.hpp"
+#include "Residency.hpp"
 #include "Scene.hpp"
+#include "Simulation.hpp"
 
 
 namespace tat
@@ -53,6 +58,14 @@ class State : public json
     Player player{};
     Overlay overlay{};
     Scene scene{};
+    Simulation simulation{};
+    AssetCache cache{};
+    HotReload hotReload{};
+    Residency residency{};
+    // typed copies of the settings, player and scene json, filled by Config
+    SettingsRecord settings{};
+    PlayerRecord playerRecord{};
+    SceneRecord sceneRecord{};
     Collection<Backdrop> backdrops{};
     Collection<Material> materials{};
     Collection<Mesh> meshes{};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <vector>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "engine/Image.hpp"
+
+#include "Model.hpp"
+#include "ThreadPool.hpp"
+
+namespace tat
+{
+
+// Streams mip levels of material textures in and out after startup
+// Materials start with only their coarse levels resident (textureStartSize), each frame the level
+// every texture needs is estimated from the screen size of the models using it
+// Textures are re read on a worker and uploaded on the main thread into a new image holding the needed levels,
+// the new images are swapped into their materials together and the old ones destroyed once no frame uses them,
+// the scene then points its spare descriptor set at them
+// Textures finer than needed are coarsened when a finer level wouldn't fit in textureBudget, by copying the levels
+// still needed out of the resident image on the gpu, at most maxJobs of them a frame
+class TextureStreamer
+{
+  public:
+    void create(const std::vector<Model *> &models);
+    void destroy();
+
+    // pixels[i] is how wide model i is on screen, 0 when it is not visible
+    // call once per frame on the main thread after the frame's fence has been waited on
+    // true when images were swapped into materials, descriptor sets sampling them must be rewritten
+    // before the frame is recorded
+    auto update(const std::vector<float> &pixels) -> bool;
+    // cancels jobs of the material's textures and stops counting them before its images are replaced
+    // attach counts the new images, their current levels become the coarsest kept, the device must be idle
+    void detach(Material *material);
+    void attach(Material *material);
+
+  private:
+    struct Texture
+    {
+        Image *image = nullptr;
+        // index of every model drawing this texture
+        std::vector<size_t> models{};
+        // level kept when no model using it is visible
+        uint32_t coarsest = 0;
+        // finest level a visible model needs this frame
+        uint32_t wanted = 0;
+        bool busy = false;
+    };
+
+    struct Job
+    {
+        size_t texture = 0;
+        uint32_t level = 0;
+        std::unique_ptr<Image> image{};
+        std::future<void> decoded{};
+    };
+
+    std::vector<Model *> models{};
+    std::vector<Texture> textures{};
+    // decoding on the pool
+    std::vector<Job> decoding{};
+    // uploaded and waiting for the next swap
+    std::vector<Job> uploaded{};
+    // replaced images and the frame after which nothing uses them
+    std::vector<Image> retired{};
+    uint64_t retireFrame = 0;
+    uint64_t frame = 0;
+
+    ThreadPool pool{};
+    // jobs in flight at once, bounds the memory files being decoded take, and textures coarsened a frame
+    size_t maxJobs = 4;
+    // bytes textures take once every job so far has been swapped in
+    vk::DeviceSize resident = 0;
+    vk::DeviceSize budget = 0;
+
+    // finest level a model pixels wide on screen samples from texture
+    static auto levelFor(const Texture &texture, Model &model, float pixels) -> uint32_t;
+    // job replacing the texture with one holding its levels from level on, counted as resident from now
+    auto prepare(size_t index, uint32_t level) -> Job;
+    void schedule(size_t index, uint32_t level);
+    // copies the levels needed of the texture most finer than needed, false if none is
+    auto evict() -> bool;
+    void finish();
+    void swap();
+};
+
+} // namespace tat
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace tat
+{
+
+// Fixed size pool of worker threads
+// jobs run in the order they were submitted on whichever worker is free
+// submit returns a future that becomes ready when the job has run
+// exceptions thrown by a job are rethrown by the future's get()
+class ThreadPool
+{
+  public:
+    ThreadPool() = default;
+    ThreadPool(ThreadPool const &) = delete;
+    void operator=(ThreadPool const &) = delete;
+
+    ~ThreadPool()
+    {
+        destroy();
+    };
+
+    // starts count worker threads
+    void create(size_t count)
+    {
+        destroy();
+        stopping = false;
+        for (size_t i = 0; i < count; ++i)
+        {
+            workers.emplace_back([this]() { work(); });
+        }
+    };
+
+    // finishes queued jobs then joins workers
+    void destroy()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        workers.clear();
+    };
+
+    auto size() -> size_t
+    {
+        return workers.size();
+    };
+
+    template <typename F> auto submit(F &&job) -> std::future<void>
+    {
+        std::packaged_task<void()> task(std::forward<F>(job));
+        auto future = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push(std::move(task));
+        }
+        condition.notify_one();
+        return future;
+    };
+
+  private:
+    std::vector<std::thread> workers{};
+    std::queue<std::packaged_task<void()>> jobs{};
+    std::mutex mutex{};
+    std::condition_variable condition{};
+    bool stopping = false;
+
+    void work()
+    {
+        while (true)
+        {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (jobs.empty())
+                { // only empty here if stopping
+                    return;
+                }
+                task = std::move(jobs.front());
+                jobs.pop();
+            }
+            task();
+        }
+    };
+};
+
+} // namespace tat
@@ -9,14 +9,19 @@ namespace tat
 class VulkansEye
 {
   public:
-    explicit VulkansEye(const std::string &configPath);
+    // headlessFrames > 0 overrides the headless settings
+    explicit VulkansEye(const std::string &configPath, int32_t headlessFrames = 0);
     ~VulkansEye() = default;
     static void run();
     static void cleanup();
 
   private:
+    void createWindow(int width, int height);
+    static void runHeadless();
+    static void writeStats(std::vector<float> &frameTimes, float totalTime);
 
-    static void handleInput(float deltaTime);
+    static void updateCamera();
+    static void handleInput();
 
     static void switchToNormalMode();
     static void switchToVisualMode();
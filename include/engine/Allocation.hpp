@@ -28,6 +28,7 @@ class Allocation
     auto map() -> void *;
     void unmap();
     void flush(size_t size = VK_WHOLE_SIZE, size_t offset = 0);
+    void invalidate(size_t size = VK_WHOLE_SIZE, size_t offset = 0);
 
     auto isImage() -> bool
     {
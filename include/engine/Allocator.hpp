@@ -22,7 +22,8 @@ using HandleCreateInfo = std::variant<vk::ImageCreateInfo, vk::BufferCreateInfo>
 class Allocator
 {
   public:
-    void create(vk::PhysicalDevice physicalDevice, vk::Device device);
+    // memoryBudget when the device was created with VK_EXT_memory_budget
+    void create(vk::Instance instance, vk::PhysicalDevice physicalDevice, vk::Device device, bool memoryBudget);
     // destroys allocations, will free all memory held by allocations
     // even if buffer or image has not been destroyed
     void destroy();
@@ -34,6 +35,17 @@ class Allocator
     // destroys allocation
     void destroy(Allocation *allocation);
 
+    // bytes of device local memory in use and available to this process
+    // reported by the driver with VK_EXT_memory_budget, otherwise vma's own allocations against most of each heap
+    struct Budget
+    {
+        vk::DeviceSize usage = 0;
+        vk::DeviceSize budget = 0;
+    };
+    auto budget() -> Budget;
+    // vma fetches the budget again when the frame index changes, call once per frame
+    void setFrame(uint64_t frame);
+
   private:
     VmaAllocator allocator{};
     int32_t accumulator = 1;
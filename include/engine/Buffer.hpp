@@ -38,13 +38,14 @@ class Buffer
     // updates buffer to contents
     void update(void *t, size_t s);
 
-    void copyTo(Buffer &destination);
     auto getSize() -> vk::DeviceSize
     {
         return size;
     };
 
     void flush(size_t size = VK_WHOLE_SIZE, vk::DeviceSize offset = 0);
+    // makes device writes visible to mapped memory
+    void invalidate(size_t size = VK_WHOLE_SIZE, vk::DeviceSize offset = 0);
 
   private:
     Allocation *allocation = nullptr;
@@ -21,10 +21,15 @@ class Device
 
     auto wait(vk::Fence &fence) -> vk::Result;
     auto reset(vk::Fence &fence) -> vk::Result;
+    // true once fence is signaled, doesn't block
+    auto ready(vk::Fence &fence) -> bool;
+    void reset(vk::CommandPool &pool);
     auto acquireNextImage(vk::SwapchainKHR &swapChain, vk::Semaphore &semaphore, uint32_t &currentBuffer) -> vk::Result;
 
     void update(std::vector<vk::WriteDescriptorSet> &descriptorWrites);
     auto getSwapchainImages(const vk::SwapchainKHR &swapChain) -> std::vector<vk::Image>;
+    auto getResults(vk::QueryPool pool, uint32_t first, uint32_t count, std::vector<uint64_t> &data,
+                    vk::DeviceSize stride, vk::QueryResultFlags flags) -> vk::Result;
 
     auto create(const vk::CommandBufferAllocateInfo &allocInfo) -> std::vector<vk::CommandBuffer>;
     auto create(const vk::DescriptorSetAllocateInfo &allocInfo) -> std::vector<vk::DescriptorSet>;
@@ -39,9 +44,11 @@ class Device
     auto create(const vk::FenceCreateInfo &createInfo) -> vk::Fence;
     auto create(const vk::PipelineLayoutCreateInfo &createInfo) -> vk::PipelineLayout;
     auto create(const vk::GraphicsPipelineCreateInfo &createInfo, vk::PipelineCache cache = nullptr) -> vk::Pipeline;
+    auto create(const vk::ComputePipelineCreateInfo &createInfo, vk::PipelineCache cache = nullptr) -> vk::Pipeline;
     auto create(const vk::PipelineCacheCreateInfo &createInfo) -> vk::PipelineCache;
     auto create(const vk::RenderPassCreateInfo &createInfo) -> vk::RenderPass;
     auto create(const vk::SemaphoreCreateInfo &createInfo) -> vk::Semaphore;
+    auto create(const vk::QueryPoolCreateInfo &createInfo) -> vk::QueryPool;
 
     void destroy(vk::CommandPool pool, std::vector<vk::CommandBuffer> &commandBuffers);
     void destroy(vk::CommandPool pool, vk::CommandBuffer commandBuffer);
@@ -54,6 +61,8 @@ class Device
     vk::Device device = nullptr;
     vk::Queue graphicsQueue;
     vk::Queue presentQueue;
+    // same as graphicsQueue when there is no dedicated transfer family
+    vk::Queue transferQueue;
 
   private:
 };
@@ -17,11 +17,15 @@
 #include "engine/Image.hpp"
 #include "engine/PhysicalDevice.hpp"
 #include "engine/PipelineCache.hpp"
+#include "engine/Profiler.hpp"
 #include "engine/RenderPass.hpp"
 #include "engine/Semaphore.hpp"
 #include "engine/SwapChain.hpp"
+#include "engine/Uploader.hpp"
 #include "engine/Window.hpp"
 
+#include "ThreadPool.hpp"
+
 namespace tat
 {
 
@@ -31,11 +35,14 @@ class Engine
     void create();
     void prepare();
     void destroy();
-    void drawFrame(float deltaTime);
+    void drawFrame();
     void resize(int width, int height);
+    // writes the last drawn frame to a ppm file, only valid when headless
+    void capture(const std::string &path);
 
     bool showOverlay = false;
-    bool updateCommandBuffer = false;
+    // render into offscreen images without a window, surface or present
+    bool headless = false;
 
     vk::Instance instance;
     vk::SurfaceKHR surface;
@@ -44,43 +51,73 @@ class Engine
     Debug debug;
 
     Allocator allocator{};
+    Uploader uploader{};
 
     SwapChain swapChain;
 
     PipelineCache pipelineCache;
     RenderPass colorPass;
     RenderPass shadowPass;
+    Profiler profiler;
 
     vk::PresentModeKHR defaultPresentMode = vk::PresentModeKHR::eMailbox;
 
-    auto beginSingleTimeCommands() -> vk::CommandBuffer;
-    void endSingleTimeCommands(vk::CommandBuffer commandBuffer);
+    // anything last used by a frame this many frames ago has finished on the gpu
+    static constexpr int maxFramesInFlight = 2;
+    // frames submitted so far
+    uint64_t frameCount = 0;
 
     auto createShaderModule(const std::string &filename) -> vk::ShaderModule;
     auto findDepthFormat() -> vk::Format;
 
   private:
-    static constexpr int maxFramesInFlight = 2;
-
     std::vector<Framebuffer> shadowFramebuffers{};
     Image shadowDepth;
     std::vector<Framebuffer> colorFramebuffers{};
     Image colorAttachment;
     Image depthAttachment;
 
+    // one pool and primary buffer per frame in flight
+    // the pool is reset and the buffer re-recorded each time its frame comes around
+    std::vector<vk::CommandPool> framePools{};
     std::vector<vk::CommandBuffer> commandBuffers{};
 
+    // models are recorded on their own thread when recordModelsOnThread is set
+    // the recorder owns a pool per frame in flight so the threads never share a pool
+    struct Recorder
+    {
+        std::vector<vk::CommandPool> pools{};
+        std::vector<vk::CommandBuffer> shadowBuffers{};
+        std::vector<vk::CommandBuffer> colorBuffers{};
+    };
+    bool recordModelsOnThread = false;
+    Recorder recorder{};
+    ThreadPool recordThread{};
+    // secondary buffers recorded on the main thread while the recorder runs
+    std::vector<vk::CommandBuffer> backdropBuffers{};
+    std::vector<vk::CommandBuffer> overlayBuffers{};
+
     std::vector<Semaphore> presentSemaphores{};
     std::vector<Semaphore> renderSemaphores{};
     std::vector<Fence> waitFences{};
+    // fence of the frame last rendered into each swapchain image, not owned
+    std::vector<vk::Fence> imageFences{};
 
-    vk::CommandPool commandPool;
-
-    int32_t currentImage = 0;
+    int32_t currentFrame = 0;
+    // image drawn by the last frame, offscreen images are used round robin
+    uint32_t lastBuffer = 0;
     bool prepared = false;
 
     void createCommandBuffers();
-    void updateCommandBuffers();
+    void createRecorder();
+    void recordCommandBuffer(uint32_t currentBuffer);
+    void recordModels(uint32_t currentBuffer);
+    void recordSecondaries(uint32_t currentBuffer);
+
+    void setShadowViewport(vk::CommandBuffer commandBuffer);
+    void setColorViewport(vk::CommandBuffer commandBuffer);
+    static void beginSecondary(vk::CommandBuffer commandBuffer, vk::RenderPass renderPass,
+                               vk::Framebuffer framebuffer);
 
     void renderShadows(vk::CommandBuffer commandBuffer, int32_t currentImage);
     void renderColors(vk::CommandBuffer commandBuffer, int32_t currentImage);
@@ -88,7 +125,6 @@ class Engine
     void createInstance();
     void createColorFramebuffers();
     void createShadowFramebuffers();
-    void createCommandPool();
     void createPipelineCache();
 
     static auto chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR> &availableFormats)
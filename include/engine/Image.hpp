@@ -11,6 +11,11 @@
 
 #include "engine/Buffer.hpp"
 #include "engine/Allocator.hpp"
+#include "engine/TextureFile.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace tat
 {
@@ -37,7 +42,31 @@ class Image
     void destroy();
 
     // load info into image
-    void load(const std::string &path); // use gli to load dds/ktx supports cubemaps
+    void load(const std::string &path); // maps dds/ktx, supports cubemaps
+    // load split in two, decode only reads the file and is safe on any thread
+    // upload creates the image from the decoded file on the main thread
+    // levels finer than firstLevel are left out so the image starts at the file's level firstLevel
+    void decode(const std::string &path);
+    void upload(uint32_t firstLevel = 0);
+    // creates the image from source's levels from the file's level firstLevel on without reading the file again
+    // the copy is recorded on the uploader's graphics commands and runs with the next flush, source is left readable
+    void copy(Image &source, uint32_t firstLevel);
+
+    // file this image was decoded from
+    auto file() const -> const std::string &
+    {
+        return path;
+    };
+    // first level of the file whose sides are both at most maxExtent, 0 keeps every level
+    auto levelFor(uint32_t maxExtent) const -> uint32_t;
+    // bytes every layer of the file's levels from level on takes
+    auto residentSize(uint32_t level) const -> vk::DeviceSize;
+
+    // level of the file that is level 0 of the image
+    uint32_t firstLevel = 0;
+    // size of the file's level 0 and bytes of each of its levels, set by decode
+    vk::Extent3D fileExtent{};
+    std::vector<vk::DeviceSize> levelSizes{};
 
     void createSampler();
 
@@ -53,6 +82,8 @@ class Image
   private:
     Allocation *allocation = nullptr;
     std::string path;
+    // file opened by decode waiting for upload
+    std::shared_ptr<TextureFile> decoded{};
 
     void createImageView();
 };
@@ -19,8 +19,14 @@ class PhysicalDevice
 
     vk::PhysicalDevice device = nullptr;
     vk::PhysicalDeviceProperties properties;
+    vk::PhysicalDeviceFeatures features;
     vk::SampleCountFlagBits msaaSamples = vk::SampleCountFlagBits::e1;
-    const std::vector<const char *> extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    // swapchain extension is only required when not headless, filled in by pick
+    std::vector<const char *> extensions{};
+    // VK_EXT_memory_budget is enabled, it is used when the picked device has it
+    bool memoryBudget = false;
+    // VK_KHR_draw_indirect_count is enabled, indirect draws take their count from a buffer
+    bool drawIndirectCount = false;
 
     auto createDevice(const vk::DeviceCreateInfo& createInfo) -> vk::Device
     {
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+namespace tat
+{
+
+enum class Section : uint32_t
+{
+    Shadow = 0,
+    Backdrop = 1,
+    Models = 2,
+    Overlay = 3
+};
+
+// GPU timestamps and pipeline statistics for each section of a frame
+// every section has one slot per recording thread so threads never share a query
+// results are read back the next time a frame in flight comes around so nothing stalls
+class Profiler
+{
+  public:
+    static constexpr uint32_t sectionCount = 4;
+    static constexpr std::array<std::string_view, sectionCount> sectionNames = {"Shadow", "Backdrop", "Models",
+                                                                               "Overlay"};
+    static constexpr uint32_t statisticCount = 5;
+    static constexpr std::array<std::string_view, statisticCount> statisticNames = {
+        "Vertices", "Primitives", "VS Invocations", "Clipped", "FS Invocations"};
+
+    struct Result
+    {
+        float milliseconds = 0.F;
+        std::array<uint64_t, statisticCount> statistics{};
+    };
+
+    // latest results for each section
+    std::array<Result, sectionCount> results{};
+    bool enabled = false;
+
+    void create(uint32_t frames, uint32_t slots);
+    void destroy();
+
+    // reads back what this frame recorded last time, call after its fence has been waited on
+    void collect(uint32_t frame);
+    // must be recorded in the primary buffer outside of any render pass
+    void reset(vk::CommandBuffer commandBuffer, uint32_t frame);
+    void begin(vk::CommandBuffer commandBuffer, uint32_t frame, Section section, uint32_t slot = 0);
+    void end(vk::CommandBuffer commandBuffer, uint32_t frame, Section section, uint32_t slot = 0);
+
+  private:
+    vk::QueryPool timestampPool = nullptr;
+    vk::QueryPool statisticPool = nullptr;
+
+    uint32_t frameCount = 0;
+    uint32_t slotCount = 0;
+    // nanoseconds per timestamp tick
+    float timestampPeriod = 1.F;
+    uint64_t timestampMask = ~0ULL;
+    bool statisticsEnabled = false;
+
+    // frames whose queries have been reset and recorded at least once
+    std::vector<bool> pending{};
+    uint64_t collected = 0;
+    std::ofstream log;
+
+    auto query(uint32_t frame, Section section, uint32_t slot) -> uint32_t
+    {
+        return (frame * sectionCount + static_cast<uint32_t>(section)) * slotCount + slot;
+    };
+    auto queriesPerFrame() -> uint32_t
+    {
+        return sectionCount * slotCount;
+    };
+
+    void writeLog();
+};
+
+} // namespace tat
@@ -10,6 +10,8 @@
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
 #include <vulkan/vulkan.hpp>
 
+#include "engine/Image.hpp"
+
 namespace tat
 {
 struct SwapChainSupportDetails
@@ -23,6 +25,8 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // a transfer only family when there is one, otherwise the graphics family
+    std::optional<uint32_t> transferFamily;
 
     auto isComplete() -> bool
     {
@@ -37,6 +41,8 @@ class SwapChain
     void destroy();
 
     vk::SwapchainKHR swapChain = nullptr;
+    // when headless images and imageViews point into offscreen targets instead
+    std::vector<Image> targets{};
     std::vector<vk::Image> images{};
     std::vector<vk::ImageView> imageViews{};
 
@@ -48,6 +54,10 @@ class SwapChain
     static auto querySwapChainSupport(vk::PhysicalDevice const &physicalDevice) -> SwapChainSupportDetails;
 
   private:
+    static constexpr int32_t offscreenCount = 3;
+
+    void createOffscreen();
+
     static auto chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR> &availableFormats)
         -> vk::SurfaceFormatKHR;
     static auto chooseSwapPresentMode(const std::vector<vk::PresentModeKHR> &availablePresentModes)
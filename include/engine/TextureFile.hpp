@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "MappedFile.hpp"
+
+namespace gli
+{
+class texture;
+} // namespace gli
+
+namespace tat
+{
+
+// Mip chain of a texture file without copying it
+// DDS and KTX files in a known format are mapped and their levels point straight into the mapping,
+// anything else is read with gli as before
+// Faces of a cube map count as layers
+class TextureFile
+{
+  public:
+    // false if the file can't be read by either path
+    auto open(const std::string &path) -> bool;
+    // only the mapped path, false for anything gli would have to read, the levels aren't read in yet
+    auto map(const std::string &path) -> bool;
+
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent3D extent{};
+    uint32_t levels = 1;
+    uint32_t layers = 1;
+    bool cube = false;
+
+    auto levelExtent(uint32_t level) const -> vk::Extent3D;
+    // bytes of one layer of level
+    auto size(uint32_t level) const -> vk::DeviceSize
+    {
+        return sizes[level];
+    };
+    auto data(uint32_t layer, uint32_t level) const -> const uint8_t *
+    {
+        return pointers[layer * levels + level];
+    };
+    // true when data points into the mapped file
+    auto mapped() const -> bool
+    {
+        return file.data() != nullptr;
+    };
+    // writes every layer and level as a dds that open maps, false for formats the table doesn't know or 3d textures
+    auto save(const std::string &path) const -> bool;
+
+  private:
+    MappedFile file{};
+    // only set when gli read the file
+    std::shared_ptr<gli::texture> texture{};
+    std::vector<vk::DeviceSize> sizes{};
+    // by layer then level
+    std::vector<const uint8_t *> pointers{};
+
+    auto openDds() -> bool;
+    auto openKtx() -> bool;
+    auto openGli(const std::string &path) -> bool;
+    // fills sizes from the format's blocks, false for formats the table doesn't know
+    auto computeSizes() -> bool;
+};
+
+} // namespace tat
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "engine/Buffer.hpp"
+
+namespace tat
+{
+
+// One persistently mapped uniform buffer split into a region per swapchain image
+// Uniforms are pushed into the current region each frame and bound with dynamic offsets
+// so descriptor sets point at the whole buffer and never need rewriting
+// Pushes may also be bound as storage buffers, for arrays too large for a uniform buffer
+class UniformArena
+{
+  public:
+    // frameSize is the most bytes pushed in one frame, including alignment
+    void create(uint32_t frames, vk::DeviceSize frameSize);
+    void destroy();
+
+    // rounds size up to the device's uniform and storage offset alignment
+    auto align(vk::DeviceSize size) -> vk::DeviceSize;
+
+    // starts writing into this image's region
+    void begin(uint32_t currentImage);
+    // copies data in, returns its dynamic offset
+    auto push(const void *data, vk::DeviceSize size) -> uint32_t;
+    // makes this frame's writes visible to the device
+    void end();
+
+    auto buffer() -> vk::Buffer
+    {
+        return memory.buffer;
+    };
+
+  private:
+    Buffer memory{};
+    vk::DeviceSize alignment = 256;
+    vk::DeviceSize regionSize = 0;
+    vk::DeviceSize regionStart = 0;
+    vk::DeviceSize cursor = 0;
+};
+
+} // namespace tat
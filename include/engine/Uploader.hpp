@@ -0,0 +1,104 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "engine/Buffer.hpp"
+#include "engine/Image.hpp"
+
+namespace tat
+{
+
+// staging memory for one upload, record its copy before staging anything else
+struct Staging
+{
+    vk::Buffer buffer = nullptr;
+    vk::DeviceSize offset = 0;
+    vk::DeviceSize size = 0;
+    void *mapped = nullptr;
+};
+
+// Batches uploads and layout transitions instead of submitting and idling for each one
+// Staging memory is carved out of one persistently mapped ring buffer, a batch's share is
+// reclaimed when its fence signals, requests larger than the ring get their own buffer
+// Copies are recorded on the transfer queue when the device has a dedicated one,
+// ownership is then released to the graphics queue which acquires it in a second command buffer
+// Batches are submitted by flush and tracked with fences, a semaphore orders transfer before graphics
+// Anything recorded is guaranteed to execute before graphics work submitted after the next flush
+// Only used from the main thread
+class Uploader
+{
+  public:
+    void create();
+    void destroy();
+
+    // staging memory for size bytes, write to mapped before recording a copy from it
+    auto stage(vk::DeviceSize size) -> Staging;
+    auto stage(const void *data, vk::DeviceSize size) -> Staging;
+
+    // destination buffer must already be created
+    void copy(const Staging &source, Buffer &destination);
+    // image must already be created, it is left in finalLayout
+    void copy(const Staging &source, Image &destination, std::vector<vk::BufferImageCopy> &regions,
+              vk::ImageLayout finalLayout);
+    void transition(Image &image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
+
+    // graphics command buffer of the current batch for other one off work
+    auto commands() -> vk::CommandBuffer;
+
+    // submits everything recorded so far
+    void flush();
+    // releases staging memory of finished batches without blocking
+    void collect();
+    // flushes then blocks until every batch has finished
+    void wait();
+
+  private:
+    struct Batch
+    {
+        vk::CommandBuffer transfer = nullptr;
+        vk::CommandBuffer graphics = nullptr;
+        vk::Fence fence = nullptr;
+        vk::Semaphore semaphore = nullptr;
+        // ring bytes used including padding, and where the ring head was after the last one
+        vk::DeviceSize ringUsed = 0;
+        vk::DeviceSize ringEnd = 0;
+        // staging too large for the ring
+        std::vector<std::unique_ptr<Buffer>> staging{};
+    };
+
+    vk::CommandPool transferPool = nullptr;
+    vk::CommandPool graphicsPool = nullptr;
+    uint32_t transferFamily = 0;
+    uint32_t graphicsFamily = 0;
+    // transfer and graphics are different families so ownership must move between them
+    bool dedicated = false;
+
+    Buffer ring{};
+    vk::DeviceSize ringSize = 0;
+    vk::DeviceSize ringHead = 0;
+    vk::DeviceSize ringTail = 0;
+    vk::DeviceSize ringUsed = 0;
+    vk::DeviceSize alignment = 16;
+
+    Batch batch{};
+    bool recording = false;
+    // in submission order, they all finish on the graphics queue so fences signal in order
+    std::deque<Batch> inFlight{};
+
+    auto current() -> Batch &;
+    // offset of size free bytes in the ring, false when there is no room without waiting
+    auto allocate(vk::DeviceSize size, vk::DeviceSize &offset) -> bool;
+    void release(Batch &finished);
+};
+
+} // namespace tat
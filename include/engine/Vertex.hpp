@@ -19,6 +19,15 @@
 
 namespace tat
 {
+
+// how a mesh stores its vertices, each layout has its own pipelines
+enum class VertexLayout : uint32_t
+{
+    Full,
+    Packed
+};
+constexpr uint32_t vertexLayoutCount = 2;
+
 struct Vertex
 {
     glm::vec3 position;
@@ -62,6 +71,52 @@ struct Vertex
     }
 };
 
+// half the size of Vertex, attribute locations match so the same shaders read either
+// position is snorm inside the mesh's bounding box, the box is folded into the model matrix
+// UV is half floats, normal is octahedral snorm decoded in the vertex shader
+struct PackedVertex
+{
+    uint64_t position;
+    uint32_t UV;
+    uint32_t normal;
+
+    static auto getBindingDescription() -> vk::VertexInputBindingDescription
+    {
+        vk::VertexInputBindingDescription bindingDescription = {};
+        bindingDescription.binding = 0;
+        bindingDescription.stride = sizeof(PackedVertex);
+        bindingDescription.inputRate = vk::VertexInputRate::eVertex;
+
+        return bindingDescription;
+    }
+
+    static auto getAttributeDescriptions() -> std::array<vk::VertexInputAttributeDescription, 3>
+    {
+        std::array<vk::VertexInputAttributeDescription, 3> attributeDesriptions = {};
+        attributeDesriptions[0].binding = 0;
+        attributeDesriptions[0].location = 0;
+        attributeDesriptions[0].format = vk::Format::eR16G16B16A16Snorm;
+        attributeDesriptions[0].offset = offsetof(PackedVertex, position);
+
+        attributeDesriptions[1].binding = 0;
+        attributeDesriptions[1].location = 1;
+        attributeDesriptions[1].format = vk::Format::eR16G16Sfloat;
+        attributeDesriptions[1].offset = offsetof(PackedVertex, UV);
+
+        attributeDesriptions[2].binding = 0;
+        attributeDesriptions[2].location = 2;
+        attributeDesriptions[2].format = vk::Format::eR16G16Snorm;
+        attributeDesriptions[2].offset = offsetof(PackedVertex, normal);
+
+        return attributeDesriptions;
+    }
+};
+
+constexpr auto vertexStride(VertexLayout layout) -> uint32_t
+{
+    return layout == VertexLayout::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
 } // namespace tat
 
 namespace std
@@ -12,6 +12,7 @@
 
 #include "Camera.hpp"
 #include "Player.hpp"
+#include "engine/Profiler.hpp"
 
 namespace tat
 {
@@ -27,6 +28,7 @@ class Info
   private:
     Player *player = nullptr;
     Camera *camera = nullptr;
+    Profiler *profiler = nullptr;
 
     struct
     {
@@ -37,6 +39,7 @@ class Info
 
         float velocity = 0.F;
         float fps = 0.F;
+        std::array<Profiler::Result, Profiler::sectionCount> sections{};
         int32_t modeNum = 0;
         float lastFrameTime = 0.F;
         float lastUpdateTime = 0.F;
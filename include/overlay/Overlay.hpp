@@ -42,6 +42,8 @@ class Overlay
     void destroy();
     void recreate();
     void cleanup();
+    // rebuilds the pipeline from the shader files, the device must be idle
+    void reloadPipeline();
 
     // Starts a new imGui frame and sets up windows and ui elements
     void update(float deltaTime);
@@ -58,8 +60,9 @@ class Overlay
 
   private:
     // Vulkan resources for rendering the UI
-    Buffer vertexBuffer{};
-    Buffer indexBuffer{};
+    // one set of buffers per swapchain image so an image in flight is never written to
+    std::vector<Buffer> vertexBuffers{};
+    std::vector<Buffer> indexBuffers{};
 
     Image fontImage{};
 
@@ -74,6 +77,8 @@ class Overlay
     std::array<GLFWcursor *, ImGuiMouseCursor_COUNT> g_MouseCursors{};
 
     void createBuffers();
+    // copies the current imGui frame into the buffers for currentImage
+    void upload(uint32_t currentImage);
     void createFont();
     void createDescriptorPool();
     void createDescriptorLayouts();
@@ -0,0 +1,146 @@
+#include "AssetCache.hpp"
+#include "MappedFile.hpp"
+#include "engine/Debug.hpp"
+#include "engine/TextureFile.hpp"
+
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+namespace
+{
+
+// bump whenever the dds written for textures read by gli changes
+constexpr uint32_t textureVersion = 1;
+
+// 64 bit FNV-1a
+constexpr uint64_t hashBasis = 0xCBF29CE484222325;
+constexpr uint64_t hashPrime = 0x100000001B3;
+
+auto hash(uint64_t value, const uint8_t *data, size_t size) -> uint64_t
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        value = (value ^ data[i]) * hashPrime;
+    }
+    return value;
+}
+
+template <typename T> auto hash(uint64_t value, const T &data) -> uint64_t
+{
+    return hash(value, reinterpret_cast<const uint8_t *>(&data), sizeof(data));
+}
+
+} // namespace
+
+void AssetCache::create(const std::string &path)
+{
+    this->path = path;
+    if (path.empty())
+    {
+        return;
+    }
+
+    std::error_code error{};
+    std::filesystem::create_directories(path, error);
+    if (error)
+    {
+        spdlog::warn("Unable to create cache {} : {}, cooking every start", path, error.message());
+        this->path.clear();
+        return;
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Asset Cache in {}", path);
+    }
+}
+
+auto AssetCache::entry(const std::vector<std::string> &sources, const std::string &settings, uint32_t version,
+                       const std::string &extension) const -> std::string
+{
+    if (path.empty())
+    {
+        return "";
+    }
+
+    auto value = hashBasis;
+    for (auto &source : sources)
+    {
+        MappedFile file{};
+        if (!file.open(source))
+        {
+            return "";
+        }
+        // sizes keep the bytes of one source from running into the next
+        value = hash(value, file.size());
+        value = hash(value, file.data(), file.size());
+    }
+    value = hash(value, reinterpret_cast<const uint8_t *>(settings.data()), settings.size());
+    value = hash(value, version);
+    return (std::filesystem::path(path) / fmt::format("{:016x}{}", value, extension)).string();
+}
+
+auto AssetCache::store(const std::string &entry, const std::function<void(const std::string &)> &write) const -> bool
+{
+    // two threads cooking the same entry each get their own temporary
+    auto temporary = fmt::format("{}.{}.tmp", entry, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    try
+    {
+        write(temporary);
+        std::filesystem::rename(temporary, entry);
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::warn("Unable to store {} in cache : {}", entry, e.what());
+        std::error_code error{};
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Stored {} in cache", entry);
+    }
+    return true;
+}
+
+auto AssetCache::texture(const std::string &source) const -> std::string
+{
+    // mapping only reads the header, so sources that map are never hashed
+    TextureFile file{};
+    if (file.map(source))
+    {
+        return source;
+    }
+
+    auto cached = entry({source}, "", textureVersion, ".dds");
+    if (cached.empty())
+    {
+        return source;
+    }
+    std::error_code error{};
+    if (std::filesystem::exists(cached, error))
+    {
+        return cached;
+    }
+
+    if (!file.open(source))
+    { // the image will warn about it
+        return source;
+    }
+    auto stored = store(cached, [&file](auto &temporary) {
+        if (!file.save(temporary))
+        {
+            throw std::runtime_error("Unable to write format as dds");
+        }
+    });
+    return stored ? cached : source;
+}
+
+} // namespace tat
@@ -2,6 +2,8 @@
 #include "State.hpp"
 #include "engine/Debug.hpp"
 
+#include <array>
+#include <exception>
 #include <filesystem>
 #include <memory>
 #include <utility>
@@ -13,17 +15,12 @@ namespace tat
 
 void Backdrop::load()
 {
-    auto &backdrop = State::instance().at("backdrops").at(name);
+    loadCubeMap(record.color, &colorMap);
+    loadCubeMap(record.radiance, &radianceMap);
+    loadCubeMap(record.irradiance, &irradianceMap);
 
-    loadCubeMap(backdrop.at("color").get<std::string>(), &colorMap);
-    loadCubeMap(backdrop.at("radiance").get<std::string>(), &radianceMap);
-    loadCubeMap(backdrop.at("irradiance").get<std::string>(), &irradianceMap);
-
-    light.x = backdrop.at("light").at(0);
-    light.y = backdrop.at("light").at(1);
-    light.z = backdrop.at("light").at(2);
-
-    brightness = backdrop.at("brightness");
+    light = record.light;
+    brightness = record.brightness;
 
     createDescriptorPool();
     createDescriptorSetLayouts();
@@ -43,21 +40,7 @@ Backdrop::~Backdrop()
 {
     if (loaded)
     {
-        auto &device = State::instance().engine.device;
-
-        colorMap.destroy();
-        radianceMap.destroy();
-        irradianceMap.destroy();
-
-        if (descriptorSetLayout)
-        {
-            device.destroy(descriptorSetLayout);
-        }
-        if (descriptorPool)
-        {
-            device.destroy(descriptorPool);
-        }
-        pipeline.destroy();
+        unload();
 
         if constexpr (Debug::enable)
         {
@@ -66,6 +49,30 @@ Backdrop::~Backdrop()
     }
 }
 
+void Backdrop::unload()
+{
+    auto &device = State::instance().engine.device;
+
+    colorMap.destroy();
+    radianceMap.destroy();
+    irradianceMap.destroy();
+
+    if (descriptorSetLayout)
+    {
+        device.destroy(descriptorSetLayout);
+        descriptorSetLayout = nullptr;
+    }
+    if (descriptorPool)
+    {
+        device.destroy(descriptorPool);
+        descriptorPool = nullptr;
+    }
+    pipeline.destroy();
+    pipeline = Pipeline{};
+    backBuffers.clear();
+    loaded = false;
+}
+
 void Backdrop::recreate()
 {
     if (loaded)
@@ -87,16 +94,66 @@ void Backdrop::cleanup()
     }
 }
 
+auto Backdrop::reload() -> bool
+{
+    std::array<Image, 3> maps{};
+    try
+    {
+        loadCubeMap(record.color, &maps[0]);
+        loadCubeMap(record.radiance, &maps[1]);
+        loadCubeMap(record.irradiance, &maps[2]);
+    }
+    catch (std::exception &e)
+    {
+        spdlog::warn("Unable to reload Backdrop {}: {}", name, e.what());
+        for (auto &map : maps)
+        {
+            map.destroy();
+        }
+        return false;
+    }
+    colorMap.destroy();
+    radianceMap.destroy();
+    irradianceMap.destroy();
+    colorMap = maps[0];
+    radianceMap = maps[1];
+    irradianceMap = maps[2];
+    // the record may have been read again
+    light = record.light;
+    brightness = record.brightness;
+
+    // sets are freed with their pool
+    State::instance().engine.device.destroy(descriptorPool);
+    createDescriptorPool();
+    createDescriptorSets();
+    return true;
+}
+
+void Backdrop::reloadPipeline()
+{
+    pipeline.destroy();
+    createPipeline();
+}
+
+auto Backdrop::residentBytes() -> uint64_t
+{
+    if (!loaded)
+    {
+        return 0;
+    }
+    return colorMap.residentSize(colorMap.firstLevel) + radianceMap.residentSize(radianceMap.firstLevel) +
+           irradianceMap.residentSize(irradianceMap.firstLevel);
+}
+
 void Backdrop::loadCubeMap(const std::string &file, Image *image)
 {
-    auto path = State::instance().at("settings").at("backdropsPath").get<std::string>();
-    path = path + name + "/" + file;
+    auto path = State::instance().settings.backdropsPath + name + "/" + file;
 
     image->imageInfo.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
     image->memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
     image->imageInfo.flags = vk::ImageCreateFlagBits::eCubeCompatible;
     image->imageViewInfo.viewType = vk::ImageViewType::eCube;
-    image->load(path);
+    image->load(State::instance().cache.texture(path));
 
     image->samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
     image->samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
@@ -9,13 +9,13 @@ namespace tat
 
 void Camera::create()
 {
-    auto &settings = State::instance().at("settings");
-    width = settings.at("window").at(0);
-    height = settings.at("window").at(1);
-    FoV = settings.at("FoV");
-    zNear = settings.at("zNear");
-    zFar = settings.at("zFar");
-    mouseSensitivity = settings.at("mouseSensitivity");
+    auto &settings = State::instance().settings;
+    width = static_cast<float>(settings.window[0]);
+    height = static_cast<float>(settings.window[1]);
+    FoV = settings.FoV;
+    zNear = settings.zNear;
+    zFar = settings.zFar;
+    mouseSensitivity = settings.mouseSensitivity;
     setPosition(m_position);
     setRotation(m_rotation);
     updateView();
@@ -122,24 +122,21 @@ auto Camera::projection() -> glm::mat4
 void Camera::updateFov(float FoV)
 {
     this->FoV = FoV;
-    auto &settings = State::instance().at("settings");
-    settings["FoV"] = FoV;
+    State::instance().settings.FoV = FoV;
     updateProjection();
 }
 
 void Camera::updateZNear(float zNear)
 {
     this->zNear = zNear;
-    auto &settings = State::instance().at("settings");
-    settings["zNear"] = zNear;
+    State::instance().settings.zNear = zNear;
     updateProjection();
 }
 
 void Camera::updateZFar(float zFar)
 {
     this->zFar = zFar;
-    auto &settings = State::instance().at("settings");
-    settings["zFar"] = zFar;
+    State::instance().settings.zFar = zFar;
     updateProjection();
 }
 
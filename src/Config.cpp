@@ -1,8 +1,15 @@
 #include "Config.hpp"
+#include "MappedFile.hpp"
 #include "State.hpp"
+#include "ThreadPool.hpp"
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
@@ -12,6 +19,29 @@ using json = nlohmann::json;
 namespace tat
 {
 
+namespace
+{
+
+// 0 for files that don't exist, so creating one changes it too
+auto writeTime(const std::string &path) -> int64_t
+{
+    std::error_code error{};
+    auto time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+// notes when path was written so a snapshot can tell it changed
+// paths and times are kept as two arrays, they read back much faster than an object keyed by path
+auto record(json &manifest, const std::string &path) -> int64_t
+{
+    auto time = writeTime(path);
+    manifest.at("paths").push_back(path);
+    manifest.at("times").push_back(time);
+    return time;
+}
+
+} // namespace
+
 void Config::create(const std::string &path)
 {
     try
@@ -33,12 +63,33 @@ void Config::create(const std::string &path)
 
         // load settings
         loadSettings(path);
+        auto snapshot = state.at("settings").at("configSnapshot").get<std::string>();
+        if (!snapshot.empty() && loadSnapshot(snapshot, path))
+        {
+            readRecords();
+            return;
+        }
+
+        // every file and directory read below, with when it was written
+        json manifest = {{"paths", json::array()}, {"times", json::array()}};
+        record(manifest, path);
         loadPlayer(state.at("settings").at("playerConfig"));
+        record(manifest, state.at("settings").at("playerConfig"));
         loadScene(state.at("settings").at("sceneConfig"));
-        loadBackdrops(state.at("settings").at("backdropsPath"));
-        loadMaterials(state.at("settings").at("materialsPath"));
-        loadMeshes(state.at("settings").at("meshesPath"));
-        loadModels(state.at("settings").at("modelsPath"));
+        record(manifest, state.at("settings").at("sceneConfig"));
+
+        std::vector<Source> sources{};
+        findSources("backdrops", state.at("settings").at("backdropsPath"), backdropFile, sources, manifest);
+        findSources("materials", state.at("settings").at("materialsPath"), materialFile, sources, manifest);
+        findSources("meshes", state.at("settings").at("meshesPath"), meshFile, sources, manifest);
+        findSources("models", state.at("settings").at("modelsPath"), "", sources, manifest);
+        loadSources(sources);
+
+        if (!snapshot.empty())
+        {
+            saveSnapshot(snapshot, path, manifest);
+        }
+        readRecords();
 
         if constexpr (Debug::enable)
         {
@@ -118,176 +169,230 @@ void Config::loadScene(const std::string &path)
     }
 }
 
-void Config::loadBackdrops(const std::string &path)
+void Config::findSources(const std::string &collection, const std::string &path, const std::string &file,
+                         std::vector<Source> &sources, json &manifest)
 {
-
-    if (std::filesystem::exists(path))
+    // entries added or removed change the directory, so does creating it
+    if (record(manifest, path) == 0)
     {
-        for (const auto &config : std::filesystem::directory_iterator(path))
-        {
-            if (auto configFile = config.path().string() + "/backdrop.json"; std::filesystem::exists(configFile))
-            {
-                std::ifstream file(configFile);
-                json j;
-                file >> j;
-
-                // Don't just copy json in
-                // Update existing correct values if available
-                // extra entries don't matter*, missing ones do
-                // TODO(travis) *they probably do matter
-                auto name = config.path().filename().string();
-                auto &state = State::instance();
-                state.at("backdrops")[name] = backdrop;
-
-                for (auto &item : j.items())
-                {
-                    state.at("backdrops").at(name).update(item);
-                }
+        spdlog::warn("Unable to load {} path {}", collection, path);
+        return;
+    }
 
-                if constexpr (Debug::enable)
-                {
-                    spdlog::info("Loaded Config {}", configFile);
-                }
-            }
-            else
+    for (const auto &config : std::filesystem::directory_iterator(path))
+    {
+        if (file.empty())
+        { // json files directly in the directory, named by their stem
+            if (config.path().extension() == ".json")
             {
-                spdlog::warn("Unable to load {}", configFile);
+                sources.push_back({collection, config.path().stem().string(), config.path().string(), {}});
+                record(manifest, sources.back().path);
             }
+            continue;
+        }
+
+        // a directory per entry named after it, holding file
+        auto configFile = config.path().string() + "/" + file;
+        if (record(manifest, configFile) != 0)
+        {
+            sources.push_back({collection, config.path().filename().string(), configFile, {}});
+        }
+        else
+        {
+            spdlog::warn("Unable to load {}", configFile);
         }
-    }
-    else
-    {
-        spdlog::warn("Unable to load backdrop path {}", path);
     }
 }
 
-void Config::loadMaterials(const std::string &path)
+void Config::loadSources(std::vector<Source> &sources)
 {
-    if (std::filesystem::exists(path))
+    auto &state = State::instance();
+    auto threads = state.at("settings").at("loadThreads").get<size_t>();
+    if (threads == 0)
     {
-        for (const auto &config : std::filesystem::directory_iterator(path))
-        {
-            if (auto configFile = config.path().string() + "/material.json"; std::filesystem::exists(configFile))
-            {
-                std::ifstream file(configFile);
-                json j;
-                file >> j;
-
-                // Don't just copy json in
-                // Update existing correct values if available
-                // extra entries don't matter*, missing ones do
-                // TODO(travis) *they probably do matter
-                auto name = config.path().filename().string();
-                auto &state = State::instance();
-                state.at("materials")[name] = material;
-
-                for (auto &item : j.items())
-                {
-                    state.at("materials").at(name).update(item);
-                }
+        threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
 
-                if constexpr (Debug::enable)
-                {
-                    spdlog::info("Loaded Config {}", configFile);
-                }
-            }
-            else
+    // files are parsed on the pool, then merged in the order they were found so the result doesn't depend on timing
+    // config files are tiny, a job per file would spend more on queueing than parsing
+    ThreadPool pool{};
+    pool.create(threads);
+    auto batch = std::max(sources.size() / (threads * 4), size_t{1});
+    std::vector<std::future<void>> parsed{};
+    for (size_t first = 0; first < sources.size(); first += batch)
+    {
+        auto last = std::min(first + batch, sources.size());
+        parsed.push_back(pool.submit([&sources, first, last]() {
+            for (auto i = first; i < last; ++i)
             {
-                spdlog::warn("Unable to load {}", configFile);
+                // read whole then parsed from memory, skipping the stream's per character overhead
+                std::ifstream file(sources[i].path, std::ios::binary);
+                std::stringstream text;
+                text << file.rdbuf();
+                sources[i].parsed = json::parse(text.str());
             }
+        }));
+    }
+
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        if (i % batch == 0)
+        { // rethrows parse errors
+            parsed[i / batch].get();
+        }
+        auto &source = sources[i];
+        state.at(source.collection)[source.name] = merge(source.collection, source.parsed);
+
+        if constexpr (Debug::enable)
+        {
+            spdlog::info("Loaded Config {}", source.path);
         }
     }
-    else
+}
+
+auto Config::entry(const std::string &collection, const std::string &path) const -> json
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
     {
-        spdlog::warn("Unable to load material path {}", path);
+        throw std::runtime_error("Unable to open " + path);
     }
+    std::stringstream text;
+    text << file.rdbuf();
+    auto parsed = json::parse(text.str());
+    return merge(collection, parsed);
 }
 
-void Config::loadMeshes(const std::string &path)
+auto Config::merge(const std::string &collection, json &parsed) const -> json
 {
-    if (std::filesystem::exists(path))
+    const std::map<std::string, const json *> defaults = {
+        {"backdrops", &backdrop}, {"materials", &material}, {"meshes", &mesh}, {"models", &model}};
+
+    // Don't just copy json in
+    // Update existing correct values if available
+    // extra entries don't matter*, missing ones do
+    // TODO(travis) *they probably do matter
+    auto entry = *defaults.at(collection);
+    for (auto &item : parsed.items())
+    {
+        entry[item.key()] = std::move(item.value());
+    }
+    return entry;
+}
+
+auto Config::loadSnapshot(const std::string &snapshot, const std::string &path) -> bool
+{
+    MappedFile file{};
+    if (!file.open(snapshot))
+    {
+        return false;
+    }
+
+    json j;
+    try
     {
-        for (const auto &config : std::filesystem::directory_iterator(path))
+        j = json::from_msgpack(file.data(), file.data() + file.size());
+        // built from a different settings file or different defaults
+        if (j.at("config") != path || j.at("defaults") != defaults())
         {
-            if (auto configFile = config.path().string() + "/mesh.json"; std::filesystem::exists(configFile))
+            return false;
+        }
+        auto &paths = j.at("manifest").at("paths");
+        auto &times = j.at("manifest").at("times");
+        if (paths.size() != times.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            if (writeTime(paths[i]) != times[i].get<int64_t>())
             {
-                std::ifstream file(configFile);
-                json j;
-                file >> j;
-
-                // Don't just copy json in
-                // Update existing correct values if available
-                // extra entries don't matter*, missing ones do
-                // TODO(travis) *they probably do matter
-                auto name = config.path().filename().string();
-                auto &state = State::instance();
-                state.at("meshes")[name] = mesh;
-
-                for (auto &item : j.items())
-                {
-                    state.at("meshes").at(name).update(item);
-                }
-
                 if constexpr (Debug::enable)
                 {
-                    spdlog::info("Loaded Config {}", configFile);
+                    spdlog::info("Config snapshot {} is out of date, {} changed", snapshot, paths[i].get<std::string>());
                 }
+                return false;
             }
-            else
-            {
-                spdlog::warn("Unable to load {}", configFile);
-            }
+        }
+        if (!j.at("state").is_object())
+        {
+            return false;
         }
     }
-    else
+    catch (json::exception &e)
     {
-        spdlog::warn("Unable to load mesh path {}", path);
+        spdlog::warn("Unable to read config snapshot {} : {}", snapshot, e.what());
+        return false;
     }
+
+    // settings were just loaded from the same file
+    auto &state = State::instance();
+    for (auto &item : j.at("state").items())
+    {
+        state[item.key()] = std::move(item.value());
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Loaded Config snapshot {} covering {} files", snapshot, j.at("manifest").at("paths").size());
+    }
+    return true;
 }
 
-void Config::loadModels(const std::string &path)
+void Config::saveSnapshot(const std::string &snapshot, const std::string &path, const json &manifest)
 {
-    if (std::filesystem::exists(path))
+    json j;
+    j["config"] = path;
+    j["defaults"] = defaults();
+    j["manifest"] = manifest;
+    j["state"] = static_cast<const json &>(State::instance());
+    j["state"].erase("settings");
+
+    // written aside then renamed so a crash never leaves half a snapshot
+    auto temporary = snapshot + ".tmp";
+    try
     {
-        for (const auto &config : std::filesystem::directory_iterator(path))
+        auto parent = std::filesystem::path(snapshot).parent_path();
+        if (!parent.empty())
         {
-            if (auto configFile = config.path().string(); std::filesystem::exists(configFile))
-            {
-                if (config.path().extension() == ".json")
-                {
-                    std::ifstream file(configFile);
-                    json j;
-                    file >> j;
-
-                    // Don't just copy json in
-                    // Update existing correct values if available
-                    // extra entries don't matter*, missing ones do
-                    // TODO(travis) *they probably do matter
-                    auto name = config.path().filename().stem().string();
-                    auto &state = State::instance();
-                    state.at("models")[name] = model;
-
-                    for (auto &item : j.items())
-                    {
-                        state.at("models").at(name).update(item);
-                    }
-
-                    if constexpr (Debug::enable)
-                    {
-                        spdlog::info("Loaded Config {}", configFile);
-                    }
-                }
-            }
-            else
-            {
-                spdlog::warn("Unable to load {}", configFile);
-            }
+            std::filesystem::create_directories(parent);
+        }
+        auto data = json::to_msgpack(j);
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        file.close();
+        if (!file)
+        {
+            throw std::runtime_error("Unable to write file");
         }
+        std::filesystem::rename(temporary, snapshot);
     }
-    else
+    catch (const std::exception &e)
+    {
+        spdlog::warn("Unable to save config snapshot {} : {}", snapshot, e.what());
+        std::error_code error{};
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+
+    if constexpr (Debug::enable)
     {
-        spdlog::warn("Unable to load model path {}", path);
+        spdlog::info("Saved Config snapshot {}", snapshot);
     }
 }
 
-} // namespace tat
\ No newline at end of file
+void Config::readRecords()
+{
+    // collections convert their own entries when they are created
+    auto &state = State::instance();
+    state.settings = state.at("settings").get<SettingsRecord>();
+    state.playerRecord = state.at("player").get<PlayerRecord>();
+    state.sceneRecord = state.at("scene").get<SceneRecord>();
+}
+
+auto Config::defaults() const -> json
+{
+    return {settings, player, scene, backdrop, material, mesh, model};
+}
+
+} // namespace tat
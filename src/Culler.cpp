@@ -0,0 +1,618 @@
+#include "Culler.hpp"
+#include "State.hpp"
+#include "engine/Debug.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+void Culler::create(std::vector<Model *> &models)
+{
+    this->models = &models;
+    count = static_cast<uint32_t>(models.size());
+
+    createMeshlets();
+    createGeometry(nullptr);
+    createBuffers();
+    createDescriptors();
+    createPipeline();
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Culler for {} models, {} meshlets", count, jobCount);
+    }
+}
+
+void Culler::destroy()
+{
+    destroyPasses();
+    if (geometry)
+    {
+        // their own buffers were freed, so they are read again when next used
+        for (auto &placed : geometry->placed)
+        {
+            placed.first->unload();
+        }
+        geometry.reset();
+    }
+}
+
+void Culler::reloadMeshes()
+{
+    auto previous = std::move(geometry);
+    destroyPasses();
+    createMeshlets();
+    createGeometry(previous.get());
+    createBuffers();
+    createDescriptors();
+    createPipeline();
+}
+
+void Culler::reloadPipeline()
+{
+    destroyPipeline();
+    createPipeline();
+}
+
+void Culler::destroyPasses()
+{
+    auto &device = State::instance().engine.device;
+    destroyPipeline();
+    if (pool)
+    {
+        device.destroy(pool);
+        pool = nullptr;
+    }
+    if (layout)
+    {
+        device.destroy(layout);
+        layout = nullptr;
+    }
+    objectBuffer.destroy();
+    drawBuffer.destroy();
+    visibleBuffer.destroy();
+    meshletBuffer.destroy();
+}
+
+void Culler::destroyPipeline()
+{
+    auto &device = State::instance().engine.device;
+    if (pipeline)
+    {
+        device.destroy(pipeline);
+        pipeline = nullptr;
+    }
+    if (pipelineLayout)
+    {
+        device.destroy(pipelineLayout);
+        pipelineLayout = nullptr;
+    }
+    if (shader)
+    {
+        device.destroy(shader);
+        shader = nullptr;
+    }
+    if (meshletPipeline)
+    {
+        device.destroy(meshletPipeline);
+        meshletPipeline = nullptr;
+    }
+    if (meshletShader)
+    {
+        device.destroy(meshletShader);
+        meshletShader = nullptr;
+    }
+}
+
+void Culler::createMeshlets()
+{
+    auto &engine = State::instance().engine;
+    auto alignment = std::max<vk::DeviceSize>(1, engine.physicalDevice.properties.limits.minStorageBufferOffsetAlignment);
+    auto align = [alignment](vk::DeviceSize size) { return (size + alignment - 1) / alignment * alignment; };
+
+    objectIndices.assign(count, ObjectIndices{});
+    std::vector<glm::uvec2> jobs{};
+    std::vector<Meshlet> meshlets{};
+    std::vector<uint32_t> meshletVertices{};
+    std::vector<uint8_t> meshletTriangles{};
+    // meshes shared by several models are only stored once
+    std::unordered_map<Mesh *, uint32_t> firstMeshlet{};
+    indexCapacity = 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto *mesh = (*models)[i]->getMesh();
+        if (mesh->meshlets.empty())
+        {
+            continue;
+        }
+
+        auto [first, inserted] = firstMeshlet.try_emplace(mesh, static_cast<uint32_t>(meshlets.size()));
+        if (inserted)
+        {
+            auto vertexBase = static_cast<uint32_t>(meshletVertices.size());
+            auto triangleBase = static_cast<uint32_t>(meshletTriangles.size());
+            for (auto meshlet : mesh->meshlets)
+            {
+                meshlet.vertexOffset += vertexBase;
+                meshlet.triangleOffset += triangleBase;
+                meshlets.push_back(meshlet);
+            }
+            meshletVertices.insert(meshletVertices.end(), mesh->meshletVertices.begin(), mesh->meshletVertices.end());
+            meshletTriangles.insert(meshletTriangles.end(), mesh->meshletTriangles.begin(),
+                                    mesh->meshletTriangles.end());
+        }
+        for (uint32_t j = 0; j < mesh->meshlets.size(); ++j)
+        {
+            jobs.emplace_back(i, first->second + j);
+        }
+
+        // room for every index in case nothing is culled
+        objectIndices[i].firstIndex = indexCapacity;
+        objectIndices[i].meshlets = true;
+        indexCapacity += mesh->lods[0].indexCount;
+    }
+    jobCount = static_cast<uint32_t>(jobs.size());
+
+    std::array<const void *, 4> data = {jobs.data(), meshlets.data(), meshletVertices.data(),
+                                        meshletTriangles.data()};
+    meshletSizes = {jobs.size() * sizeof(glm::uvec2), meshlets.size() * sizeof(Meshlet),
+                    meshletVertices.size() * sizeof(uint32_t), meshletTriangles.size()};
+    vk::DeviceSize total = 0;
+    for (size_t i = 0; i < meshletSizes.size(); ++i)
+    {
+        meshletOffsets[i] = total;
+        total = align(total + std::max<vk::DeviceSize>(meshletSizes[i], sizeof(Meshlet)));
+    }
+
+    meshletBuffer.flags = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+    meshletBuffer.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+    if constexpr (Debug::enable)
+    {
+        meshletBuffer.name = "Culler Meshlets";
+    }
+    meshletBuffer.create(total);
+
+    auto staging = engine.uploader.stage(total);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        if (meshletSizes[i] > 0)
+        {
+            std::memcpy(static_cast<uint8_t *>(staging.mapped) + meshletOffsets[i], data[i], meshletSizes[i]);
+        }
+    }
+    engine.uploader.copy(staging, meshletBuffer);
+}
+
+void Culler::createGeometry(const Geometry *previous)
+{
+    auto &engine = State::instance().engine;
+    auto alignment = std::max<vk::DeviceSize>(1, engine.physicalDevice.properties.limits.minStorageBufferOffsetAlignment);
+    auto align = [alignment](vk::DeviceSize size) { return (size + alignment - 1) / alignment * alignment; };
+
+    // meshes shared by several models are only stored once, placed by the first model using them
+    geometry = std::make_unique<Geometry>();
+    std::vector<Mesh *> meshes{};
+    std::array<uint32_t, vertexLayoutCount> vertexCounts{};
+    uint32_t indexCount = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto *mesh = (*models)[i]->getMesh();
+        auto [placed, inserted] = geometry->placed.try_emplace(mesh);
+        if (inserted)
+        {
+            auto &vertexCount = vertexCounts[static_cast<uint32_t>(mesh->layout)];
+            placed->second = {static_cast<int32_t>(vertexCount), indexCount};
+            vertexCount += mesh->vertexCount;
+            indexCount += mesh->indexCount;
+            meshes.push_back(mesh);
+        }
+        objectIndices[i].vertexOffset = placed->second.vertexOffset;
+        objectIndices[i].meshIndex = placed->second.firstIndex;
+    }
+
+    // the next rebuild copies out of them
+    for (uint32_t i = 0; i < vertexLayoutCount; ++i)
+    {
+        auto &buffer = geometry->vertices[i];
+        buffer.flags = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc |
+                       vk::BufferUsageFlagBits::eVertexBuffer;
+        buffer.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+        if constexpr (Debug::enable)
+        {
+            buffer.name = "Culler Vertices";
+        }
+        // at least one vertex so the buffers are never empty
+        buffer.create(std::max<vk::DeviceSize>(1, vertexCounts[i]) * vertexStride(static_cast<VertexLayout>(i)));
+    }
+
+    // compacted indices are bound as storage so they start aligned
+    clusterStart = align(std::max<vk::DeviceSize>(1, indexCount) * sizeof(uint32_t));
+    indexStride = align(std::max<vk::DeviceSize>(1, indexCapacity) * sizeof(uint32_t));
+    auto &indexBuffer = geometry->indices;
+    indexBuffer.flags = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc |
+                        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndexBuffer;
+    indexBuffer.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+    if constexpr (Debug::enable)
+    {
+        indexBuffer.name = "Culler Indices";
+    }
+    indexBuffer.create(clusterStart + indexStride * engine.swapChain.count);
+
+    // the barrier recorded with each mesh's upload makes it readable here,
+    // whether the upload is earlier in this batch or in one submitted before it
+    auto commandBuffer = engine.uploader.commands();
+    for (auto *mesh : meshes)
+    {
+        // meshes that weren't reloaded have no buffers of their own and move from where they were
+        auto own = static_cast<bool>(mesh->buffers.vertex.buffer);
+        if (!own && (previous == nullptr || previous->placed.count(mesh) == 0))
+        {
+            spdlog::error("Mesh {} has no geometry to copy", mesh->name);
+            throw std::runtime_error("Mesh has no geometry to copy");
+        }
+        auto layout = static_cast<uint32_t>(mesh->layout);
+        auto stride = vertexStride(mesh->layout);
+        auto &to = geometry->placed[mesh];
+        auto from = own ? Placement{} : previous->placed.at(mesh);
+        auto vertexSource = own ? mesh->buffers.vertex.buffer : previous->vertices[layout].buffer;
+        auto indexSource = own ? mesh->buffers.index.buffer : previous->indices.buffer;
+        if (mesh->vertexCount > 0)
+        {
+            vk::BufferCopy region{static_cast<vk::DeviceSize>(from.vertexOffset) * stride,
+                                  static_cast<vk::DeviceSize>(to.vertexOffset) * stride,
+                                  static_cast<vk::DeviceSize>(mesh->vertexCount) * stride};
+            commandBuffer.copyBuffer(vertexSource, geometry->vertices[layout].buffer, 1, &region);
+        }
+        if (mesh->indexCount > 0)
+        {
+            vk::BufferCopy region{static_cast<vk::DeviceSize>(from.firstIndex) * sizeof(uint32_t),
+                                  static_cast<vk::DeviceSize>(to.firstIndex) * sizeof(uint32_t),
+                                  static_cast<vk::DeviceSize>(mesh->indexCount) * sizeof(uint32_t)};
+            commandBuffer.copyBuffer(indexSource, indexBuffer.buffer, 1, &region);
+        }
+    }
+    vk::MemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead;
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, {},
+                                  barrier, nullptr, nullptr);
+
+    // what the copies read is only freed once they ran
+    engine.uploader.wait();
+    for (auto *mesh : meshes)
+    {
+        mesh->release();
+    }
+}
+
+void Culler::createBuffers()
+{
+    auto &engine = State::instance().engine;
+    auto alignment = std::max<vk::DeviceSize>(1, engine.physicalDevice.properties.limits.minStorageBufferOffsetAlignment);
+    auto align = [alignment](vk::DeviceSize size) { return (size + alignment - 1) / alignment * alignment; };
+
+    // at least one object so the buffers are never empty
+    auto objects = std::max<vk::DeviceSize>(1, count);
+    objectStride = align(sizeof(CullFrame) + objects * sizeof(CullObject));
+    // every list has room for every model
+    slotOffset = align(listCount * objects * sizeof(vk::DrawIndexedIndirectCommand));
+    drawStride = align(slotOffset + (listCount + objects) * sizeof(uint32_t));
+    // color then shadow
+    visibleStride = align(2 * objects * sizeof(uint32_t));
+
+    objectBuffer.flags = vk::BufferUsageFlagBits::eStorageBuffer;
+    objectBuffer.memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    objectBuffer.memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    drawBuffer.flags = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+                       vk::BufferUsageFlagBits::eTransferDst;
+    drawBuffer.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+    visibleBuffer.flags = vk::BufferUsageFlagBits::eStorageBuffer;
+    visibleBuffer.memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    visibleBuffer.memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    if constexpr (Debug::enable)
+    {
+        objectBuffer.name = "Culler Objects";
+        drawBuffer.name = "Culler Draws";
+        visibleBuffer.name = "Culler Visible";
+    }
+    objectBuffer.create(objectStride * engine.swapChain.count);
+    drawBuffer.create(drawStride * engine.swapChain.count);
+    visibleBuffer.create(visibleStride * engine.swapChain.count);
+}
+
+void Culler::createDescriptors()
+{
+    auto &device = State::instance().engine.device;
+
+    // objects, draws, compacted indices, visible models and each model's color draw are per image and dynamic,
+    // the meshlet data after them is static
+    // both passes share the layout, cull.comp doesn't use the compacted indices or meshlets
+    constexpr uint32_t dynamicCount = 5;
+    constexpr uint32_t bindingCount = dynamicCount + 4;
+    std::array<vk::DescriptorSetLayoutBinding, bindingCount> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorCount = 1;
+        bindings[i].descriptorType =
+            i < dynamicCount ? vk::DescriptorType::eStorageBufferDynamic : vk::DescriptorType::eStorageBuffer;
+        bindings[i].stageFlags = vk::ShaderStageFlagBits::eCompute;
+    }
+
+    vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.bindingCount = bindings.size();
+    layoutInfo.pBindings = bindings.data();
+    layout = device.create(layoutInfo);
+
+    std::array<vk::DescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = vk::DescriptorType::eStorageBufferDynamic;
+    poolSizes[0].descriptorCount = dynamicCount;
+    poolSizes[1].type = vk::DescriptorType::eStorageBuffer;
+    poolSizes[1].descriptorCount = bindings.size() - dynamicCount;
+
+    vk::DescriptorPoolCreateInfo poolInfo{};
+    poolInfo.poolSizeCount = poolSizes.size();
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = 1;
+    pool = device.create(poolInfo);
+
+    vk::DescriptorSetAllocateInfo allocInfo{};
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+    set = device.create(allocInfo)[0];
+
+    // one set for every image, dynamic offsets select the region
+    std::array<vk::DescriptorBufferInfo, bindingCount> bufferInfos{};
+    bufferInfos[0] = vk::DescriptorBufferInfo{objectBuffer.buffer, 0, objectStride};
+    bufferInfos[1] = vk::DescriptorBufferInfo{drawBuffer.buffer, 0, slotOffset};
+    bufferInfos[2] = vk::DescriptorBufferInfo{geometry->indices.buffer, clusterStart, indexStride};
+    bufferInfos[3] = vk::DescriptorBufferInfo{visibleBuffer.buffer, 0, visibleStride};
+    bufferInfos[4] = vk::DescriptorBufferInfo{drawBuffer.buffer, slotOffset, drawStride - slotOffset};
+    for (size_t i = 0; i < meshletOffsets.size(); ++i)
+    {
+        // empty regions still need a range
+        auto range = std::max<vk::DeviceSize>(meshletSizes[i], sizeof(Meshlet));
+        bufferInfos[dynamicCount + i] = vk::DescriptorBufferInfo{meshletBuffer.buffer, meshletOffsets[i], range};
+    }
+
+    std::vector<vk::WriteDescriptorSet> descriptorWrites(bindings.size());
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        descriptorWrites[i].dstSet = set;
+        descriptorWrites[i].dstBinding = i;
+        descriptorWrites[i].descriptorType = bindings[i].descriptorType;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+    }
+    device.update(descriptorWrites);
+
+    if constexpr (Debug::enable)
+    {
+        Debug::setName(device.device, layout, "Culler Layout");
+        Debug::setName(device.device, pool, "Culler Pool");
+        Debug::setName(device.device, set, "Culler Set");
+    }
+}
+
+void Culler::createPipeline()
+{
+    auto &engine = State::instance().engine;
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &layout;
+    pipelineLayout = engine.device.create(pipelineLayoutInfo);
+
+    shader = engine.createShaderModule("assets/shaders/cull.comp.spv");
+
+    // both shaders size and index the lists by the number of vertex layouts
+    uint32_t layoutCount = vertexLayoutCount;
+    vk::SpecializationMapEntry specializationEntry{0, 0, sizeof(uint32_t)};
+    vk::SpecializationInfo specializationInfo{1, &specializationEntry, sizeof(layoutCount), &layoutCount};
+
+    vk::ComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipelineInfo.stage.module = shader;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.stage.pSpecializationInfo = &specializationInfo;
+    pipelineInfo.layout = pipelineLayout;
+    pipeline = engine.device.create(pipelineInfo, engine.pipelineCache.pipelineCache);
+
+    meshletShader = engine.createShaderModule("assets/shaders/meshlet.comp.spv");
+    pipelineInfo.stage.module = meshletShader;
+    meshletPipeline = engine.device.create(pipelineInfo, engine.pipelineCache.pipelineCache);
+
+    if constexpr (Debug::enable)
+    {
+        Debug::setName(engine.device.device, shader, "Culler Comp Shader");
+        Debug::setName(engine.device.device, pipelineLayout, "Culler PipelineLayout");
+        Debug::setName(engine.device.device, pipeline, "Culler Pipeline");
+        Debug::setName(engine.device.device, meshletShader, "Culler Meshlet Comp Shader");
+        Debug::setName(engine.device.device, meshletPipeline, "Culler Meshlet Pipeline");
+    }
+}
+
+void Culler::update(uint32_t currentImage, std::vector<glm::mat4> &transforms, const Frustum &colorFrustum,
+                    const Frustum &shadowFrustum, glm::vec3 camera, const std::vector<uint32_t> &visibleColor,
+                    const std::vector<uint32_t> &visibleShadow, const std::vector<uint32_t> &colorLods,
+                    const std::vector<uint32_t> &shadowLods)
+{
+    auto *region = static_cast<uint8_t *>(objectBuffer.mapped) + objectStride * currentImage;
+
+    CullFrame frame{};
+    frame.colorPlanes = colorFrustum.planes;
+    frame.shadowPlanes = shadowFrustum.planes;
+    frame.camera = glm::vec4(camera, 1.F);
+    frame.count = count;
+    frame.jobCount = jobCount;
+    frame.colorCount = static_cast<uint32_t>(visibleColor.size());
+    frame.shadowCount = static_cast<uint32_t>(visibleShadow.size());
+    frame.clusterBase = static_cast<uint32_t>((clusterStart + indexStride * currentImage) / sizeof(uint32_t));
+    std::memcpy(region, &frame, sizeof(frame));
+    visibleCount = std::max(frame.colorCount, frame.shadowCount);
+
+    listSizes.fill(0);
+    for (auto i : visibleColor)
+    {
+        ++listSizes[static_cast<uint32_t>((*models)[i]->getMesh()->layout)];
+    }
+    for (auto i : visibleShadow)
+    {
+        ++listSizes[vertexLayoutCount + static_cast<uint32_t>((*models)[i]->getMesh()->layout)];
+    }
+
+    // only models the cpu kept are tested again
+    auto *visible = static_cast<uint8_t *>(visibleBuffer.mapped) + visibleStride * currentImage;
+    std::memcpy(visible, visibleColor.data(), visibleColor.size() * sizeof(uint32_t));
+    std::memcpy(visible + count * sizeof(uint32_t), visibleShadow.data(), visibleShadow.size() * sizeof(uint32_t));
+    visibleBuffer.flush(2 * count * sizeof(uint32_t), visibleStride * currentImage);
+
+    auto *objects = reinterpret_cast<CullObject *>(region + sizeof(CullFrame));
+    for (size_t i = 0; i < count; ++i)
+    {
+        objects[i].visible = 0;
+    }
+    for (auto i : visibleColor)
+    {
+        objects[i].visible = 1;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto *mesh = (*models)[i]->getMesh();
+        auto &object = objects[i];
+        object.model = transforms[i];
+        object.bounds = mesh->bounds;
+        auto &colorLod = mesh->lods[colorLods[i]];
+        auto &shadowLod = mesh->lods[shadowLods[i]];
+        auto &indices = objectIndices[i];
+        object.colorFirst = indices.meshIndex + colorLod.firstIndex;
+        object.colorCount = colorLod.indexCount;
+        object.shadowFirst = indices.meshIndex + shadowLod.firstIndex;
+        object.shadowCount = shadowLod.indexCount;
+        object.firstIndex = indices.firstIndex;
+        object.clustered = indices.meshlets && colorLods[i] == 0 ? 1 : 0;
+        object.layout = static_cast<uint32_t>(mesh->layout);
+        object.vertexOffset = indices.vertexOffset;
+    }
+
+    objectBuffer.flush(sizeof(CullFrame) + count * sizeof(CullObject), objectStride * currentImage);
+}
+
+void Culler::dispatch(vk::CommandBuffer commandBuffer, uint32_t currentImage)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // lists are appended to from an empty count, without counts from the gpu the draws past the survivors
+    // are drawn too so they are cleared to nothing along with the counts right after them
+    auto &engine = State::instance().engine;
+    auto countsOnly = engine.physicalDevice.drawIndirectCount;
+    auto clearStart = drawStride * currentImage + (countsOnly ? slotOffset : 0);
+    auto cleared = (countsOnly ? 0 : slotOffset) + listCount * sizeof(uint32_t);
+    commandBuffer.fillBuffer(drawBuffer.buffer, clearStart, cleared, 0);
+    vk::BufferMemoryBarrier clearBarrier{};
+    clearBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    clearBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+    clearBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    clearBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    clearBarrier.buffer = drawBuffer.buffer;
+    clearBarrier.offset = clearStart;
+    clearBarrier.size = cleared;
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+                                  {}, nullptr, clearBarrier, nullptr);
+
+    std::array<uint32_t, 5> dynamicOffsets = {static_cast<uint32_t>(objectStride * currentImage),
+                                              static_cast<uint32_t>(drawStride * currentImage),
+                                              static_cast<uint32_t>(indexStride * currentImage),
+                                              static_cast<uint32_t>(visibleStride * currentImage),
+                                              static_cast<uint32_t>(drawStride * currentImage)};
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, 1, &set,
+                                     dynamicOffsets.size(), dynamicOffsets.data());
+    if (visibleCount > 0)
+    {
+        commandBuffer.dispatch((visibleCount + groupSize - 1) / groupSize, 1, 1);
+    }
+
+    vk::BufferMemoryBarrier drawBarrier{};
+    drawBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+    drawBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    drawBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    drawBarrier.buffer = drawBuffer.buffer;
+    drawBarrier.offset = drawStride * currentImage;
+    drawBarrier.size = drawStride;
+
+    if (jobCount > 0)
+    {
+        // meshlets add their indices to the color draws the first pass appended
+        drawBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, drawBarrier, nullptr);
+
+        // one group per meshlet, wrapped into rows when there are more than a dimension allows
+        auto groupsX = std::min(jobCount, maxGroups);
+        auto groupsY = (jobCount + groupsX - 1) / groupsX;
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, meshletPipeline);
+        commandBuffer.dispatch(groupsX, groupsY, 1);
+    }
+
+    // draws read the commands as soon as the shadow pass starts, color draws read the compacted indices
+    drawBarrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead;
+    vk::BufferMemoryBarrier indexBarrier{};
+    indexBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+    indexBarrier.dstAccessMask = vk::AccessFlagBits::eIndexRead;
+    indexBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    indexBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    indexBarrier.buffer = geometry->indices.buffer;
+    indexBarrier.offset = clusterStart + indexStride * currentImage;
+    indexBarrier.size = indexStride;
+    std::array<vk::BufferMemoryBarrier, 2> barriers = {drawBarrier, indexBarrier};
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                  vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput,
+                                  {}, nullptr, barriers, nullptr);
+}
+
+void Culler::drawColor(vk::CommandBuffer commandBuffer, uint32_t currentImage, uint32_t layout)
+{
+    draw(commandBuffer, currentImage, layout);
+}
+
+void Culler::drawShadow(vk::CommandBuffer commandBuffer, uint32_t currentImage, uint32_t layout)
+{
+    draw(commandBuffer, currentImage, vertexLayoutCount + layout);
+}
+
+void Culler::draw(vk::CommandBuffer commandBuffer, uint32_t currentImage, uint32_t list)
+{
+    if (listSizes[list] == 0)
+    {
+        return;
+    }
+
+    auto region = drawStride * currentImage;
+    auto offset = region + list * count * sizeof(vk::DrawIndexedIndirectCommand);
+    if (State::instance().engine.physicalDevice.drawIndirectCount)
+    {
+        commandBuffer.drawIndexedIndirectCountKHR(drawBuffer.buffer, offset, drawBuffer.buffer,
+                                                  region + slotOffset + list * sizeof(uint32_t), listSizes[list],
+                                                  sizeof(vk::DrawIndexedIndirectCommand));
+    }
+    else
+    {
+        commandBuffer.drawIndexedIndirect(drawBuffer.buffer, offset, listSizes[list],
+                                          sizeof(vk::DrawIndexedIndirectCommand));
+    }
+}
+
+} // namespace tat
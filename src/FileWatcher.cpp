@@ -0,0 +1,203 @@
+#include "FileWatcher.hpp"
+#include "Timer.hpp"
+#include "engine/Debug.hpp"
+
+#include <array>
+#include <filesystem>
+#include <system_error>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+FileWatcher::~FileWatcher()
+{
+    destroy();
+}
+
+#ifdef __linux__
+
+void FileWatcher::create(const std::vector<std::string> &directories)
+{
+    destroy();
+
+    descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (descriptor < 0)
+    {
+        spdlog::warn("Unable to watch files, inotify failed with error {}", errno);
+        return;
+    }
+    for (auto &directory : directories)
+    {
+        watch(directory);
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Watching {} directories", watches.size());
+    }
+}
+
+void FileWatcher::destroy()
+{
+    if (descriptor >= 0)
+    { // closing removes every watch
+        close(descriptor);
+        descriptor = -1;
+    }
+    watches.clear();
+}
+
+void FileWatcher::watch(const std::string &directory)
+{
+    std::error_code error{};
+    if (!std::filesystem::is_directory(directory, error))
+    {
+        return;
+    }
+    // closed after writing covers saving in place, moved to covers saving to a temporary then renaming
+    // created is only used for new directories
+    auto id = inotify_add_watch(descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+    if (id < 0)
+    {
+        spdlog::warn("Unable to watch {}, error {}", directory, errno);
+        return;
+    }
+    watches[id] = directory;
+
+    for (auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_directory(error))
+        {
+            watch(directory + entry.path().filename().string() + "/");
+        }
+    }
+}
+
+auto FileWatcher::changes() -> std::vector<std::string>
+{
+    std::vector<std::string> changed{};
+    if (descriptor < 0)
+    {
+        return changed;
+    }
+
+    alignas(inotify_event) std::array<char, 4096> buffer{};
+    while (true)
+    {
+        // fails with EAGAIN once every event has been read
+        auto length = read(descriptor, buffer.data(), buffer.size());
+        if (length <= 0)
+        {
+            break;
+        }
+        for (ssize_t offset = 0; offset < length;)
+        {
+            auto *event = reinterpret_cast<const inotify_event *>(buffer.data() + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if ((event->mask & IN_Q_OVERFLOW) != 0U)
+            {
+                spdlog::warn("File watch queue overflowed, some changes were missed");
+                continue;
+            }
+            if ((event->mask & IN_IGNORED) != 0U)
+            { // the directory was removed
+                watches.erase(event->wd);
+                continue;
+            }
+            auto it = watches.find(event->wd);
+            if (it == watches.end() || event->len == 0)
+            {
+                continue;
+            }
+
+            auto path = it->second + event->name;
+            if ((event->mask & IN_ISDIR) != 0U)
+            { // files written into it before the watch is added are missed
+                watch(path + "/");
+            }
+            else if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0U)
+            {
+                changed.push_back(path);
+            }
+        }
+    }
+    return changed;
+}
+
+#else
+
+void FileWatcher::create(const std::vector<std::string> &directories)
+{
+    destroy();
+
+    this->directories = directories;
+    // every existing file is the baseline
+    scan(nullptr);
+    lastScan = Timer::time();
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Watching {} files", times.size());
+    }
+}
+
+void FileWatcher::destroy()
+{
+    directories.clear();
+    times.clear();
+}
+
+auto FileWatcher::changes() -> std::vector<std::string>
+{
+    std::vector<std::string> changed{};
+    auto now = Timer::time();
+    if (directories.empty() || now - lastScan < scanInterval)
+    {
+        return changed;
+    }
+    lastScan = now;
+    scan(&changed);
+    return changed;
+}
+
+void FileWatcher::scan(std::vector<std::string> *changed)
+{
+    std::error_code error{};
+    for (auto &directory : directories)
+    {
+        for (std::filesystem::recursive_directory_iterator it(directory, error), end; !error && it != end;
+             it.increment(error))
+        {
+            // errors reading one entry don't stop the walk
+            std::error_code entryError{};
+            if (!it->is_regular_file(entryError))
+            {
+                continue;
+            }
+            auto time = it->last_write_time(entryError);
+            auto path = it->path().generic_string();
+            auto [known, inserted] = times.try_emplace(path, time);
+            if (inserted || known->second < time)
+            {
+                known->second = time;
+                if (changed != nullptr)
+                {
+                    changed->push_back(path);
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+} // namespace tat
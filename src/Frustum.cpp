@@ -0,0 +1,220 @@
+#include "Frustum.hpp"
+
+#include <array>
+#include <cmath>
+
+// avx is only used when the cpu has it, so the build doesn't need -mavx
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define TAT_FRUSTUM_AVX 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// msvc emits avx intrinsics whatever /arch is
+#define TAT_TARGET_AVX
+#else
+#define TAT_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TAT_FRUSTUM_SSE 1
+#endif
+
+namespace tat
+{
+
+void Bounds::resize(size_t count)
+{
+    if (count == this->count)
+    {
+        return;
+    }
+    this->count = count;
+    // padding is masked out by count, so it never needs clearing
+    auto padded = (count + Frustum::width - 1) / Frustum::width * Frustum::width;
+    centerX.resize(padded);
+    centerY.resize(padded);
+    centerZ.resize(padded);
+    extentX.resize(padded);
+    extentY.resize(padded);
+    extentZ.resize(padded);
+}
+
+void Bounds::set(size_t index, const glm::mat4 &transform, const glm::vec3 &center, const glm::vec3 &extent)
+{
+    // the new extent on each axis is the extent projected by the absolute rotation and scale
+    auto worldCenter = glm::vec3(transform * glm::vec4(center, 1.F));
+    auto axisX = glm::abs(glm::vec3(transform[0])) * extent.x;
+    auto axisY = glm::abs(glm::vec3(transform[1])) * extent.y;
+    auto axisZ = glm::abs(glm::vec3(transform[2])) * extent.z;
+    auto worldExtent = axisX + axisY + axisZ;
+
+    centerX[index] = worldCenter.x;
+    centerY[index] = worldCenter.y;
+    centerZ[index] = worldCenter.z;
+    extentX[index] = worldExtent.x;
+    extentY[index] = worldExtent.y;
+    extentZ[index] = worldExtent.z;
+}
+
+void Frustum::extract(const glm::mat4 &viewProjection)
+{
+    // rows of the matrix, glm is column major
+    auto row = [&viewProjection](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    planes[0] = row(3) + row(0); // left
+    planes[1] = row(3) - row(0); // right
+    planes[2] = row(3) + row(1); // bottom
+    planes[3] = row(3) - row(1); // top
+    planes[4] = row(2);          // near, depth is zero to one
+    planes[5] = row(3) - row(2); // far
+
+    for (auto &plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+void Frustum::cull(const Bounds &bounds, std::vector<uint32_t> &visible) const
+{
+    visible.clear();
+
+    // a box is outside when it is entirely behind any plane
+    // distance of the center plus the extent projected onto the plane normal
+#ifdef TAT_FRUSTUM_AVX
+    static const auto avx = hasAvx();
+    if (avx)
+    {
+        cullAvx(bounds, visible);
+        return;
+    }
+#endif
+#ifdef TAT_FRUSTUM_SSE
+    cullSse(bounds, visible);
+#else
+    cullScalar(bounds, visible);
+#endif
+}
+
+#ifdef TAT_FRUSTUM_AVX
+
+auto Frustum::hasAvx() -> bool
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    // the os must save the ymm registers as well
+    std::array<int, 4> info{};
+    __cpuid(info.data(), 1);
+    auto osxsave = (info[2] & (1 << 27)) != 0;
+    auto avx = (info[2] & (1 << 28)) != 0;
+    return osxsave && avx && (_xgetbv(0) & 0x6U) == 0x6U;
+#else
+    // checks the os saves the ymm registers as well
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+
+TAT_TARGET_AVX void Frustum::cullAvx(const Bounds &bounds, std::vector<uint32_t> &visible) const
+{
+    for (size_t i = 0; i < bounds.count; i += 8)
+    {
+        auto cx = _mm256_loadu_ps(&bounds.centerX[i]);
+        auto cy = _mm256_loadu_ps(&bounds.centerY[i]);
+        auto cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+        auto ex = _mm256_loadu_ps(&bounds.extentX[i]);
+        auto ey = _mm256_loadu_ps(&bounds.extentY[i]);
+        auto ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+
+        auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (auto &plane : planes)
+        {
+            auto nx = _mm256_set1_ps(plane.x);
+            auto ny = _mm256_set1_ps(plane.y);
+            auto nz = _mm256_set1_ps(plane.z);
+            auto distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)),
+                                          _mm256_add_ps(_mm256_mul_ps(nz, cz), _mm256_set1_ps(plane.w)));
+            auto radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::abs(plane.x)), ex),
+                                                      _mm256_mul_ps(_mm256_set1_ps(std::abs(plane.y)), ey)),
+                                        _mm256_mul_ps(_mm256_set1_ps(std::abs(plane.z)), ez));
+            inside = _mm256_and_ps(inside,
+                                   _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        auto mask = _mm256_movemask_ps(inside);
+        for (size_t j = 0; j < 8 && i + j < bounds.count; ++j)
+        {
+            if ((mask & (1 << j)) != 0)
+            {
+                visible.push_back(static_cast<uint32_t>(i + j));
+            }
+        }
+    }
+}
+
+#endif
+
+#ifdef TAT_FRUSTUM_SSE
+
+void Frustum::cullSse(const Bounds &bounds, std::vector<uint32_t> &visible) const
+{
+    for (size_t i = 0; i < bounds.count; i += 4)
+    {
+        auto cx = _mm_loadu_ps(&bounds.centerX[i]);
+        auto cy = _mm_loadu_ps(&bounds.centerY[i]);
+        auto cz = _mm_loadu_ps(&bounds.centerZ[i]);
+        auto ex = _mm_loadu_ps(&bounds.extentX[i]);
+        auto ey = _mm_loadu_ps(&bounds.extentY[i]);
+        auto ez = _mm_loadu_ps(&bounds.extentZ[i]);
+
+        auto inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+        for (auto &plane : planes)
+        {
+            auto distance =
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                           _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+            auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(plane.x)), ex),
+                                                _mm_mul_ps(_mm_set1_ps(std::abs(plane.y)), ey)),
+                                     _mm_mul_ps(_mm_set1_ps(std::abs(plane.z)), ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        auto mask = _mm_movemask_ps(inside);
+        for (size_t j = 0; j < 4 && i + j < bounds.count; ++j)
+        {
+            if ((mask & (1 << j)) != 0)
+            {
+                visible.push_back(static_cast<uint32_t>(i + j));
+            }
+        }
+    }
+}
+
+#endif
+
+void Frustum::cullScalar(const Bounds &bounds, std::vector<uint32_t> &visible) const
+{
+    for (size_t i = 0; i < bounds.count; ++i)
+    {
+        auto inside = true;
+        for (auto &plane : planes)
+        {
+            auto distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] +
+                            plane.w;
+            auto radius = std::abs(plane.x) * bounds.extentX[i] + std::abs(plane.y) * bounds.extentY[i] +
+                          std::abs(plane.z) * bounds.extentZ[i];
+            if (distance + radius < 0.F)
+            {
+                inside = false;
+                break;
+            }
+        }
+        if (inside)
+        {
+            visible.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+} // namespace tat
@@ -0,0 +1,230 @@
+#include "HotReload.hpp"
+#include "Config.hpp"
+#include "State.hpp"
+#include "Timer.hpp"
+#include "engine/Debug.hpp"
+
+#include <exception>
+#include <fstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+namespace
+{
+
+constexpr uint32_t spirvMagic = 0x07230203;
+
+// name of the entry a file under root belongs to, empty for files outside root or directly in it
+auto entryName(const std::string &path, const std::string &root) -> std::string
+{
+    if (root.empty() || path.compare(0, root.size(), root) != 0)
+    {
+        return "";
+    }
+    auto slash = path.find('/', root.size());
+    if (slash == std::string::npos)
+    {
+        return "";
+    }
+    return path.substr(root.size(), slash - root.size());
+}
+
+// name of a compiled shader directly in root, empty for anything else
+auto shaderName(const std::string &path, const std::string &root) -> std::string
+{
+    constexpr std::string_view extension = ".spv";
+    if (path.compare(0, root.size(), root) != 0 || path.find('/', root.size()) != std::string::npos ||
+        path.size() < root.size() + extension.size() ||
+        path.compare(path.size() - extension.size(), extension.size(), extension) != 0)
+    {
+        return "";
+    }
+    return path.substr(root.size());
+}
+
+// false for files left empty or half written by a compile, so the pipelines keep their modules
+auto spirv(const std::string &path) -> bool
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    auto size = static_cast<size_t>(file.tellg());
+    uint32_t magic = 0;
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    // five word header
+    return size >= 20 && size % 4 == 0 && magic == spirvMagic;
+}
+
+// reads the entry's edited config over the defaults into its record, and the state json a snapshot is saved from
+// false and a warning if it can't be read, the entry keeps its record
+template <typename T> auto reread(T *entry, const std::string &collection, const std::string &path) -> bool
+{
+    try
+    {
+        auto merged = Config{}.entry(collection, path);
+        entry->record = merged.template get<typename T::Record>();
+        State::instance().at(collection)[entry->name] = std::move(merged);
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::warn("Not reloading {}, {}", path, e.what());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void HotReload::create()
+{
+    auto &state = State::instance();
+    auto &settings = state.settings;
+    if (!settings.hotReload || state.engine.headless)
+    {
+        return;
+    }
+    watcher.create({settings.materialsPath, settings.meshesPath, settings.backdropsPath, shadersPath});
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Hot Reload");
+    }
+}
+
+void HotReload::destroy()
+{
+    watcher.destroy();
+    pending.clear();
+}
+
+void HotReload::update()
+{
+    auto changed = watcher.changes();
+    auto now = Timer::time();
+    if (!changed.empty())
+    {
+        pending.insert(changed.begin(), changed.end());
+        lastChange = now;
+    }
+    if (!pending.empty() && now - lastChange >= settleTime)
+    {
+        apply();
+    }
+}
+
+void HotReload::apply()
+{
+    auto &state = State::instance();
+    auto &settings = state.settings;
+
+    // entries that aren't loaded read the new files whenever they are, edited configs are read now
+    // so they load with the new record too
+    std::set<Material *> materials{};
+    std::set<Mesh *> meshes{};
+    auto backdrop = false;
+    std::set<std::string> shaders{};
+    for (auto &path : pending)
+    {
+        auto materialName = entryName(path, settings.materialsPath);
+        auto meshName = entryName(path, settings.meshesPath);
+        auto backdropName = entryName(path, settings.backdropsPath);
+        auto *material = state.materials.find(materialName);
+        auto *mesh = state.meshes.find(meshName);
+        auto *backdropEntry = state.backdrops.find(backdropName);
+        auto shader = shaderName(path, shadersPath);
+        if (material != nullptr)
+        {
+            auto config = path == settings.materialsPath + materialName + "/" + Config::materialFile;
+            if ((!config || reread(material, "materials", path)) && material->loaded)
+            {
+                materials.insert(material);
+            }
+        }
+        else if (mesh != nullptr)
+        {
+            auto config = path == settings.meshesPath + meshName + "/" + Config::meshFile;
+            if ((!config || reread(mesh, "meshes", path)) && mesh->loaded)
+            {
+                meshes.insert(mesh);
+            }
+        }
+        else if (backdropEntry != nullptr)
+        {
+            auto config = path == settings.backdropsPath + backdropName + "/" + Config::backdropFile;
+            if ((!config || reread(backdropEntry, "backdrops", path)) && backdropEntry == state.scene.backdrop)
+            {
+                backdrop = true;
+            }
+        }
+        else if (!shader.empty())
+        {
+            if (spirv(path))
+            {
+                shaders.insert(shader);
+            }
+            else
+            {
+                spdlog::warn("Not reloading {}, it is not SPIR-V", path);
+            }
+        }
+    }
+    pending.clear();
+    if (materials.empty() && meshes.empty() && !backdrop && shaders.empty())
+    {
+        return;
+    }
+
+    // nothing may be using what is replaced
+    auto &engine = state.engine;
+    engine.uploader.wait();
+    engine.device.wait();
+
+    for (auto *material : materials)
+    {
+        state.scene.reloadMaterial(material);
+    }
+    if (!meshes.empty())
+    {
+        state.scene.reloadMeshes({meshes.begin(), meshes.end()});
+    }
+    if (backdrop)
+    {
+        state.scene.reloadBackdrop();
+    }
+
+    auto uses = [&shaders](const std::string &program) {
+        return shaders.count(program + ".vert.spv") != 0 || shaders.count(program + ".frag.spv") != 0;
+    };
+    auto cull = shaders.count("cull.comp.spv") != 0 || shaders.count("meshlet.comp.spv") != 0;
+    state.scene.reloadPipelines(uses("scene"), uses("shadow"), cull);
+    if (uses("backdrop"))
+    {
+        state.scene.backdrop->reloadPipeline();
+    }
+    if (uses("ui"))
+    {
+        state.overlay.reloadPipeline();
+    }
+
+    // uploads run before the next frame's graphics work
+    engine.uploader.flush();
+    // drops changes made by the reload itself, like a packed map written next to its sources
+    watcher.changes();
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Reloaded {} materials, {} meshes, {} backdrops and {} shaders", materials.size(), meshes.size(),
+                     backdrop ? 1 : 0, shaders.size());
+    }
+}
+
+} // namespace tat
@@ -0,0 +1,141 @@
+#include "MappedFile.hpp"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tat
+{
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef WIN32
+
+auto MappedFile::open(const std::string &path) -> bool
+{
+    close();
+
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (GetFileSizeEx(file, &fileSize) == 0 || fileSize.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    mapped = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (mapped == nullptr)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::prefetch() const
+{
+    if (mapped != nullptr)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range{const_cast<uint8_t *>(mapped), length};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+}
+
+void MappedFile::close()
+{
+    if (mapped != nullptr)
+    {
+        UnmapViewOfFile(mapped);
+        mapped = nullptr;
+    }
+    if (mapping != nullptr)
+    {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+    length = 0;
+}
+
+#else
+
+auto MappedFile::open(const std::string &path) -> bool
+{
+    close();
+
+    auto descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat info
+    {
+    };
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+
+    // the mapping keeps its own reference to the file
+    auto *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (address == MAP_FAILED)
+    {
+        length = 0;
+        return false;
+    }
+
+    // read front to back once, let the kernel read ahead
+    madvise(address, length, MADV_SEQUENTIAL);
+    mapped = static_cast<const uint8_t *>(address);
+    return true;
+}
+
+void MappedFile::prefetch() const
+{
+    if (mapped != nullptr)
+    {
+        madvise(const_cast<uint8_t *>(mapped), length, MADV_WILLNEED);
+    }
+}
+
+void MappedFile::close()
+{
+    if (mapped != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(mapped), length);
+        mapped = nullptr;
+    }
+    length = 0;
+}
+
+#endif
+
+} // namespace tat
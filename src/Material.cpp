@@ -1,6 +1,9 @@
 #include "Material.hpp"
+#include "MaterialData.hpp"
 #include "State.hpp"
 
+#include <array>
+#include <exception>
 #include <filesystem>
 #include <memory>
 #include <type_traits>
@@ -14,22 +17,117 @@ Material::~Material()
 {
     diffuse.destroy();
     normal.destroy();
-    metallic.destroy();
-    roughness.destroy();
-    ao.destroy();
+    orm.destroy();
 }
 
 void Material::load()
 {
-    // get json for material
-    auto &material = State::instance().at("materials").at(name);
-    // load textures in json
-    loadImage(material.at("diffuse"), &diffuse);
-    loadImage(material.at("normal"), &normal);
-    loadImage(material.at("metallic"), &metallic);
-    loadImage(material.at("roughness"), &roughness);
-    loadImage(material.at("ao"), &ao);
-    scale = material.at("scale");
+    decode();
+    upload();
+}
+
+auto Material::reload() -> bool
+{
+    std::array<Image, 3> previous{diffuse, normal, orm};
+    diffuse = Image{};
+    normal = Image{};
+    orm = Image{};
+    try
+    {
+        load();
+    }
+    catch (std::exception &e)
+    {
+        spdlog::warn("Unable to reload Material {}: {}", name, e.what());
+        for (auto *image : images())
+        {
+            image->destroy();
+        }
+        diffuse = previous[0];
+        normal = previous[1];
+        orm = previous[2];
+        return false;
+    }
+    for (auto &image : previous)
+    {
+        image.destroy();
+    }
+    return true;
+}
+
+void Material::unload()
+{
+    for (auto *image : images())
+    {
+        image->destroy();
+    }
+    loaded = false;
+}
+
+auto Material::residentBytes() -> uint64_t
+{
+    if (!loaded)
+    {
+        return 0;
+    }
+    uint64_t bytes = 0;
+    for (auto *image : images())
+    {
+        bytes += image->residentSize(image->firstLevel);
+    }
+    return bytes;
+}
+
+void Material::decode()
+{
+    // files are relative to the material's directory
+    auto &state = State::instance();
+    auto path = state.settings.materialsPath + name + "/";
+
+    // the cooker packs ao, roughness and metallic ahead of time, otherwise they are packed once into the cache
+    auto ormPath = path + record.orm;
+    auto ao = path + record.ao;
+    auto roughness = path + record.roughness;
+    auto metallic = path + record.metallic;
+    if (!MaterialData::current(ormPath, {ao, roughness, metallic}))
+    {
+        auto cached = state.cache.entry({ao, roughness, metallic}, "", MaterialData::version, ".dds");
+        std::error_code error{};
+        if (!cached.empty() && std::filesystem::exists(cached, error))
+        {
+            ormPath = cached;
+        }
+        else
+        {
+            spdlog::warn("No current packed map for {}, packing", name);
+            MaterialData data{};
+            data.pack(ao, roughness, metallic);
+            if (!cached.empty() && state.cache.store(cached, [&data](auto &temporary) { data.cook(temporary); }))
+            {
+                ormPath = cached;
+            }
+            else
+            { // no cache, keep it next to the sources instead
+                data.cook(ormPath);
+            }
+        }
+    }
+
+    // read textures in json
+    decodeImage(state.cache.texture(path + record.diffuse), &diffuse);
+    decodeImage(state.cache.texture(path + record.normal), &normal);
+    decodeImage(ormPath, &orm);
+    scale = record.scale;
+}
+
+void Material::upload()
+{
+    // only coarse levels are resident to start with, the scene streams in finer ones as they are needed
+    auto startSize = State::instance().settings.textureStartSize;
+    for (auto *image : images())
+    {
+        uploadImage(image, image->levelFor(startSize));
+    }
     // we are now loaded
     loaded = true;
 
@@ -39,14 +137,18 @@ void Material::load()
     }
 }
 
-void Material::loadImage(const std::string &file, Image *image)
+void Material::decodeImage(const std::string &path, Image *image)
 {
-    auto path = State::instance().at("settings").at("materialsPath").get<std::string>();
     image->imageInfo.usage =
         vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
     image->memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
-    image->load(path + name + "/" + file);
+    image->decode(path);
+}
 
+void Material::uploadImage(Image *image, uint32_t firstLevel)
+{
+    image->upload(firstLevel);
+    image->samplerInfo.maxLod = static_cast<float>(image->imageInfo.mipLevels);
     image->createSampler();
 }
 
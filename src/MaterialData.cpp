@@ -0,0 +1,450 @@
+#include "MaterialData.hpp"
+#include "engine/TextureFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+namespace
+{
+
+using Color = std::array<float, 3>;
+
+// 565 color to 8 bits per channel
+auto expand(uint16_t color) -> Color
+{
+    auto r = (color >> 11U) & 31U;
+    auto g = (color >> 5U) & 63U;
+    auto b = color & 31U;
+    return {static_cast<float>(r << 3U | r >> 2U), static_cast<float>(g << 2U | g >> 4U),
+            static_cast<float>(b << 3U | b >> 2U)};
+}
+
+// BC3 color blocks always use four colors, BC1 ones only when color0 is above color1
+auto palette(uint16_t color0, uint16_t color1, bool fourColors) -> std::array<Color, 4>
+{
+    std::array<Color, 4> colors{expand(color0), expand(color1)};
+    for (size_t c = 0; c < 3; ++c)
+    {
+        if (fourColors || color0 > color1)
+        {
+            colors[2][c] = (2.F * colors[0][c] + colors[1][c]) / 3.F;
+            colors[3][c] = (colors[0][c] + 2.F * colors[1][c]) / 3.F;
+        }
+        else
+        { // 3 color mode, the fourth is black, transparent in BC1 with alpha
+            colors[2][c] = (colors[0][c] + colors[1][c]) / 2.F;
+            colors[3][c] = 0.F;
+        }
+    }
+    return colors;
+}
+
+// red channel of a BC1 color block, BC3 stores one after its alpha block
+void decodeBlock(const uint8_t *block, bool fourColors, uint8_t *red, uint32_t x, uint32_t y, uint32_t width,
+                 uint32_t height)
+{
+    auto color0 = static_cast<uint16_t>(block[0] | block[1] << 8U);
+    auto color1 = static_cast<uint16_t>(block[2] | block[3] << 8U);
+    auto colors = palette(color0, color1, fourColors);
+    uint32_t indices = block[4] | block[5] << 8U | block[6] << 16U | static_cast<uint32_t>(block[7]) << 24U;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        auto px = x + i % 4;
+        auto py = y + i / 4;
+        if (px < width && py < height)
+        {
+            red[py * width + px] = static_cast<uint8_t>(colors[(indices >> (2 * i)) & 3U][0]);
+        }
+    }
+}
+
+// red channel of a level, sources are greyscale so red is the value
+auto decodeRed(const TextureFile &file, uint32_t level) -> std::vector<uint8_t>
+{
+    auto extent = file.levelExtent(level);
+    auto *data = file.data(0, level);
+    std::vector<uint8_t> red(static_cast<size_t>(extent.width) * extent.height);
+    switch (file.format)
+    {
+    case vk::Format::eBc1RgbUnormBlock:
+    case vk::Format::eBc1RgbSrgbBlock:
+    case vk::Format::eBc1RgbaUnormBlock:
+    case vk::Format::eBc1RgbaSrgbBlock:
+    case vk::Format::eBc3UnormBlock:
+    case vk::Format::eBc3SrgbBlock: {
+        auto bc3 = file.format == vk::Format::eBc3UnormBlock || file.format == vk::Format::eBc3SrgbBlock;
+        auto blockSize = bc3 ? 16U : 8U;
+        auto colorOffset = blockSize - 8U;
+        for (uint32_t y = 0; y < extent.height; y += 4)
+        {
+            for (uint32_t x = 0; x < extent.width; x += 4)
+            {
+                decodeBlock(data + colorOffset, bc3, red.data(), x, y, extent.width, extent.height);
+                data += blockSize;
+            }
+        }
+        break;
+    }
+    case vk::Format::eR8G8B8A8Unorm:
+    case vk::Format::eR8G8B8A8Srgb:
+    case vk::Format::eB8G8R8A8Unorm:
+    case vk::Format::eB8G8R8A8Srgb:
+    case vk::Format::eR8Unorm: {
+        auto stride = file.format == vk::Format::eR8Unorm ? 1U : 4U;
+        auto channel = file.format == vk::Format::eB8G8R8A8Unorm || file.format == vk::Format::eB8G8R8A8Srgb ? 2U : 0U;
+        for (size_t i = 0; i < red.size(); ++i)
+        {
+            red[i] = data[i * stride + channel];
+        }
+        break;
+    }
+    default:
+        spdlog::error("Unable to decode format {} of material map", static_cast<uint32_t>(file.format));
+        throw std::runtime_error("Unable to decode material map");
+    }
+    return red;
+}
+
+// ao, roughness and metallic of each texel of a 4x4 block
+using Texels = std::array<std::array<uint8_t, 3>, 16>;
+
+// BC7 2 bit index weights, out of 64
+constexpr std::array<uint32_t, 4> weights = {0, 21, 43, 64};
+
+auto interpolate(uint32_t e0, uint32_t e1, uint32_t weight) -> uint32_t
+{
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6U;
+}
+
+// endpoints are stored with bits per channel and expanded by repeating their top bits
+auto quantize(float value, uint32_t bits) -> uint32_t
+{
+    auto top = static_cast<float>((1U << bits) - 1U);
+    return static_cast<uint32_t>(std::clamp(value, 0.F, 255.F) * top / 255.F + 0.5F);
+}
+
+auto widen(uint32_t value, uint32_t bits) -> uint32_t
+{
+    return value << (8 - bits) | value >> (2 * bits - 8);
+}
+
+// endpoints of a line through channels of the texels and the nearest of its four colors for each texel
+struct Line
+{
+    std::array<std::array<uint32_t, 3>, 2> endpoints{};
+    std::array<uint32_t, 16> indices{};
+    uint32_t error = 0;
+};
+
+void assign(const Texels &texels, uint32_t channels, uint32_t bits, Line &line)
+{
+    line.error = 0;
+    for (size_t i = 0; i < texels.size(); ++i)
+    {
+        auto best = UINT32_MAX;
+        for (uint32_t index = 0; index < weights.size(); ++index)
+        {
+            uint32_t error = 0;
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                auto value = interpolate(widen(line.endpoints[0][c], bits), widen(line.endpoints[1][c], bits),
+                                         weights[index]);
+                auto difference = static_cast<int32_t>(value) - texels[i][c];
+                error += static_cast<uint32_t>(difference * difference);
+            }
+            if (error < best)
+            {
+                best = error;
+                line.indices[i] = index;
+            }
+        }
+        line.error += best;
+    }
+}
+
+// the box corners along the main axis, then endpoints refit by least squares to the indices they gave
+auto fit(const Texels &texels, uint32_t channels, uint32_t bits) -> Line
+{
+    std::array<float, 3> mean{};
+    for (auto &texel : texels)
+    {
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            mean[c] += texel[c] / 16.F;
+        }
+    }
+    std::array<uint8_t, 3> low{255, 255, 255};
+    std::array<uint8_t, 3> high{};
+    uint32_t widest = 0;
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        for (auto &texel : texels)
+        {
+            low[c] = std::min(low[c], texel[c]);
+            high[c] = std::max(high[c], texel[c]);
+        }
+        if (high[c] - low[c] > high[widest] - low[widest])
+        {
+            widest = c;
+        }
+    }
+
+    Line line{};
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        // channels falling as the widest rises run the other way along the line
+        auto covariance = 0.F;
+        for (auto &texel : texels)
+        {
+            covariance += (texel[c] - mean[c]) * (texel[widest] - mean[widest]);
+        }
+        auto flip = covariance < 0.F;
+        line.endpoints[0][c] = quantize(flip ? high[c] : low[c], bits);
+        line.endpoints[1][c] = quantize(flip ? low[c] : high[c], bits);
+    }
+    assign(texels, channels, bits, line);
+
+    auto refit = line;
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        // minimizes the squared error of (1 - t) a + t b against each texel
+        float aa = 0.F, ab = 0.F, bb = 0.F, av = 0.F, bv = 0.F;
+        for (size_t i = 0; i < texels.size(); ++i)
+        {
+            auto t = static_cast<float>(weights[line.indices[i]]) / 64.F;
+            aa += (1.F - t) * (1.F - t);
+            ab += (1.F - t) * t;
+            bb += t * t;
+            av += (1.F - t) * texels[i][c];
+            bv += t * texels[i][c];
+        }
+        auto determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6F)
+        {
+            continue;
+        }
+        refit.endpoints[0][c] = quantize((bb * av - ab * bv) / determinant, bits);
+        refit.endpoints[1][c] = quantize((aa * bv - ab * av) / determinant, bits);
+    }
+    assign(texels, channels, bits, refit);
+    return refit.error < line.error ? refit : line;
+}
+
+// writes values to the block from its lowest bit up
+class BlockWriter
+{
+  public:
+    explicit BlockWriter(uint8_t *block) : block(block)
+    {
+    }
+
+    void write(uint32_t value, uint32_t bits)
+    {
+        for (uint32_t i = 0; i < bits; ++i, ++position)
+        {
+            block[position / 8] |= static_cast<uint8_t>(((value >> i) & 1U) << (position % 8));
+        }
+    }
+
+  private:
+    uint8_t *block;
+    uint32_t position = 0;
+};
+
+// the first texel's index must have its top bit clear, swapping the endpoints inverts every index
+void anchor(Line &line)
+{
+    if (line.indices[0] < 2)
+    {
+        return;
+    }
+    std::swap(line.endpoints[0], line.endpoints[1]);
+    for (auto &index : line.indices)
+    {
+        index = 3 - index;
+    }
+}
+
+// BC7 mode 5, an rgb line with 7 bit endpoints and a scalar with 8 bit ones, each with its own 2 bit indices
+// rotation swaps the scalar with one color channel when decoding, so one map gets endpoints and indices of its own
+// and the other two share the line, whichever map has them to itself with the least error is picked
+void encodeBlock(const Texels &texels, uint8_t *block)
+{
+    constexpr uint32_t colorBits = 7;
+    constexpr uint32_t scalarBits = 8;
+
+    auto best = UINT32_MAX;
+    uint32_t rotation = 0;
+    Line color{};
+    Line scalar{};
+    for (uint32_t channel = 0; channel < 3; ++channel)
+    {
+        // the channel swapped out decodes as alpha, which is left opaque
+        Texels lineTexels{};
+        Texels scalarTexels{};
+        for (size_t i = 0; i < texels.size(); ++i)
+        {
+            lineTexels[i] = texels[i];
+            lineTexels[i][channel] = 255;
+            scalarTexels[i][0] = texels[i][channel];
+        }
+        auto lineFit = fit(lineTexels, 3, colorBits);
+        auto scalarFit = fit(scalarTexels, 1, scalarBits);
+        if (lineFit.error + scalarFit.error < best)
+        {
+            best = lineFit.error + scalarFit.error;
+            rotation = channel + 1;
+            color = lineFit;
+            scalar = scalarFit;
+        }
+    }
+    anchor(color);
+    anchor(scalar);
+
+    std::fill(block, block + 16, 0);
+    BlockWriter writer(block);
+    writer.write(1U << 5U, 6);
+    writer.write(rotation, 2);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        writer.write(color.endpoints[0][c], colorBits);
+        writer.write(color.endpoints[1][c], colorBits);
+    }
+    writer.write(scalar.endpoints[0][0], scalarBits);
+    writer.write(scalar.endpoints[1][0], scalarBits);
+    for (auto *line : {&color, &scalar})
+    {
+        for (size_t i = 0; i < line->indices.size(); ++i)
+        {
+            writer.write(line->indices[i], i == 0 ? 1 : 2);
+        }
+    }
+}
+
+void open(TextureFile &file, const std::string &path)
+{
+    if (!file.open(path))
+    {
+        spdlog::error("Unable to load {}", path);
+        throw std::runtime_error("Unable to load material map");
+    }
+}
+
+} // namespace
+
+void MaterialData::pack(const std::string &ao, const std::string &roughness, const std::string &metallic)
+{
+    std::array<TextureFile, 3> sources{};
+    open(sources[0], ao);
+    open(sources[1], roughness);
+    open(sources[2], metallic);
+    width = sources[0].extent.width;
+    height = sources[0].extent.height;
+    levels = sources[0].levels;
+    for (auto &source : sources)
+    {
+        if (source.extent.width != width || source.extent.height != height)
+        {
+            spdlog::error("Material maps {}, {} and {} differ in size", ao, roughness, metallic);
+            throw std::runtime_error("Material maps differ in size");
+        }
+        levels = std::min(levels, source.levels);
+    }
+
+    blocks.clear();
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        // each source's mips already exist, so no filtering happens here
+        std::array<std::vector<uint8_t>, 3> channels{};
+        for (size_t c = 0; c < channels.size(); ++c)
+        {
+            channels[c] = decodeRed(sources[c], level);
+        }
+
+        // edge texels repeat to fill the blocks of levels narrower than 4
+        auto extent = sources[0].levelExtent(level);
+        for (uint32_t y = 0; y < extent.height; y += 4)
+        {
+            for (uint32_t x = 0; x < extent.width; x += 4)
+            {
+                Texels block{};
+                for (uint32_t i = 0; i < 16; ++i)
+                {
+                    auto px = std::min(x + i % 4, extent.width - 1);
+                    auto py = std::min(y + i / 4, extent.height - 1);
+                    for (size_t c = 0; c < channels.size(); ++c)
+                    {
+                        block[i][c] = channels[c][py * extent.width + px];
+                    }
+                }
+                blocks.resize(blocks.size() + 16);
+                encodeBlock(block, blocks.data() + blocks.size() - 16);
+            }
+        }
+    }
+}
+
+void MaterialData::cook(const std::string &path) const
+{
+    // BC7 has no legacy four cc, so the header is followed by a DX10 one
+    std::array<uint32_t, 37> header{};
+    header[0] = 0x20534444; // "DDS "
+    header[1] = 124;        // header size
+    // caps, height, width, pixel format, mip count and linear size are set
+    header[2] = 0x1U | 0x2U | 0x4U | 0x1000U | 0x20000U | 0x80000U;
+    header[3] = height;
+    header[4] = width;
+    // bytes of level 0
+    header[5] = ((width + 3) / 4) * ((height + 3) / 4) * 16;
+    header[7] = levels;
+    header[19] = 32;         // pixel format size
+    header[20] = 0x4U;       // four cc
+    header[21] = 0x30315844; // "DX10"
+    // texture, mipmap and complex caps
+    header[27] = 0x1000U | 0x400000U | 0x8U;
+    header[32] = 98; // DXGI_FORMAT_BC7_UNORM
+    header[33] = 3;  // 2d
+    header[35] = 1;  // array size
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        spdlog::error("Unable to open {}", path);
+        throw std::runtime_error("Unable to open packed material map");
+    }
+    file.write(reinterpret_cast<const char *>(header.data()), sizeof(header));
+    file.write(reinterpret_cast<const char *>(blocks.data()), static_cast<std::streamsize>(blocks.size()));
+}
+
+auto MaterialData::current(const std::string &path, const std::vector<std::string> &sources) -> bool
+{
+    std::error_code error{};
+    auto time = std::filesystem::last_write_time(path, error);
+    if (error)
+    {
+        return false;
+    }
+    // maps packed by an older version are in another format
+    TextureFile file{};
+    if (!file.map(path) || file.format != vk::Format::eBc7UnormBlock)
+    {
+        return false;
+    }
+    // missing sources are fine, the packed map can ship on its own
+    return std::all_of(sources.begin(), sources.end(), [&time](auto &source) {
+        std::error_code sourceError{};
+        auto sourceTime = std::filesystem::last_write_time(source, sourceError);
+        return sourceError || sourceTime <= time;
+    });
+}
+
+} // namespace tat
@@ -1,12 +1,8 @@
 #include "Mesh.hpp"
 #include "State.hpp"
 
-#include <memory>
-#include <stdexcept>
-
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
+#include <exception>
+#include <utility>
 
 #include <spdlog/spdlog.h>
 
@@ -15,41 +11,171 @@ namespace tat
 
 void Mesh::load()
 {
-    auto &mesh = State::instance().at("meshes").at(name);
-    size.x = mesh.at("size").at(0);
-    size.y = mesh.at("size").at(1);
-    size.z = mesh.at("size").at(2);
+    decode();
+    upload();
+}
+
+auto Mesh::reload() -> bool
+{
+    // decode only fills meshlets of large enough meshes, so start from none and put them back if it fails
+    std::vector<Meshlet> previousMeshlets{};
+    std::vector<uint32_t> previousVertices{};
+    std::vector<uint8_t> previousTriangles{};
+    std::swap(meshlets, previousMeshlets);
+    std::swap(meshletVertices, previousVertices);
+    std::swap(meshletTriangles, previousTriangles);
+    try
+    {
+        decode();
+    }
+    catch (std::exception &e)
+    {
+        spdlog::warn("Unable to reload Mesh {}: {}", name, e.what());
+        std::swap(meshlets, previousMeshlets);
+        std::swap(meshletVertices, previousVertices);
+        std::swap(meshletTriangles, previousTriangles);
+        return false;
+    }
+    buffers.vertex.destroy();
+    buffers.index.destroy();
+    upload();
+    return true;
+}
 
-    import(mesh.at("file"));
+void Mesh::unload()
+{
+    buffers.vertex.destroy();
+    buffers.index.destroy();
+    lods.clear();
+    meshlets.clear();
+    meshletVertices.clear();
+    meshletTriangles.clear();
+    decoded.reset();
+    loaded = false;
+}
 
-    // copy buffers to gpu only memory
-    Buffer stagingBuffer{};
-    stagingBuffer.flags = vk::BufferUsageFlagBits::eTransferSrc;
-    stagingBuffer.memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-    if constexpr (Debug::enable)
+auto Mesh::residentBytes() -> uint64_t
+{
+    if (!loaded)
     {
-        stagingBuffer.name = fmt::format("Mesh {} Staging", name);
+        return 0;
     }
+    return static_cast<uint64_t>(vertexCount) * vertexStride(layout) +
+           static_cast<uint64_t>(indexCount) * sizeof(uint32_t);
+}
 
-    //upload vertex data
-    stagingBuffer.update(data.vertices.data(), data.vertices.size() * sizeof(data.vertices[0]));
-    buffers.vertex.flags = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer;
-    buffers.vertex.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
-    if constexpr (Debug::enable)
+void Mesh::release()
+{
+    buffers.vertex.destroy();
+    buffers.index.destroy();
+}
+
+void Mesh::decode()
+{
+    auto &state = State::instance();
+    auto path = state.settings.meshesPath + name + "/" + record.file;
+    auto &requested = record.vertexLayout;
+    auto positionTolerance = record.positionTolerance;
+    auto uvTolerance = record.uvTolerance;
+    // smaller meshes are cheaper to draw whole than to cull per meshlet
+    auto meshletMinTriangles = state.settings.meshletMinTriangles;
+
+    // cooked files are mapped and copied straight into staging, no parsing
+    // one shipped next to the source goes first, then the cache
+    decoded = std::make_shared<Decoded>();
+    auto &file = decoded->file;
+    auto settings = MeshData::importSettings(requested, positionTolerance, uvTolerance);
+    const CookedMesh *header = nullptr;
+    if (file.open(MeshData::cookedPath(path)))
     {
-        buffers.vertex.name = "Mesh Vertex";
+        header = MeshData::cooked(file, path, settings);
+    }
+    std::string cached{};
+    if (header == nullptr)
+    {
+        cached = state.cache.entry({path}, settings, CookedMesh::currentVersion, ".mesh");
+        if (!cached.empty() && file.open(cached))
+        {
+            header = MeshData::cooked(file, "", settings);
+        }
+    }
+
+    if (header != nullptr)
+    {
+        vertexCount = header->vertexCount;
+        indexCount = header->indexCount;
+        center = header->center;
+        extent = header->extent;
+        bounds = header->bounds;
+        layout = header->layout;
+        decoded->vertices = file.data() + header->vertexOffset;
+        decoded->indices = file.data() + header->indexOffset;
+
+        auto *lodData = reinterpret_cast<const Lod *>(file.data() + header->lodOffset);
+        lods.assign(lodData, lodData + header->lodCount);
+        if (lods[0].indexCount / 3 >= meshletMinTriangles)
+        {
+            auto *meshletData = reinterpret_cast<const Meshlet *>(file.data() + header->meshletOffset);
+            auto *meshletVertexData = reinterpret_cast<const uint32_t *>(file.data() + header->meshletVertexOffset);
+            auto *meshletTriangleData = file.data() + header->meshletTriangleOffset;
+            meshlets.assign(meshletData, meshletData + header->meshletCount);
+            meshletVertices.assign(meshletVertexData, meshletVertexData + header->meshletVertexCount);
+            meshletTriangles.assign(meshletTriangleData, meshletTriangleData + header->meshletTriangleSize);
+        }
+    }
+    else
+    {
+        spdlog::warn("No current cooked mesh for {}, importing", path);
+        file.close();
+        auto &data = decoded->data;
+        data.import(path);
+        data.selectLayout(requested, positionTolerance, uvTolerance);
+        if (!cached.empty())
+        { // the next start maps this instead
+            state.cache.store(cached,
+                              [&data, &path, &settings](auto &temporary) { data.cook(path, settings, temporary); });
+        }
+        vertexCount = static_cast<uint32_t>(data.vertices.size());
+        indexCount = static_cast<uint32_t>(data.indices.size());
+        center = data.center;
+        extent = data.extent;
+        bounds = data.bounds;
+        layout = data.layout;
+        decoded->vertices = data.vertexData();
+        decoded->indices = data.indices.data();
+
+        lods = std::move(data.lods);
+        if (lods[0].indexCount / 3 >= meshletMinTriangles)
+        {
+            meshlets = std::move(data.meshlets);
+            meshletVertices = std::move(data.meshletVertices);
+            meshletTriangles = std::move(data.meshletTriangles);
+        }
+
+        if constexpr (Debug::enable)
+        {
+            spdlog::info("Optimized Mesh {} ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", name, data.original.acmr,
+                         data.optimized.acmr, data.original.atvr, data.optimized.atvr);
+        }
+    }
+    size = extent * 2.F;
+    if (layout == VertexLayout::Packed)
+    {
+        dequantize = MeshData::dequantize(center, extent);
     }
-    stagingBuffer.copyTo(buffers.vertex);
 
-    //upload index data
-    stagingBuffer.update(data.indices.data(), data.indices.size() * sizeof(data.indices[0]));
-    buffers.index.flags = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer;
-    buffers.index.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
     if constexpr (Debug::enable)
     {
-        buffers.index.name = "Mesh Index";
+        spdlog::info("Read Mesh {} with {} levels of detail{}{}", name, lods.size(),
+                     layout == VertexLayout::Packed ? " packed" : "", header != nullptr ? " from cooked file" : "");
     }
-    stagingBuffer.copyTo(buffers.index);
+}
+
+void Mesh::upload()
+{
+    createBuffers(decoded->vertices, decoded->indices);
+    // the file or imported data is in staging now
+    decoded.reset();
 
     loaded = true;
 
@@ -59,54 +185,35 @@ void Mesh::load()
     }
 }
 
-void Mesh::import(const std::string &file)
+void Mesh::createBuffers(const void *vertices, const void *indices)
 {
-    auto path = State::instance().at("settings").at("meshesPath").get<std::string>();
-    path = path + name + "/" + file;
-
-    Assimp::Importer importer;
-    auto processFlags = aiProcess_Triangulate | aiProcess_GenUVCoords | aiProcess_PreTransformVertices |
-                        aiProcess_JoinIdenticalVertices | aiProcess_ConvertToLeftHanded;
-    auto pScene = importer.ReadFile(path, processFlags);
+    // copy buffers to gpu only memory, the copies are batched and run with the next flush
+    auto &uploader = State::instance().engine.uploader;
 
-    const aiVector3D zero3D(0.F, 0.F, 0.F);
-
-    if (pScene == nullptr)
+    //upload vertex data
+    auto vertexSize = static_cast<vk::DeviceSize>(vertexCount) * vertexStride(layout);
+    // the scene copies it into its shared vertex buffers then frees it
+    buffers.vertex.flags = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc |
+                           vk::BufferUsageFlagBits::eVertexBuffer;
+    buffers.vertex.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+    if constexpr (Debug::enable)
     {
-        spdlog::error("Unable to load {}", path);
-        throw std::runtime_error("Unable to load mesh");
+        buffers.vertex.name = "Mesh Vertex";
     }
+    buffers.vertex.create(vertexSize);
+    uploader.copy(uploader.stage(vertices, vertexSize), buffers.vertex);
 
-    for (int i = 0; i < pScene->mNumMeshes; ++i)
+    //upload index data
+    auto indexSize = static_cast<vk::DeviceSize>(indexCount) * sizeof(uint32_t);
+    buffers.index.flags = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc |
+                          vk::BufferUsageFlagBits::eIndexBuffer;
+    buffers.index.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+    if constexpr (Debug::enable)
     {
-        auto aimesh = pScene->mMeshes[i];
-
-        for (int j = 0; j < aimesh->mNumFaces; ++j)
-        {
-            const aiFace *face = &aimesh->mFaces[j];
-            for (int k = 0; k < face->mNumIndices; ++k)
-            {
-                data.indices.push_back(face->mIndices[k]);
-            }
-        }
-
-        for (int j = 0; j < aimesh->mNumVertices; ++j)
-        {
-            auto pPosition = &aimesh->mVertices[j];
-            auto pUV = aimesh->HasTextureCoords(0) ? &aimesh->mTextureCoords[0][j] : &zero3D;
-            auto pNormal = &aimesh->mNormals[j];
-            Vertex vertex{};
-            vertex.position.x = pPosition->x;
-            vertex.position.y = pPosition->y;
-            vertex.position.z = pPosition->z;
-            vertex.UV.x = pUV->x;
-            vertex.UV.y = pUV->y;
-            vertex.normal.x = pNormal->x;
-            vertex.normal.y = pNormal->y;
-            vertex.normal.z = pNormal->z;
-            data.vertices.push_back(vertex);
-        }
+        buffers.index.name = "Mesh Index";
     }
+    buffers.index.create(indexSize);
+    uploader.copy(uploader.stage(indices, indexSize), buffers.index);
 }
 
-} // namespace tat
\ No newline at end of file
+} // namespace tat
@@ -0,0 +1,381 @@
+#include "MeshData.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <glm/gtc/packing.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+namespace
+{
+
+// importSettings covers these so changing them recooks cached meshes
+constexpr auto processFlags = aiProcess_Triangulate | aiProcess_GenUVCoords | aiProcess_PreTransformVertices |
+                              aiProcess_JoinIdenticalVertices | aiProcess_ConvertToLeftHanded;
+
+auto align(uint64_t offset) -> uint64_t
+{
+    return (offset + CookedMesh::alignment - 1) / CookedMesh::alignment * CookedMesh::alignment;
+}
+
+// 64 bit FNV-1a, stable across builds so shipped cooked files match
+auto hash(const std::string &settings) -> uint64_t
+{
+    uint64_t value = 0xCBF29CE484222325;
+    for (auto c : settings)
+    {
+        value = (value ^ static_cast<uint8_t>(c)) * 0x100000001B3;
+    }
+    return value;
+}
+
+auto sourceTime(const std::string &source) -> int64_t
+{
+    return static_cast<int64_t>(std::filesystem::last_write_time(source).time_since_epoch().count());
+}
+
+// flat meshes have no extent on an axis, keep the box scale invertible
+auto quantizationScale(const glm::vec3 &extent) -> glm::vec3
+{
+    return glm::max(extent, glm::vec3(1e-6F));
+}
+
+// unit vector onto the octahedron then the lower half folded over the diagonals into [-1, 1]
+auto octEncode(glm::vec3 normal) -> glm::vec2
+{
+    auto sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum == 0.F)
+    {
+        return glm::vec2(0.F);
+    }
+    normal /= sum;
+    auto encoded = glm::vec2(normal.x, normal.y);
+    if (normal.z < 0.F)
+    {
+        auto sign = glm::vec2(normal.x >= 0.F ? 1.F : -1.F, normal.y >= 0.F ? 1.F : -1.F);
+        encoded = (1.F - glm::abs(glm::vec2(normal.y, normal.x))) * sign;
+    }
+    return encoded;
+}
+
+} // namespace
+
+void MeshData::import(const std::string &path)
+{
+    Assimp::Importer importer;
+    auto pScene = importer.ReadFile(path, processFlags);
+
+    const aiVector3D zero3D(0.F, 0.F, 0.F);
+
+    if (pScene == nullptr)
+    {
+        spdlog::error("Unable to load {}", path);
+        throw std::runtime_error("Unable to load mesh");
+    }
+
+    // size everything up front instead of growing per vertex
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (unsigned int i = 0; i < pScene->mNumMeshes; ++i)
+    {
+        vertexCount += pScene->mMeshes[i]->mNumVertices;
+        indexCount += static_cast<size_t>(pScene->mMeshes[i]->mNumFaces) * 3;
+    }
+    vertices.clear();
+    indices.clear();
+    vertices.reserve(vertexCount);
+    indices.reserve(indexCount);
+
+    for (unsigned int i = 0; i < pScene->mNumMeshes; ++i)
+    {
+        auto aimesh = pScene->mMeshes[i];
+        // indices are per assimp mesh, offset them into the combined vertices
+        auto base = static_cast<uint32_t>(vertices.size());
+
+        for (unsigned int j = 0; j < aimesh->mNumFaces; ++j)
+        {
+            const aiFace *face = &aimesh->mFaces[j];
+            for (unsigned int k = 0; k < face->mNumIndices; ++k)
+            {
+                indices.push_back(base + face->mIndices[k]);
+            }
+        }
+
+        for (unsigned int j = 0; j < aimesh->mNumVertices; ++j)
+        {
+            auto pPosition = &aimesh->mVertices[j];
+            auto pUV = aimesh->HasTextureCoords(0) ? &aimesh->mTextureCoords[0][j] : &zero3D;
+            auto pNormal = &aimesh->mNormals[j];
+            Vertex vertex{};
+            vertex.position.x = pPosition->x;
+            vertex.position.y = pPosition->y;
+            vertex.position.z = pPosition->z;
+            vertex.UV.x = pUV->x;
+            vertex.UV.y = pUV->y;
+            vertex.normal.x = pNormal->x;
+            vertex.normal.y = pNormal->y;
+            vertex.normal.z = pNormal->z;
+            vertices.push_back(vertex);
+        }
+    }
+
+    optimize();
+    computeBounds();
+    MeshOptimizer::buildMeshlets(indices, vertices, meshlets, meshletVertices, meshletTriangles);
+    buildLods();
+}
+
+void MeshData::buildLods()
+{
+    lods.assign(1, Lod{0, static_cast<uint32_t>(indices.size()), 0.F});
+
+    auto radius = std::max(bounds.w, 1e-6F);
+    auto current = indices;
+    auto error = 0.F;
+    while (lods.size() < maxLods && current.size() / 3 >= minLodTriangles)
+    {
+        auto levelError = 0.F;
+        auto simplified =
+            MeshOptimizer::simplify(current, vertices, current.size() / 2, lodMaxError * radius, levelError);
+        // not worth a level unless it drops at least a tenth of the triangles
+        if (simplified.size() * 10 > current.size() * 9)
+        {
+            break;
+        }
+        MeshOptimizer::optimizeCache(simplified, vertices.size());
+
+        // each level is simplified from the last so their errors add up
+        error += levelError;
+        lods.push_back(
+            Lod{static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error / radius});
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        current = std::move(simplified);
+    }
+}
+
+void MeshData::optimize()
+{
+    original = MeshOptimizer::analyze(indices, vertices.size());
+    MeshOptimizer::optimizeCache(indices, vertices.size());
+    MeshOptimizer::optimizeOverdraw(indices, vertices);
+    MeshOptimizer::optimizeFetch(indices, vertices);
+    optimized = MeshOptimizer::analyze(indices, vertices.size());
+}
+
+void MeshData::selectLayout(const std::string &requested, float positionTolerance, float uvTolerance)
+{
+    if (requested != "auto" && requested != "full" && requested != "packed")
+    {
+        spdlog::error("Unknown vertex layout {}", requested);
+        throw std::runtime_error("Unknown vertex layout");
+    }
+
+    packed.clear();
+    layout = VertexLayout::Full;
+    if (requested == "full")
+    {
+        return;
+    }
+
+    auto scale = quantizationScale(extent);
+    auto positionError = 0.F;
+    auto uvError = 0.F;
+    packed.reserve(vertices.size());
+    for (auto &vertex : vertices)
+    {
+        PackedVertex packedVertex{};
+        packedVertex.position = glm::packSnorm4x16(glm::vec4((vertex.position - center) / scale, 0.F));
+        packedVertex.UV = glm::packHalf2x16(vertex.UV);
+        packedVertex.normal = glm::packSnorm2x16(octEncode(vertex.normal));
+        packed.push_back(packedVertex);
+
+        auto position = center + glm::vec3(glm::unpackSnorm4x16(packedVertex.position)) * scale;
+        auto positionDelta = glm::abs(position - vertex.position);
+        positionError = std::max({positionError, positionDelta.x, positionDelta.y, positionDelta.z});
+        auto uvDelta = glm::abs(glm::unpackHalf2x16(packedVertex.UV) - vertex.UV);
+        uvError = std::max({uvError, uvDelta.x, uvDelta.y});
+    }
+
+    if (requested == "auto" && (positionError > positionTolerance || uvError > uvTolerance))
+    {
+        packed.clear();
+        return;
+    }
+    layout = VertexLayout::Packed;
+}
+
+auto MeshData::vertexData() const -> const void *
+{
+    if (layout == VertexLayout::Packed)
+    {
+        return packed.data();
+    }
+    return vertices.data();
+}
+
+void MeshData::computeBounds()
+{
+    // box for cpu culling and physics, sphere around its center for gpu culling
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    auto low = vertices[0].position;
+    auto high = low;
+    for (auto &vertex : vertices)
+    {
+        low = glm::min(low, vertex.position);
+        high = glm::max(high, vertex.position);
+    }
+    center = (low + high) * 0.5F;
+    extent = (high - low) * 0.5F;
+    auto radius = 0.F;
+    for (auto &vertex : vertices)
+    {
+        radius = std::max(radius, glm::length(vertex.position - center));
+    }
+    bounds = glm::vec4(center, radius);
+}
+
+void MeshData::cook(const std::string &source, const std::string &settings, const std::string &path)
+{
+    CookedMesh header{};
+    header.vertexStride = vertexStride(layout);
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.sourceSize = std::filesystem::file_size(source);
+    header.sourceTime = sourceTime(source);
+    header.settingsHash = hash(settings);
+    header.vertexOffset = align(sizeof(CookedMesh));
+    header.indexOffset = align(header.vertexOffset + vertices.size() * header.vertexStride);
+    header.meshletCount = static_cast<uint32_t>(meshlets.size());
+    header.meshletVertexCount = static_cast<uint32_t>(meshletVertices.size());
+    header.meshletTriangleSize = static_cast<uint32_t>(meshletTriangles.size());
+    header.meshletOffset = align(header.indexOffset + indices.size() * sizeof(uint32_t));
+    header.meshletVertexOffset = align(header.meshletOffset + meshlets.size() * sizeof(Meshlet));
+    header.meshletTriangleOffset = align(header.meshletVertexOffset + meshletVertices.size() * sizeof(uint32_t));
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.lodOffset = align(header.meshletTriangleOffset + meshletTriangles.size());
+    header.bounds = bounds;
+    header.center = center;
+    header.extent = extent;
+    header.layout = layout;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        spdlog::error("Unable to open {}", path);
+        throw std::runtime_error("Unable to open cooked mesh");
+    }
+
+    const std::array<char, CookedMesh::alignment> padding{};
+    auto pad = [&file, &padding](uint64_t offset) {
+        auto position = static_cast<uint64_t>(file.tellp());
+        file.write(padding.data(), static_cast<std::streamsize>(offset - position));
+    };
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    pad(header.vertexOffset);
+    file.write(reinterpret_cast<const char *>(vertexData()),
+               static_cast<std::streamsize>(vertices.size() * header.vertexStride));
+    pad(header.indexOffset);
+    file.write(reinterpret_cast<const char *>(indices.data()),
+               static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+    pad(header.meshletOffset);
+    file.write(reinterpret_cast<const char *>(meshlets.data()),
+               static_cast<std::streamsize>(meshlets.size() * sizeof(Meshlet)));
+    pad(header.meshletVertexOffset);
+    file.write(reinterpret_cast<const char *>(meshletVertices.data()),
+               static_cast<std::streamsize>(meshletVertices.size() * sizeof(uint32_t)));
+    pad(header.meshletTriangleOffset);
+    file.write(reinterpret_cast<const char *>(meshletTriangles.data()),
+               static_cast<std::streamsize>(meshletTriangles.size()));
+    pad(header.lodOffset);
+    file.write(reinterpret_cast<const char *>(lods.data()), static_cast<std::streamsize>(lods.size() * sizeof(Lod)));
+
+    if (!file.good())
+    {
+        spdlog::error("Unable to write {}", path);
+        throw std::runtime_error("Unable to write cooked mesh");
+    }
+}
+
+auto MeshData::cookedPath(const std::string &source) -> std::string
+{
+    return std::filesystem::path(source).replace_extension(".mesh").string();
+}
+
+auto MeshData::importSettings(const std::string &requested, float positionTolerance, float uvTolerance)
+    -> std::string
+{
+    return fmt::format("{} {} {} {}", static_cast<uint32_t>(processFlags), requested, positionTolerance, uvTolerance);
+}
+
+auto MeshData::cooked(const MappedFile &file, const std::string &source, const std::string &settings)
+    -> const CookedMesh *
+{
+    if (file.size() < sizeof(CookedMesh))
+    {
+        return nullptr;
+    }
+
+    auto *header = reinterpret_cast<const CookedMesh *>(file.data());
+    if (header->magic != CookedMesh::magicValue || header->version != CookedMesh::currentVersion ||
+        static_cast<uint32_t>(header->layout) >= vertexLayoutCount ||
+        header->vertexStride != vertexStride(header->layout))
+    {
+        return nullptr;
+    }
+
+    // the requested layout and auto's tolerances decide which layout was picked
+    if (header->settingsHash != hash(settings))
+    {
+        return nullptr;
+    }
+
+    // a missing source is fine, the cooked file can ship on its own
+    std::error_code error{};
+    if (std::filesystem::exists(source, error))
+    {
+        if (header->sourceSize != std::filesystem::file_size(source) || header->sourceTime != sourceTime(source))
+        {
+            return nullptr;
+        }
+    }
+
+    // streams must lie inside the file
+    auto vertexEnd = header->vertexOffset + static_cast<uint64_t>(header->vertexCount) * header->vertexStride;
+    auto indexEnd = header->indexOffset + static_cast<uint64_t>(header->indexCount) * sizeof(uint32_t);
+    auto meshletEnd = header->meshletOffset + static_cast<uint64_t>(header->meshletCount) * sizeof(Meshlet);
+    auto meshletVertexEnd =
+        header->meshletVertexOffset + static_cast<uint64_t>(header->meshletVertexCount) * sizeof(uint32_t);
+    auto meshletTriangleEnd = header->meshletTriangleOffset + header->meshletTriangleSize;
+    auto lodEnd = header->lodOffset + static_cast<uint64_t>(header->lodCount) * sizeof(Lod);
+    if (vertexEnd > file.size() || indexEnd > file.size() || meshletEnd > file.size() ||
+        meshletVertexEnd > file.size() || meshletTriangleEnd > file.size() || lodEnd > file.size() ||
+        header->lodCount == 0)
+    {
+        return nullptr;
+    }
+    return header;
+}
+
+auto MeshData::dequantize(const glm::vec3 &center, const glm::vec3 &extent) -> glm::mat4
+{
+    return glm::scale(glm::translate(glm::mat4(1.F), center), quantizationScale(extent));
+}
+
+} // namespace tat
@@ -0,0 +1,673 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace tat
+{
+
+namespace
+{
+
+constexpr uint32_t none = UINT32_MAX;
+
+// Forsyth's scoring, recently used vertices and vertices with few triangles left score high
+constexpr float lastTriangleScore = 0.75F;
+constexpr float cacheDecayPower = 1.5F;
+constexpr float valenceBoostScale = 2.F;
+constexpr float valenceBoostPower = 0.5F;
+
+auto vertexScore(int32_t position, uint32_t valence) -> float
+{
+    if (valence == 0)
+    { // nothing left to draw with it
+        return -1.F;
+    }
+
+    auto score = 0.F;
+    if (position >= 0)
+    {
+        if (position < 3)
+        { // part of the last triangle, fixed score so strips aren't favored over fans
+            score = lastTriangleScore;
+        }
+        else
+        {
+            auto scale = 1.F / static_cast<float>(MeshOptimizer::cacheSize - 3);
+            score = std::pow(1.F - static_cast<float>(position - 3) * scale, cacheDecayPower);
+        }
+    }
+    return score + valenceBoostScale * std::pow(static_cast<float>(valence), -valenceBoostPower);
+}
+
+// sum of squared distances to a set of planes, symmetric 4x4 stored as its upper triangle
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+    void add(const Quadric &other)
+    {
+        a2 += other.a2, ab += other.ab, ac += other.ac, ad += other.ad, b2 += other.b2;
+        bc += other.bc, bd += other.bd, c2 += other.c2, cd += other.cd, d2 += other.d2;
+    }
+
+    void addPlane(const glm::vec3 &normal, float distance)
+    {
+        double a = normal.x, b = normal.y, c = normal.z, d = distance;
+        a2 += a * a, ab += a * b, ac += a * c, ad += a * d, b2 += b * b;
+        bc += b * c, bd += b * d, c2 += c * c, cd += c * d, d2 += d * d;
+    }
+
+    auto evaluate(const glm::vec3 &point) const -> double
+    {
+        double x = point.x, y = point.y, z = point.z;
+        auto error = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z) +
+                     2 * (ad * x + bd * y + cd * z) + d2;
+        // rounding can dip just below zero
+        return std::max(error, 0.0);
+    }
+};
+
+auto positionKey(const glm::vec3 &position) -> uint64_t
+{
+    std::array<uint32_t, 3> bits{};
+    std::memcpy(bits.data(), &position, sizeof(bits));
+    return (static_cast<uint64_t>(bits[0]) * 73856093) ^ (static_cast<uint64_t>(bits[1]) * 19349663) ^
+           (static_cast<uint64_t>(bits[2]) * 83492791);
+}
+
+// sphere around the meshlet's vertices and a cone around its triangle normals
+void meshletBounds(Meshlet &meshlet, const std::vector<uint32_t> &meshletVertices,
+                   const std::vector<uint8_t> &meshletTriangles, const std::vector<Vertex> &vertices)
+{
+    auto *local = &meshletVertices[meshlet.vertexOffset];
+    auto low = vertices[local[0]].position;
+    auto high = low;
+    for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+    {
+        low = glm::min(low, vertices[local[i]].position);
+        high = glm::max(high, vertices[local[i]].position);
+    }
+    auto center = (low + high) * 0.5F;
+    auto radius = 0.F;
+    for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+    {
+        radius = std::max(radius, glm::length(vertices[local[i]].position - center));
+    }
+    meshlet.bounds = glm::vec4(center, radius);
+
+    // winding isn't trusted for facing, geometric normals are flipped to agree with the vertex normals
+    std::vector<glm::vec3> normals{};
+    normals.reserve(meshlet.triangleCount);
+    auto axis = glm::vec3(0.F);
+    auto *triangles = &meshletTriangles[meshlet.triangleOffset];
+    for (uint32_t i = 0; i < meshlet.triangleCount; ++i)
+    {
+        auto &a = vertices[local[triangles[i * 3]]];
+        auto &b = vertices[local[triangles[i * 3 + 1]]];
+        auto &c = vertices[local[triangles[i * 3 + 2]]];
+        auto normal = glm::cross(b.position - a.position, c.position - a.position);
+        auto length = glm::length(normal);
+        if (length == 0.F)
+        {
+            continue;
+        }
+        normal /= length;
+        if (glm::dot(normal, a.normal + b.normal + c.normal) < 0.F)
+        {
+            normal = -normal;
+        }
+        normals.push_back(normal);
+        axis += normal;
+    }
+
+    // cutoff of 1 never culls
+    meshlet.cone = glm::vec4(0.F, 0.F, 0.F, 1.F);
+    auto length = glm::length(axis);
+    if (length == 0.F)
+    {
+        return;
+    }
+    axis /= length;
+    auto spread = 1.F;
+    for (auto &normal : normals)
+    {
+        spread = std::min(spread, glm::dot(axis, normal));
+    }
+    // normals spread past about 85 degrees from the axis leave no view that sees only back faces
+    if (spread > 0.1F)
+    {
+        meshlet.cone = glm::vec4(axis, std::sqrt(1.F - spread * spread));
+    }
+}
+
+} // namespace
+
+auto MeshOptimizer::analyze(const std::vector<uint32_t> &indices, size_t vertexCount) -> CacheStatistics
+{
+    // a vertex is in the fifo if fewer than fifoSize misses happened since it was loaded
+    std::vector<uint32_t> loaded(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    uint32_t misses = 0;
+    uint32_t unique = 0;
+    for (auto index : indices)
+    {
+        if (loaded[index] == 0 || misses + 1 - loaded[index] > fifoSize)
+        {
+            ++misses;
+            loaded[index] = misses;
+        }
+        if (!used[index])
+        {
+            used[index] = true;
+            ++unique;
+        }
+    }
+
+    CacheStatistics statistics{};
+    if (!indices.empty())
+    {
+        statistics.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+        statistics.atvr = static_cast<float>(misses) / static_cast<float>(unique);
+    }
+    return statistics;
+}
+
+void MeshOptimizer::optimizeCache(std::vector<uint32_t> &indices, size_t vertexCount)
+{
+    auto triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // triangles using each vertex, packed, the first valence entries of a vertex are the ones not yet drawn
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (auto index : indices)
+    {
+        ++valence[index];
+    }
+    std::vector<uint32_t> offsets(vertexCount, 0);
+    std::exclusive_scan(valence.begin(), valence.end(), offsets.begin(), 0U);
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        auto fill = offsets;
+        for (uint32_t i = 0; i < indices.size(); ++i)
+        {
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<int32_t> position(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        score[i] = vertexScore(-1, valence[i]);
+    }
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        triangleScore[i] = score[indices[i * 3]] + score[indices[i * 3 + 1]] + score[indices[i * 3 + 2]];
+    }
+    std::vector<bool> drawn(triangleCount, false);
+
+    std::vector<uint32_t> cache{};
+    std::vector<uint32_t> nextCache{};
+    cache.reserve(cacheSize + 3);
+    nextCache.reserve(cacheSize + 3);
+
+    std::vector<uint32_t> result{};
+    result.reserve(indices.size());
+
+    size_t cursor = 0;
+    auto best = none;
+    for (size_t drawnCount = 0; drawnCount < triangleCount; ++drawnCount)
+    {
+        if (best == none)
+        { // dead end, nothing in the cache has triangles left so take the next one in input order
+            while (drawn[cursor])
+            {
+                ++cursor;
+            }
+            best = static_cast<uint32_t>(cursor);
+        }
+
+        drawn[best] = true;
+        auto *triangle = &indices[static_cast<size_t>(best) * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+
+        // remove it from its vertices' remaining triangles
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            auto vertex = triangle[k];
+            auto *first = &adjacency[offsets[vertex]];
+            auto *last = first + valence[vertex];
+            auto found = std::find(first, last, best);
+            std::iter_swap(found, last - 1);
+            --valence[vertex];
+        }
+
+        // move its vertices to the front of the cache, anything pushed past cacheSize falls out
+        nextCache.assign(triangle, triangle + 3);
+        for (auto vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+            {
+                nextCache.push_back(vertex);
+            }
+        }
+        for (size_t i = cacheSize; i < nextCache.size(); ++i)
+        {
+            position[nextCache[i]] = -1;
+            score[nextCache[i]] = vertexScore(-1, valence[nextCache[i]]);
+        }
+        nextCache.resize(std::min<size_t>(nextCache.size(), cacheSize));
+        std::swap(cache, nextCache);
+
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            position[cache[i]] = static_cast<int32_t>(i);
+            score[cache[i]] = vertexScore(static_cast<int32_t>(i), valence[cache[i]]);
+        }
+
+        // only triangles touching the cache changed score, the best next one is among them
+        best = none;
+        auto bestScore = 0.F;
+        for (auto vertex : cache)
+        {
+            for (uint32_t i = 0; i < valence[vertex]; ++i)
+            {
+                auto candidate = adjacency[offsets[vertex] + i];
+                auto *corners = &indices[static_cast<size_t>(candidate) * 3];
+                triangleScore[candidate] = score[corners[0]] + score[corners[1]] + score[corners[2]];
+                if (triangleScore[candidate] > bestScore)
+                {
+                    bestScore = triangleScore[candidate];
+                    best = candidate;
+                }
+            }
+        }
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices,
+                                     float threshold)
+{
+    auto triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+    {
+        return;
+    }
+
+    // a cluster starts wherever the fifo missed all three vertices, the cache was effectively flushed there
+    // so clusters can be drawn in any order for about the same acmr
+    std::vector<uint32_t> clusters{};
+    {
+        std::vector<uint32_t> loaded(vertices.size(), 0);
+        uint32_t misses = 0;
+        for (uint32_t i = 0; i < triangleCount; ++i)
+        {
+            uint32_t triangleMisses = 0;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                auto index = indices[i * 3 + k];
+                if (loaded[index] == 0 || misses + 1 - loaded[index] > fifoSize)
+                {
+                    ++misses;
+                    ++triangleMisses;
+                    loaded[index] = misses;
+                }
+            }
+            if (i == 0 || triangleMisses == 3)
+            {
+                clusters.push_back(i);
+            }
+        }
+    }
+    if (clusters.size() < 2)
+    {
+        return;
+    }
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+    auto meshCenter = glm::vec3(0.F);
+    for (auto &vertex : vertices)
+    {
+        meshCenter += vertex.position;
+    }
+    meshCenter /= static_cast<float>(vertices.size());
+
+    // clusters facing away from the center occlude the rest, draw them first
+    std::vector<float> key(clusters.size() - 1);
+    for (size_t c = 0; c + 1 < clusters.size(); ++c)
+    {
+        auto center = glm::vec3(0.F);
+        auto normal = glm::vec3(0.F);
+        auto area = 0.F;
+        for (auto i = clusters[c]; i < clusters[c + 1]; ++i)
+        {
+            auto &a = vertices[indices[i * 3]].position;
+            auto &b = vertices[indices[i * 3 + 1]].position;
+            auto &p = vertices[indices[i * 3 + 2]].position;
+            // cross product length is twice the area, weights centroid and normal by it
+            auto cross = glm::cross(b - a, p - a);
+            auto weight = glm::length(cross);
+            center += (a + b + p) * (weight / 3.F);
+            normal += cross;
+            area += weight;
+        }
+        if (area > 0.F)
+        {
+            center /= area;
+        }
+        auto length = glm::length(normal);
+        key[c] = length > 0.F ? glm::dot(center - meshCenter, normal / length) : 0.F;
+    }
+
+    std::vector<uint32_t> order(key.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(), [&key](uint32_t a, uint32_t b) { return key[a] > key[b]; });
+
+    std::vector<uint32_t> result{};
+    result.reserve(indices.size());
+    for (auto c : order)
+    {
+        result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+
+    if (analyze(result, vertices.size()).acmr <= analyze(indices, vertices.size()).acmr * threshold)
+    {
+        indices.swap(result);
+    }
+}
+
+auto MeshOptimizer::simplify(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices,
+                              size_t targetIndexCount, float maxError, float &error) -> std::vector<uint32_t>
+{
+    auto vertexCount = vertices.size();
+    std::vector<uint32_t> result = indices;
+    error = 0.F;
+
+    // vertices sharing a position with another vertex sit on a uv or normal seam, moving one tears the surface
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<uint64_t, uint32_t> positions{};
+        for (uint32_t i = 0; i < vertexCount; ++i)
+        {
+            auto [first, inserted] = positions.try_emplace(positionKey(vertices[i].position), i);
+            if (!inserted && vertices[first->second].position == vertices[i].position)
+            {
+                locked[i] = true;
+                locked[first->second] = true;
+            }
+        }
+    }
+    // so do vertices on an edge only one triangle uses
+    {
+        std::unordered_map<uint64_t, uint32_t> edges{};
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                auto a = result[i + k];
+                auto b = result[i + (k + 1) % 3];
+                ++edges[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)];
+            }
+        }
+        for (auto &[edge, uses] : edges)
+        {
+            if (uses == 1)
+            {
+                locked[edge >> 32] = true;
+                locked[edge & UINT32_MAX] = true;
+            }
+        }
+    }
+
+    // planes of the original triangles around each vertex
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        auto &a = vertices[result[i]].position;
+        auto &b = vertices[result[i + 1]].position;
+        auto &c = vertices[result[i + 2]].position;
+        auto normal = glm::cross(b - a, c - a);
+        auto length = glm::length(normal);
+        if (length == 0.F)
+        {
+            continue;
+        }
+        normal /= length;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            quadrics[result[i + k]].addPlane(normal, -glm::dot(normal, a));
+        }
+    }
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+    auto maxCost = static_cast<double>(maxError) * maxError;
+    auto worst = 0.0;
+
+    // each pass collapses the cheapest edges whose neighborhoods don't overlap, then rebuilds
+    while (result.size() > targetIndexCount)
+    {
+        std::vector<uint32_t> valence(vertexCount, 0);
+        for (auto index : result)
+        {
+            ++valence[index];
+        }
+        std::vector<uint32_t> offsets(vertexCount, 0);
+        std::exclusive_scan(valence.begin(), valence.end(), offsets.begin(), 0U);
+        std::vector<uint32_t> adjacency(result.size());
+        {
+            auto fill = offsets;
+            for (uint32_t i = 0; i < result.size(); ++i)
+            {
+                adjacency[fill[result[i]]++] = i / 3;
+            }
+        }
+
+        std::vector<Collapse> collapses{};
+        collapses.reserve(result.size() * 2);
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                auto a = result[i + k];
+                auto b = result[i + (k + 1) % 3];
+                for (auto [from, to] : {std::pair(a, b), std::pair(b, a)})
+                {
+                    if (!locked[from])
+                    {
+                        auto quadric = quadrics[from];
+                        quadric.add(quadrics[to]);
+                        collapses.push_back({from, to, quadric.evaluate(vertices[to].position)});
+                    }
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+        // a collapse moves every triangle around from, none of their vertices can collapse again this pass
+        std::vector<bool> touched(vertexCount, false);
+        auto needed = (result.size() - targetIndexCount + 2) / 3;
+        size_t removed = 0;
+        for (auto &collapse : collapses)
+        {
+            if (collapse.cost > maxCost || removed >= needed)
+            {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+
+            // reject collapses that flip a triangle
+            auto flips = false;
+            for (uint32_t i = 0; i < valence[collapse.from] && !flips; ++i)
+            {
+                auto *triangle = &result[static_cast<size_t>(adjacency[offsets[collapse.from] + i]) * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    continue;
+                }
+                std::array<glm::vec3, 3> before{};
+                std::array<glm::vec3, 3> after{};
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    before[k] = vertices[triangle[k]].position;
+                    after[k] = triangle[k] == collapse.from ? vertices[collapse.to].position : before[k];
+                }
+                auto normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                auto normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                flips = glm::dot(normalBefore, normalAfter) <= 0.F;
+            }
+            if (flips)
+            {
+                continue;
+            }
+
+            for (uint32_t i = 0; i < valence[collapse.from]; ++i)
+            {
+                auto *triangle = &result[static_cast<size_t>(adjacency[offsets[collapse.from] + i]) * 3];
+                auto degenerate = false;
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    degenerate = degenerate || triangle[k] == collapse.to;
+                }
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    touched[triangle[k]] = true;
+                    if (triangle[k] == collapse.from)
+                    {
+                        triangle[k] = collapse.to;
+                    }
+                }
+                removed += degenerate ? 1 : 0;
+            }
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            worst = std::max(worst, collapse.cost);
+        }
+
+        if (removed == 0)
+        { // nothing left that is cheap enough and safe
+            break;
+        }
+
+        // drop triangles that lost a vertex
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            auto a = result[i];
+            auto b = result[i + 1];
+            auto c = result[i + 2];
+            if (a != b && b != c && a != c)
+            {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.resize(write);
+    }
+
+    error = static_cast<float>(std::sqrt(worst));
+    return result;
+}
+
+void MeshOptimizer::buildMeshlets(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices,
+                                  std::vector<Meshlet> &meshlets, std::vector<uint32_t> &meshletVertices,
+                                  std::vector<uint8_t> &meshletTriangles)
+{
+    meshlets.clear();
+    meshletVertices.clear();
+    meshletTriangles.clear();
+
+    constexpr uint8_t unused = UINT8_MAX;
+    // index of each vertex in the open meshlet
+    std::vector<uint8_t> local(vertices.size(), unused);
+    Meshlet meshlet{};
+
+    auto close = [&]() {
+        if (meshlet.triangleCount == 0)
+        {
+            return;
+        }
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+        {
+            local[meshletVertices[meshlet.vertexOffset + i]] = unused;
+        }
+        meshletBounds(meshlet, meshletVertices, meshletTriangles, vertices);
+        meshlets.push_back(meshlet);
+
+        // shaders read triangles as uints
+        meshletTriangles.resize((meshletTriangles.size() + 3) / 4 * 4, 0);
+        meshlet = Meshlet{};
+        meshlet.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+    };
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        auto a = indices[i];
+        auto b = indices[i + 1];
+        auto c = indices[i + 2];
+        uint32_t added = (local[a] == unused ? 1 : 0) + (local[b] == unused && b != a ? 1 : 0) +
+                         (local[c] == unused && c != a && c != b ? 1 : 0);
+        if (meshlet.vertexCount + added > maxMeshletVertices || meshlet.triangleCount == maxMeshletTriangles)
+        {
+            close();
+        }
+
+        for (auto vertex : {a, b, c})
+        {
+            if (local[vertex] == unused)
+            {
+                local[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+                meshletVertices.push_back(vertex);
+            }
+            meshletTriangles.push_back(local[vertex]);
+        }
+        ++meshlet.triangleCount;
+    }
+    close();
+}
+
+void MeshOptimizer::optimizeFetch(std::vector<uint32_t> &indices, std::vector<Vertex> &vertices)
+{
+    std::vector<uint32_t> remap(vertices.size(), none);
+    uint32_t next = 0;
+    for (auto &index : indices)
+    {
+        if (remap[index] == none)
+        {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    std::vector<Vertex> result(next);
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        if (remap[i] != none)
+        {
+            result[remap[i]] = vertices[i];
+        }
+    }
+    vertices.swap(result);
+}
+
+} // namespace tat
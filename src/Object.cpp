@@ -7,6 +7,8 @@ namespace tat
 
 void Object::update(float deltaTime)
 {
+    m_lastPosition = m_position;
+
     // mass of 0 means don't move
     if (m_mass > 0.F)
     {
@@ -70,6 +72,21 @@ void Object::update(float deltaTime)
     }
 }
 
+auto Object::model(float alpha) -> glm::mat4
+{
+    // mass of 0 means it never moves
+    if (m_mass <= 0.F)
+    {
+        return M;
+    }
+    return glm::translate(glm::mat4(1.F), position(alpha)) * R * S;
+}
+
+void Object::settle()
+{
+    m_lastPosition = m_position;
+}
+
 void Object::applyForce(glm::vec3 force)
 {
     m_force += force;
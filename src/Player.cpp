@@ -8,17 +8,18 @@ namespace tat
 
 void Player::create()
 {
-    auto &player = State::instance().at("player");
-    auto size = glm::vec3(0.5F, player.at("height").get<float>() * 2.F, 0.25F);
+    auto &player = State::instance().playerRecord;
+    auto size = glm::vec3(0.5F, player.height * 2.F, 0.25F);
     translate(size / 2.F);
     rotate();
     m_size = size;
-    m_mass = player.at("mass");
+    m_mass = player.mass;
+    settle();
 
-    jumpVelocity = glm::sqrt(2.0F * 9.8F * player.at("jumpHeight").get<float>());
-    velocityMax = player.at("velocityMax");
-    timeToReachVMax = player.at("timeToReachVMax");
-    timeToStopfromVMax = player.at("timeToStopFromVMax");
+    jumpVelocity = glm::sqrt(2.0F * 9.8F * player.jumpHeight);
+    velocityMax = player.velocityMax;
+    timeToReachVMax = player.timeToReachVMax;
+    timeToStopfromVMax = player.timeToStopFromVMax;
 
     if constexpr (Debug::enable)
     {
@@ -34,11 +35,8 @@ void Player::destroy()
     }
 }
 
-void Player::move(glm::vec2 direction, float deltaTime)
+void Player::move(glm::vec2 direction, glm::vec3 rotation, float deltaTime)
 {
-    auto &camera = State::instance().camera;
-
-    auto rotation = camera.rotation();
     auto camFront = glm::normalize(glm::vec3(-cos(glm::radians(rotation.x)) * sin(glm::radians(rotation.y)),
                                              sin(glm::radians(rotation.x)),
                                              cos(glm::radians(rotation.x)) * cos(glm::radians(rotation.y))));
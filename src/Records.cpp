@@ -0,0 +1,212 @@
+#include "Records.hpp"
+
+namespace tat
+{
+
+namespace
+{
+
+// vectors are arrays of three in json
+auto toVec3(const json &j) -> glm::vec3
+{
+    return glm::vec3(j.at(0).get<float>(), j.at(1).get<float>(), j.at(2).get<float>());
+}
+
+auto fromVec3(const glm::vec3 &v) -> json
+{
+    return {v.x, v.y, v.z};
+}
+
+} // namespace
+
+void from_json(const json &j, SettingsRecord &settings)
+{
+    j.at("zNear").get_to(settings.zNear);
+    j.at("zFar").get_to(settings.zFar);
+    j.at("FoV").get_to(settings.FoV);
+    j.at("mouseSensitivity").get_to(settings.mouseSensitivity);
+    j.at("window").get_to(settings.window);
+    j.at("vsync").get_to(settings.vsync);
+    j.at("shadowSize").get_to(settings.shadowSize);
+    j.at("recordModelsOnThread").get_to(settings.recordModelsOnThread);
+    j.at("headless").get_to(settings.headless);
+    j.at("headlessFrames").get_to(settings.headlessFrames);
+    j.at("dumpFrames").get_to(settings.dumpFrames);
+    j.at("dumpPath").get_to(settings.dumpPath);
+    j.at("statsPath").get_to(settings.statsPath);
+    j.at("profiler").get_to(settings.profiler);
+    j.at("profilerLog").get_to(settings.profilerLog);
+    j.at("simulationRate").get_to(settings.simulationRate);
+    j.at("simulationThread").get_to(settings.simulationThread);
+    j.at("stagingSize").get_to(settings.stagingSize);
+    j.at("loadThreads").get_to(settings.loadThreads);
+    j.at("textureStartSize").get_to(settings.textureStartSize);
+    j.at("textureBudget").get_to(settings.textureBudget);
+    j.at("meshletMinTriangles").get_to(settings.meshletMinTriangles);
+    j.at("lodPixelError").get_to(settings.lodPixelError);
+    j.at("shadowLodBias").get_to(settings.shadowLodBias);
+    j.at("hotReload").get_to(settings.hotReload);
+    j.at("memoryWatermark").get_to(settings.memoryWatermark);
+    j.at("brdfPath").get_to(settings.brdfPath);
+    j.at("playerConfig").get_to(settings.playerConfig);
+    j.at("sceneConfig").get_to(settings.sceneConfig);
+    j.at("materialsPath").get_to(settings.materialsPath);
+    j.at("meshesPath").get_to(settings.meshesPath);
+    j.at("backdropsPath").get_to(settings.backdropsPath);
+    j.at("cachePath").get_to(settings.cachePath);
+    j.at("configSnapshot").get_to(settings.configSnapshot);
+    j.at("modelsPath").get_to(settings.modelsPath);
+}
+
+void to_json(json &j, const SettingsRecord &settings)
+{
+    j["zNear"] = settings.zNear;
+    j["zFar"] = settings.zFar;
+    j["FoV"] = settings.FoV;
+    j["mouseSensitivity"] = settings.mouseSensitivity;
+    j["window"] = settings.window;
+    j["vsync"] = settings.vsync;
+    j["shadowSize"] = settings.shadowSize;
+    j["recordModelsOnThread"] = settings.recordModelsOnThread;
+    j["headless"] = settings.headless;
+    j["headlessFrames"] = settings.headlessFrames;
+    j["dumpFrames"] = settings.dumpFrames;
+    j["dumpPath"] = settings.dumpPath;
+    j["statsPath"] = settings.statsPath;
+    j["profiler"] = settings.profiler;
+    j["profilerLog"] = settings.profilerLog;
+    j["simulationRate"] = settings.simulationRate;
+    j["simulationThread"] = settings.simulationThread;
+    j["stagingSize"] = settings.stagingSize;
+    j["loadThreads"] = settings.loadThreads;
+    j["textureStartSize"] = settings.textureStartSize;
+    j["textureBudget"] = settings.textureBudget;
+    j["meshletMinTriangles"] = settings.meshletMinTriangles;
+    j["lodPixelError"] = settings.lodPixelError;
+    j["shadowLodBias"] = settings.shadowLodBias;
+    j["hotReload"] = settings.hotReload;
+    j["memoryWatermark"] = settings.memoryWatermark;
+    j["brdfPath"] = settings.brdfPath;
+    j["playerConfig"] = settings.playerConfig;
+    j["sceneConfig"] = settings.sceneConfig;
+    j["materialsPath"] = settings.materialsPath;
+    j["meshesPath"] = settings.meshesPath;
+    j["backdropsPath"] = settings.backdropsPath;
+    j["cachePath"] = settings.cachePath;
+    j["configSnapshot"] = settings.configSnapshot;
+    j["modelsPath"] = settings.modelsPath;
+}
+
+void from_json(const json &j, PlayerRecord &player)
+{
+    j.at("height").get_to(player.height);
+    j.at("mass").get_to(player.mass);
+    j.at("velocityMax").get_to(player.velocityMax);
+    j.at("timeToReachVMax").get_to(player.timeToReachVMax);
+    j.at("timeToStopFromVMax").get_to(player.timeToStopFromVMax);
+    j.at("jumpHeight").get_to(player.jumpHeight);
+}
+
+void to_json(json &j, const PlayerRecord &player)
+{
+    j["height"] = player.height;
+    j["mass"] = player.mass;
+    j["velocityMax"] = player.velocityMax;
+    j["timeToReachVMax"] = player.timeToReachVMax;
+    j["timeToStopFromVMax"] = player.timeToStopFromVMax;
+    j["jumpHeight"] = player.jumpHeight;
+}
+
+void from_json(const json &j, SceneRecord &scene)
+{
+    j.at("backdrop").get_to(scene.backdrop);
+    // the default scene has null for no models
+    if (!j.at("models").is_null())
+    {
+        j.at("models").get_to(scene.models);
+    }
+}
+
+void to_json(json &j, const SceneRecord &scene)
+{
+    j["backdrop"] = scene.backdrop;
+    j["models"] = scene.models;
+}
+
+void from_json(const json &j, BackdropRecord &backdrop)
+{
+    j.at("color").get_to(backdrop.color);
+    j.at("radiance").get_to(backdrop.radiance);
+    j.at("irradiance").get_to(backdrop.irradiance);
+    backdrop.light = toVec3(j.at("light"));
+    j.at("brightness").get_to(backdrop.brightness);
+}
+
+void to_json(json &j, const BackdropRecord &backdrop)
+{
+    j["color"] = backdrop.color;
+    j["radiance"] = backdrop.radiance;
+    j["irradiance"] = backdrop.irradiance;
+    j["light"] = fromVec3(backdrop.light);
+    j["brightness"] = backdrop.brightness;
+}
+
+void from_json(const json &j, MaterialRecord &material)
+{
+    j.at("diffuse").get_to(material.diffuse);
+    j.at("normal").get_to(material.normal);
+    j.at("metallic").get_to(material.metallic);
+    j.at("roughness").get_to(material.roughness);
+    j.at("ao").get_to(material.ao);
+    j.at("orm").get_to(material.orm);
+    j.at("scale").get_to(material.scale);
+}
+
+void to_json(json &j, const MaterialRecord &material)
+{
+    j["diffuse"] = material.diffuse;
+    j["normal"] = material.normal;
+    j["metallic"] = material.metallic;
+    j["roughness"] = material.roughness;
+    j["ao"] = material.ao;
+    j["orm"] = material.orm;
+    j["scale"] = material.scale;
+}
+
+void from_json(const json &j, MeshRecord &mesh)
+{
+    j.at("file").get_to(mesh.file);
+    j.at("vertexLayout").get_to(mesh.vertexLayout);
+    j.at("positionTolerance").get_to(mesh.positionTolerance);
+    j.at("uvTolerance").get_to(mesh.uvTolerance);
+}
+
+void to_json(json &j, const MeshRecord &mesh)
+{
+    j["file"] = mesh.file;
+    j["vertexLayout"] = mesh.vertexLayout;
+    j["positionTolerance"] = mesh.positionTolerance;
+    j["uvTolerance"] = mesh.uvTolerance;
+}
+
+void from_json(const json &j, ModelRecord &model)
+{
+    j.at("mesh").get_to(model.mesh);
+    j.at("material").get_to(model.material);
+    j.at("mass").get_to(model.mass);
+    model.position = toVec3(j.at("position"));
+    model.rotation = toVec3(j.at("rotation"));
+    model.scale = toVec3(j.at("scale"));
+}
+
+void to_json(json &j, const ModelRecord &model)
+{
+    j["mesh"] = model.mesh;
+    j["material"] = model.material;
+    j["mass"] = model.mass;
+    j["position"] = fromVec3(model.position);
+    j["rotation"] = fromVec3(model.rotation);
+    j["scale"] = fromVec3(model.scale);
+}
+
+} // namespace tat
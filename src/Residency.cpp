@@ -0,0 +1,93 @@
+#include "Residency.hpp"
+#include "State.hpp"
+#include "engine/Debug.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+void Residency::create()
+{
+    watermark = State::instance().settings.memoryWatermark;
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Residency with a watermark of {:.0f}%", watermark * 100.F);
+    }
+}
+
+void Residency::update()
+{
+    if (watermark <= 0.F)
+    {
+        return;
+    }
+    auto &state = State::instance();
+    auto &engine = state.engine;
+    auto budget = engine.allocator.budget();
+    auto limit = static_cast<vk::DeviceSize>(static_cast<double>(budget.budget) * watermark);
+    if (budget.usage <= limit)
+    {
+        warned = false;
+        return;
+    }
+    auto excess = budget.usage - limit;
+
+    struct Candidate
+    {
+        Entry *entry = nullptr;
+        uint64_t lastUse = 0;
+        uint64_t bytes = 0;
+    };
+    std::vector<Candidate> candidates{};
+    auto referenced = state.scene.referenced();
+    auto gather = [&](auto &collection) {
+        for (auto &resident : collection.resident())
+        {
+            // frames still in flight may have drawn anything got since
+            if (resident.bytes > 0 && resident.lastUse + Engine::maxFramesInFlight < engine.frameCount &&
+                referenced.count(resident.entry) == 0)
+            {
+                candidates.push_back({resident.entry, resident.lastUse, resident.bytes});
+            }
+        }
+    };
+    gather(state.materials);
+    gather(state.meshes);
+    gather(state.backdrops);
+    std::sort(candidates.begin(), candidates.end(),
+              [](auto &a, auto &b) { return a.lastUse < b.lastUse; });
+
+    uint64_t freed = 0;
+    size_t unloaded = 0;
+    for (auto &candidate : candidates)
+    {
+        if (freed >= excess)
+        {
+            break;
+        }
+        candidate.entry->unload();
+        freed += candidate.bytes;
+        ++unloaded;
+    }
+
+    if (freed < excess && !warned)
+    {
+        spdlog::warn("GPU memory is {} MiB past the watermark and the scene uses everything left",
+                     (excess - freed) / 1024 / 1024);
+        warned = true;
+    }
+    if constexpr (Debug::enable)
+    {
+        if (unloaded > 0)
+        {
+            spdlog::info("Unloaded {} entries freeing {} MiB", unloaded, freed / 1024 / 1024);
+        }
+    }
+}
+
+} // namespace tat
@@ -2,6 +2,13 @@
 #include "State.hpp"
 #include "engine/Debug.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
 #include <spdlog/spdlog.h>
 
 namespace tat
@@ -9,8 +16,11 @@ namespace tat
 
 void Scene::destroy()
 {
+    streamer.destroy();
     shadow.destroy();
     brdf.destroy();
+    uniforms.destroy();
+    culler.destroy();
 
     auto &device = State::instance().engine.device;
 
@@ -35,8 +45,14 @@ void Scene::destroy()
         shadowPool = nullptr;
     }
 
-    colorPipeline.destroy();
-    shadowPipeline.destroy();
+    for (auto &pipeline : colorPipelines)
+    {
+        pipeline.destroy();
+    }
+    for (auto &pipeline : shadowPipelines)
+    {
+        pipeline.destroy();
+    }
 
     if constexpr (Debug::enable)
     {
@@ -47,10 +63,17 @@ void Scene::destroy()
 // can't be constructor cause models require pointer to scene which wouldn't exist yet
 void Scene::create()
 {
+    auto &settings = State::instance().settings;
+    lodPixelError = settings.lodPixelError;
+    shadowLodBias = settings.shadowLodBias;
+
     createBrdf();
     createShadow();
     loadBackdrop();
     loadModels();
+    streamer.create(models);
+    createUniforms();
+    culler.create(models);
 
     createColorPool(); // needs stage/lights/actors to know number of descriptors
     createColorLayouts();
@@ -76,7 +99,10 @@ void Scene::cleanup()
         device.destroy(colorPool);
         colorPool = nullptr;
     }
-    colorPipeline.destroy();
+    for (auto &pipeline : colorPipelines)
+    {
+        pipeline.destroy();
+    }
 }
 
 void Scene::recreate()
@@ -90,12 +116,109 @@ void Scene::recreate()
     createColorPipeline();
 }
 
+void Scene::reloadMaterial(Material *material)
+{
+    streamer.detach(material);
+    auto reloaded = material->reload();
+    streamer.attach(material);
+    if (reloaded && std::find(materials.begin(), materials.end(), material) != materials.end())
+    {
+        updateColorSets();
+    }
+}
+
+void Scene::reloadMeshes(const std::vector<Mesh *> &meshes)
+{
+    std::unordered_set<Mesh *> reloaded{};
+    for (auto *mesh : meshes)
+    {
+        if (mesh->reload())
+        {
+            reloaded.insert(mesh);
+        }
+    }
+    if (reloaded.empty())
+    {
+        return;
+    }
+
+    {
+        // the simulation collides models by their size
+        auto lock = State::instance().simulation.lock();
+        for (auto *model : models)
+        {
+            if (reloaded.count(model->getMesh()) != 0)
+            {
+                model->updateSize();
+            }
+        }
+    }
+    // geometry, meshlets and index ranges live in the culler's buffers
+    culler.reloadMeshes();
+}
+
+void Scene::reloadBackdrop()
+{
+    if (!backdrop->reload())
+    {
+        return;
+    }
+    // every model samples its radiance and irradiance
+    updateColorSets();
+}
+
+void Scene::reloadPipelines(bool color, bool shadow, bool cull)
+{
+    if (color)
+    {
+        for (auto &pipeline : colorPipelines)
+        {
+            pipeline.destroy();
+        }
+        createColorPipeline();
+    }
+    if (shadow)
+    {
+        for (auto &pipeline : shadowPipelines)
+        {
+            pipeline.destroy();
+        }
+        createShadowPipeline();
+    }
+    if (cull)
+    {
+        culler.reloadPipeline();
+    }
+}
+
+auto Scene::referenced() -> std::unordered_set<const Entry *>
+{
+    std::unordered_set<const Entry *> entries{backdrop};
+    for (auto *model : models)
+    {
+        entries.insert(model);
+        entries.insert(model->getMaterial());
+        entries.insert(model->getMesh());
+    }
+    return entries;
+}
+
+auto Scene::references(const Entry *entry) -> bool
+{
+    if (entry == backdrop)
+    {
+        return true;
+    }
+    return std::any_of(models.begin(), models.end(), [entry](Model *model) {
+        return entry == model || entry == model->getMaterial() || entry == model->getMesh();
+    });
+}
+
 void Scene::createBrdf()
 {
-    auto &settings = State::instance().at("settings");
     brdf.imageInfo.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
     brdf.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
-    brdf.load(settings.at("brdfPath"));
+    brdf.load(State::instance().settings.brdfPath);
 
     brdf.samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
     brdf.samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
@@ -112,8 +235,7 @@ void Scene::createBrdf()
 
 void Scene::createShadow()
 {
-    auto &settings = State::instance().at("settings");
-    shadowSize = settings.at("shadowSize");
+    shadowSize = State::instance().settings.shadowSize;
     shadow.imageInfo.format = vk::Format::eR32G32Sfloat;
     shadow.imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eColorAttachment;
     shadow.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
@@ -136,19 +258,55 @@ void Scene::createShadow()
 void Scene::loadBackdrop()
 {
     auto &state = State::instance();
-    backdrop = state.backdrops.get(state.at("scene").at("backdrop"));
+    backdrop = state.backdrops.get(state.sceneRecord.backdrop);
 }
 
 void Scene::loadModels()
 {
     auto &state = State::instance();
-    auto &scene = state.at("scene");
-    for (auto &model : scene.at("models"))
+    auto &scene = state.sceneRecord;
+
+    // models depend on a mesh and a material, which don't depend on anything
+    // meshes and materials are read on the pool while the main thread uploads whichever finished first in queue order
+    std::vector<std::string> meshes{};
+    std::vector<std::string> materials{};
+    for (auto &name : scene.models)
     {
-        models.push_back(state.models.get(model.get<std::string>()));
+        if (auto *model = state.models.find(name))
+        {
+            meshes.push_back(model->record.mesh);
+            materials.push_back(model->record.material);
+        }
+    }
+
+    auto threads = state.settings.loadThreads;
+    if (threads == 0)
+    { // one per core, the main thread only uploads
+        threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    ThreadPool pool{};
+    pool.create(threads);
+    auto meshJobs = state.meshes.decode(meshes, pool);
+    auto materialJobs = state.materials.decode(materials, pool);
+    state.meshes.upload(meshJobs);
+    state.materials.upload(materialJobs);
+    pool.destroy();
+
+    // everything models need is loaded so this only places them
+    std::unordered_map<Material *, uint32_t> indices{};
+    for (auto &name : scene.models)
+    {
+        auto *model = state.models.get(name);
+        models.push_back(model);
+        auto [index, inserted] = indices.try_emplace(model->getMaterial(), static_cast<uint32_t>(materials.size()));
+        if (inserted)
+        {
+            materials.push_back(model->getMaterial());
+        }
+        materialIndices.push_back(index->second);
         if constexpr (Debug::enable)
         {
-            spdlog::info("Loaded Model {}", model.get<std::string>());
+            spdlog::info("Loaded Model {}", name);
         }
     }
 
@@ -158,43 +316,79 @@ void Scene::loadModels()
     }
 }
 
+void Scene::createUniforms()
+{
+    auto &engine = State::instance().engine;
+    // uniforms once then an instance of every model, at least one so its descriptor range is never empty
+    instances.resize(std::max<size_t>(1, models.size()));
+    auto frameSize = uniforms.align(sizeof(UniformFrag)) + uniforms.align(sizeof(UniformVert)) +
+                     uniforms.align(sizeof(UniformShad)) + uniforms.align(instances.size() * sizeof(ModelInstance));
+    uniforms.create(engine.swapChain.count, frameSize);
+}
+
 void Scene::drawColor(vk::CommandBuffer commandBuffer, uint32_t currentImage)
 {
-    backdrop->draw(commandBuffer, currentImage);
+    if (visibleColor.empty())
+    {
+        return;
+    }
 
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, colorPipeline.pipeline);
+    // layouts share a pipeline layout so the set stays bound when switching between them
+    // in binding order, vert, frag then instances
+    std::array<uint32_t, 3> dynamicOffsets = {vertOffset, fragOffset, instanceOffset};
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, colorPipelines[0].pipelineLayout, 0, 1,
+                                     &colorSet, dynamicOffsets.size(), dynamicOffsets.data());
+    commandBuffer.bindIndexBuffer(culler.indices(), 0, vk::IndexType::eUint32);
 
     std::array<VkDeviceSize, 1> offsets = {0};
-    for (auto &model : models)
+    for (uint32_t layout = 0; layout < vertexLayoutCount; ++layout)
     {
-        auto mesh = model->getMesh();
-        commandBuffer.bindVertexBuffers(0, 1, &mesh->buffers.vertex.buffer, offsets.data());
-        commandBuffer.bindIndexBuffer(mesh->buffers.index.buffer, 0, vk::IndexType::eUint32);
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, colorPipeline.pipelineLayout, 0, 1,
-                                         &model->colorSets[currentImage], 0, nullptr);
-        commandBuffer.drawIndexed(mesh->data.indices.size(), 1, 0, 0, 0);
+        auto vertices = culler.vertices(layout);
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, colorPipelines[layout].pipeline);
+        commandBuffer.bindVertexBuffers(0, 1, &vertices, offsets.data());
+        culler.drawColor(commandBuffer, currentImage, layout);
     }
 }
 
 void Scene::drawShadow(vk::CommandBuffer commandBuffer, uint32_t currentImage)
 {
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, shadowPipeline.pipeline);
+    if (visibleShadow.empty())
+    {
+        return;
+    }
+
+    std::array<uint32_t, 2> dynamicOffsets = {shadOffset, instanceOffset};
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, shadowPipelines[0].pipelineLayout, 0, 1,
+                                     &shadowSet, dynamicOffsets.size(), dynamicOffsets.data());
+    commandBuffer.bindIndexBuffer(culler.indices(), 0, vk::IndexType::eUint32);
 
     std::array<VkDeviceSize, 1> offsets = {0};
+    for (uint32_t layout = 0; layout < vertexLayoutCount; ++layout)
+    {
+        auto vertices = culler.vertices(layout);
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, shadowPipelines[layout].pipeline);
+        commandBuffer.bindVertexBuffers(0, 1, &vertices, offsets.data());
+        culler.drawShadow(commandBuffer, currentImage, layout);
+    }
+}
+
+void Scene::cull(vk::CommandBuffer commandBuffer, uint32_t currentImage)
+{
+    culler.dispatch(commandBuffer, currentImage);
+}
+
+void Scene::step(float deltaTime)
+{
     for (auto &model : models)
     {
-        auto mesh = model->getMesh();
-        commandBuffer.bindVertexBuffers(0, 1, &mesh->buffers.vertex.buffer, offsets.data());
-        commandBuffer.bindIndexBuffer(mesh->buffers.index.buffer, 0, vk::IndexType::eUint32);
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, shadowPipeline.pipelineLayout, 0, 1,
-                                         &model->shadowSets[currentImage], 0, nullptr);
-        commandBuffer.drawIndexed(mesh->data.indices.size(), 1, 0, 0, 0);
+        model->update(deltaTime);
     }
 }
 
-void Scene::update(uint32_t currentImage, float deltaTime)
+void Scene::update(uint32_t currentImage)
 {
-    auto &camera = State::instance().camera;
+    auto &state = State::instance();
+    auto &camera = state.camera;
     backdrop->update(currentImage);
 
     fragBuffer.position = glm::vec4(backdrop->light, 1.F);
@@ -206,25 +400,105 @@ void Scene::update(uint32_t currentImage, float deltaTime)
     fragBuffer.shadowSize = shadowSize;
     fragBuffer.brightness = backdrop->brightness;
 
-    for (auto &model : models)
+    uniforms.begin(currentImage);
+    fragOffset = uniforms.push(&fragBuffer, sizeof(fragBuffer));
+
+    vertBuffer.view = camera.view();
+    vertBuffer.projection = camera.projection();
+    vertBuffer.lightViewProjection = depthProjectionMatrix * depthViewMatrix;
+    vertBuffer.camPos = glm::vec4(-camera.position(), 1.F);
+    vertOffset = uniforms.push(&vertBuffer, sizeof(vertBuffer));
+
+    shadBuffer.view = depthViewMatrix;
+    shadBuffer.projection = depthProjectionMatrix;
+    shadOffset = uniforms.push(&shadBuffer, sizeof(shadBuffer));
+
     {
-        model->update(deltaTime);
-        // create mvp for player space
-        vertBuffer.model = model->model();
-        vertBuffer.view = camera.view();
-        vertBuffer.projection = camera.projection();
-        vertBuffer.normalMatrix = glm::transpose(glm::inverse(camera.projection() * camera.view() * model->model()));
-        vertBuffer.camPos = glm::vec4(-camera.position(), 1.F);
-        vertBuffer.uvScale = model->uvScale();
+        // models may be mid step on the simulation thread, only hold the lock while copying them out
+        auto lock = state.simulation.lock();
+        auto alpha = state.simulation.alpha();
+        transforms.resize(models.size());
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            transforms[i] = models[i]->model(alpha);
+        }
+    }
+
+    // both passes read these with the draw's first instance
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        auto &model = models[i];
+        auto &transform = transforms[i];
+        auto &instance = instances[i];
+        // packed positions are unpacked by the model matrix, normals don't need it
+        instance.model = transform * model->getMesh()->dequantize;
+        instance.normalMatrix = glm::transpose(glm::inverse(camera.projection() * camera.view() * transform));
+        instance.uvScale = model->uvScale();
+        instance.material = materialIndices[i];
+    }
+    instanceOffset = uniforms.push(instances.data(), instances.size() * sizeof(ModelInstance));
+    uniforms.end();
 
-        // create mvp for lightspace
-        shadBuffer.model = model->model();
-        shadBuffer.view = depthViewMatrix;
-        shadBuffer.projection = depthProjectionMatrix;
-        vertBuffer.lightMVP = depthProjectionMatrix * depthViewMatrix * model->model();
-        model->vertBuffers[currentImage].update(&vertBuffer, sizeof(vertBuffer));
-        model->fragBuffers[currentImage].update(&fragBuffer, sizeof(fragBuffer));
-        model->shadBuffers[currentImage].update(&shadBuffer, sizeof(shadBuffer));
+    colorFrustum.extract(camera.projection() * camera.view());
+    shadowFrustum.extract(depthProjectionMatrix * depthViewMatrix);
+    bounds.resize(models.size());
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        auto *mesh = models[i]->getMesh();
+        bounds.set(i, transforms[i], mesh->center, mesh->extent);
+    }
+    colorFrustum.cull(bounds, visibleColor);
+    shadowFrustum.cull(bounds, visibleShadow);
+    selectLods();
+    if (streamer.update(screenSizes))
+    {
+        swapColorSets();
+    }
+
+    // view translates by the camera position so the eye sits at its negation
+    culler.update(currentImage, transforms, colorFrustum, shadowFrustum, -camera.position(), visibleColor,
+                  visibleShadow, colorLods, shadowLods);
+}
+
+void Scene::selectLods()
+{
+    auto &state = State::instance();
+    auto &camera = state.camera;
+    auto eye = -camera.position();
+    // pixels a unit long covers at a distance of one
+    auto pixelsPerUnit = std::abs(camera.projection()[1][1]) * 0.5F * static_cast<float>(state.window.height);
+
+    colorLods.resize(models.size());
+    shadowLods.resize(models.size());
+    // textures of models off screen don't need any detail
+    screenSizes.assign(models.size(), 0.F);
+    std::vector<bool> visible(models.size(), false);
+    for (auto i : visibleColor)
+    {
+        visible[i] = true;
+    }
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        auto *mesh = models[i]->getMesh();
+        auto &transform = transforms[i];
+        auto center = glm::vec3(transform * glm::vec4(glm::vec3(mesh->bounds), 1.F));
+        auto scale = std::max({glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+                               glm::length(glm::vec3(transform[2]))});
+        auto radius = mesh->bounds.w * scale;
+        auto distance = std::max(glm::length(center - eye) - radius, camera.zNear);
+
+        // coarsest level whose error stays under the threshold on screen
+        auto lod = static_cast<uint32_t>(mesh->lods.size() - 1);
+        while (lod > 0 && mesh->lods[lod].error * radius * pixelsPerUnit / distance > lodPixelError)
+        {
+            --lod;
+        }
+        colorLods[i] = lod;
+        shadowLods[i] = std::min(lod + shadowLodBias, static_cast<uint32_t>(mesh->lods.size() - 1));
+        if (visible[i])
+        {
+            screenSizes[i] = 2.F * radius * pixelsPerUnit / distance;
+        }
     }
 }
 
@@ -232,19 +506,22 @@ void Scene::createColorPool()
 {
     auto &engine = State::instance().engine;
 
-    std::array<vk::DescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
-    // number of models * uniform buffers * swapchainimages
-    poolSizes[0].descriptorCount = models.size() * (2) * engine.swapChain.count;
+    std::array<vk::DescriptorPoolSize, 3> poolSizes{};
+    poolSizes[0].type = vk::DescriptorType::eUniformBufferDynamic;
+    // sets * uniform buffers
+    poolSizes[0].descriptorCount = 2 * 2;
     poolSizes[1].type = vk::DescriptorType::eCombinedImageSampler;
-    // number of models * imagesamplers * swapchainimages
-    poolSizes[1].descriptorCount = models.size() * 9 * engine.swapChain.count;
+    // sets * (textures of every material + shadow, irradiance, radiance and brdf)
+    poolSizes[1].descriptorCount = 2 * (3 * materialCount() + 4);
+    poolSizes[2].type = vk::DescriptorType::eStorageBufferDynamic;
+    // sets * instances
+    poolSizes[2].descriptorCount = 2;
 
     vk::DescriptorPoolCreateInfo poolInfo{};
     poolInfo.poolSizeCount = poolSizes.size();
     poolInfo.pPoolSizes = poolSizes.data();
-    // number of models * swapchainimages
-    poolInfo.maxSets = models.size() * engine.swapChain.count;
+    // two sets so streamed textures can be swapped in, dynamic offsets select the swapchain image's uniforms
+    poolInfo.maxSets = 2;
 
     colorPool = engine.device.create(poolInfo);
 
@@ -256,19 +533,30 @@ void Scene::createColorPool()
 
 void Scene::createColorLayouts()
 {
-    std::array<vk::DescriptorSetLayoutBinding, 11> bindings{};
+    auto &device = State::instance().engine.device;
+    auto &limits = State::instance().engine.physicalDevice.properties.limits;
+    // textures of every material plus shadow, irradiance, radiance and brdf
+    auto samplers = 3 * materialCount() + 4;
+    if (samplers > limits.maxPerStageDescriptorSamplers || samplers > limits.maxPerStageDescriptorSampledImages)
+    {
+        spdlog::error("Scene has {} materials, the device can only sample {} images per stage", materialCount(),
+                      std::min(limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages));
+        throw std::runtime_error("Too many materials in scene");
+    }
+
+    std::array<vk::DescriptorSetLayoutBinding, 10> bindings{};
 
     // UniformBuffer
     bindings[0].binding = 0;
     bindings[0].descriptorCount = 1;
-    bindings[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+    bindings[0].descriptorType = vk::DescriptorType::eUniformBufferDynamic;
     bindings[0].pImmutableSamplers = nullptr;
     bindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex;
 
     // uLight
     bindings[1].binding = 1;
     bindings[1].descriptorCount = 1;
-    bindings[1].descriptorType = vk::DescriptorType::eUniformBuffer;
+    bindings[1].descriptorType = vk::DescriptorType::eUniformBufferDynamic;
     bindings[1].pImmutableSamplers = nullptr;
     bindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
@@ -279,67 +567,59 @@ void Scene::createColorLayouts()
     bindings[2].pImmutableSamplers = nullptr;
     bindings[2].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-    // diffuse
+    // diffuse of every material
     bindings[3].binding = 3;
-    bindings[3].descriptorCount = 1;
+    bindings[3].descriptorCount = materialCount();
     bindings[3].descriptorType = vk::DescriptorType::eCombinedImageSampler;
     bindings[3].pImmutableSamplers = nullptr;
     bindings[3].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-    // normal
+    // normal of every material
     bindings[4].binding = 4;
-    bindings[4].descriptorCount = 1;
+    bindings[4].descriptorCount = materialCount();
     bindings[4].descriptorType = vk::DescriptorType::eCombinedImageSampler;
     bindings[4].pImmutableSamplers = nullptr;
     bindings[4].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-    // roughness
+    // ao, roughness and metallic of every material
     bindings[5].binding = 5;
-    bindings[5].descriptorCount = 1;
+    bindings[5].descriptorCount = materialCount();
     bindings[5].descriptorType = vk::DescriptorType::eCombinedImageSampler;
     bindings[5].pImmutableSamplers = nullptr;
     bindings[5].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-    // metallic
-    bindings[6].binding = 6;
+    // irradiance
     bindings[6].descriptorCount = 1;
+    bindings[6].binding = 6;
     bindings[6].descriptorType = vk::DescriptorType::eCombinedImageSampler;
     bindings[6].pImmutableSamplers = nullptr;
     bindings[6].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-    // ao
-    bindings[7].binding = 7;
+    // radiance
     bindings[7].descriptorCount = 1;
+    bindings[7].binding = 7;
     bindings[7].descriptorType = vk::DescriptorType::eCombinedImageSampler;
     bindings[7].pImmutableSamplers = nullptr;
     bindings[7].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-    // irradiance
+    // brdf pregenned texture
     bindings[8].descriptorCount = 1;
     bindings[8].binding = 8;
     bindings[8].descriptorType = vk::DescriptorType::eCombinedImageSampler;
     bindings[8].pImmutableSamplers = nullptr;
     bindings[8].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-    // radiance
+    // model instances
     bindings[9].descriptorCount = 1;
     bindings[9].binding = 9;
-    bindings[9].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    bindings[9].descriptorType = vk::DescriptorType::eStorageBufferDynamic;
     bindings[9].pImmutableSamplers = nullptr;
-    bindings[9].stageFlags = vk::ShaderStageFlagBits::eFragment;
-
-    // brdf pregenned texture
-    bindings[10].descriptorCount = 1;
-    bindings[10].binding = 10;
-    bindings[10].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-    bindings[10].pImmutableSamplers = nullptr;
-    bindings[10].stageFlags = vk::ShaderStageFlagBits::eFragment;
+    bindings[9].stageFlags = vk::ShaderStageFlagBits::eVertex;
 
     vk::DescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.bindingCount = bindings.size();
     layoutInfo.pBindings = bindings.data();
 
-    auto &device = State::instance().engine.device;
     colorLayout = device.create(layoutInfo);
 
     if constexpr (Debug::enable)
@@ -350,40 +630,155 @@ void Scene::createColorLayouts()
 
 void Scene::createColorSets()
 {
-    for (auto &model : models)
-    {
-        model->createColorSets(colorPool, colorLayout);
+    auto &engine = State::instance().engine;
+    std::array<vk::DescriptorSetLayout, 2> layouts{colorLayout, colorLayout};
+    vk::DescriptorSetAllocateInfo allocInfo{};
+    allocInfo.descriptorPool = colorPool;
+    allocInfo.descriptorSetCount = layouts.size();
+    allocInfo.pSetLayouts = layouts.data();
+
+    auto sets = engine.device.create(allocInfo);
+    colorSet = sets[0];
+    spareColorSet = sets[1];
+
+    if constexpr (Debug::enable)
+    { // only do this if validation is enabled
+        Debug::setName(engine.device.device, colorSet, "Scene Color Set");
+        Debug::setName(engine.device.device, spareColorSet, "Scene Spare Color Set");
     }
+
+    updateColorSets();
 }
 
-void Scene::createColorPipeline()
+void Scene::swapColorSets()
+{
+    writeColorSet(spareColorSet);
+    std::swap(colorSet, spareColorSet);
+}
+
+void Scene::updateColorSets()
+{
+    writeColorSet(colorSet);
+    writeColorSet(spareColorSet);
+}
+
+void Scene::writeColorSet(vk::DescriptorSet set)
 {
     auto &engine = State::instance().engine;
-    colorPipeline.descriptorSetLayout = &colorLayout;
 
-    auto vertPath = "assets/shaders/scene.vert.spv";
-    auto fragPath = "assets/shaders/scene.frag.spv";
-    colorPipeline.vertShader = engine.createShaderModule(vertPath);
-    colorPipeline.fragShader = engine.createShaderModule(fragPath);
+    // offsets into the arena are supplied when the set is bound
+    vk::DescriptorBufferInfo vertexInfo{};
+    vertexInfo.buffer = uniforms.buffer();
+    vertexInfo.offset = 0;
+    vertexInfo.range = sizeof(UniformVert);
+
+    vk::DescriptorBufferInfo fragInfo{};
+    fragInfo.buffer = uniforms.buffer();
+    fragInfo.offset = 0;
+    fragInfo.range = sizeof(UniformFrag);
+
+    vk::DescriptorBufferInfo instanceInfo{};
+    instanceInfo.buffer = uniforms.buffer();
+    instanceInfo.offset = 0;
+    instanceInfo.range = instances.size() * sizeof(ModelInstance);
+
+    auto imageInfo = [](Image &image) {
+        return vk::DescriptorImageInfo{image.sampler, image.imageView, vk::ImageLayout::eShaderReadOnlyOptimal};
+    };
+    // material arrays in the order the shaders index them
+    std::array<std::vector<vk::DescriptorImageInfo>, 3> materialInfos{};
+    for (auto *material : materials)
+    {
+        auto images = material->images();
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            materialInfos[i].push_back(imageInfo(*images[i]));
+        }
+    }
+    std::array<vk::DescriptorImageInfo, 4> sceneInfos = {imageInfo(shadow), imageInfo(backdrop->irradianceMap),
+                                                         imageInfo(backdrop->radianceMap), imageInfo(brdf)};
+    std::array<uint32_t, 4> sceneBindings = {2, 6, 7, 8};
+
+    std::vector<vk::WriteDescriptorSet> descriptorWrites{};
+    auto write = [&descriptorWrites, set](uint32_t binding, vk::DescriptorType type, uint32_t count) -> auto & {
+        auto &descriptorWrite = descriptorWrites.emplace_back();
+        descriptorWrite.dstSet = set;
+        descriptorWrite.dstBinding = binding;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = type;
+        descriptorWrite.descriptorCount = count;
+        return descriptorWrite;
+    };
+
+    // vert and frag uniform buffers, model instances
+    write(0, vk::DescriptorType::eUniformBufferDynamic, 1).pBufferInfo = &vertexInfo;
+    write(1, vk::DescriptorType::eUniformBufferDynamic, 1).pBufferInfo = &fragInfo;
+    write(9, vk::DescriptorType::eStorageBufferDynamic, 1).pBufferInfo = &instanceInfo;
+
+    // diffuse, normal then ao, roughness and metallic, nothing to write without materials
+    for (uint32_t i = 0; i < materialInfos.size() && !materials.empty(); ++i)
+    {
+        auto count = static_cast<uint32_t>(materialInfos[i].size());
+        write(3 + i, vk::DescriptorType::eCombinedImageSampler, count).pImageInfo = materialInfos[i].data();
+    }
 
-    colorPipeline.loadDefaults(engine.colorPass.renderPass);
+    // shadow, irradiance, radiance and pregenned brdf
+    for (size_t i = 0; i < sceneInfos.size(); ++i)
+    {
+        write(sceneBindings[i], vk::DescriptorType::eCombinedImageSampler, 1).pImageInfo = &sceneInfos[i];
+    }
 
-    colorPipeline.shaderStages = {colorPipeline.vertShaderStageInfo, colorPipeline.fragShaderStageInfo};
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescrption = Vertex::getAttributeDescriptions();
-    colorPipeline.vertexInputInfo.vertexBindingDescriptionCount = 1;
-    colorPipeline.vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    colorPipeline.vertexInputInfo.vertexAttributeDescriptionCount = attributeDescrption.size();
-    colorPipeline.vertexInputInfo.pVertexAttributeDescriptions = attributeDescrption.data();
+    engine.device.update(descriptorWrites);
+}
 
-    colorPipeline.create();
+void Scene::createColorPipeline()
+{
+    auto &engine = State::instance().engine;
 
-    if constexpr (Debug::enable)
-    { // only do this if validation is enabled
-        Debug::setName(engine.device.device, colorPipeline.vertShader, "Scene Vert Shader");
-        Debug::setName(engine.device.device, colorPipeline.fragShader, "Scene Frag Shader");
-        Debug::setName(engine.device.device, colorPipeline.pipeline, "Scene Color Pipeline");
-        Debug::setName(engine.device.device, colorPipeline.pipelineLayout, "Scene Color PipelineLayout");
+    for (uint32_t i = 0; i < vertexLayoutCount; ++i)
+    {
+        auto &colorPipeline = colorPipelines[i];
+        auto packed = static_cast<VertexLayout>(i) == VertexLayout::Packed;
+        colorPipeline.descriptorSetLayout = &colorLayout;
+
+        auto vertPath = "assets/shaders/scene.vert.spv";
+        auto fragPath = "assets/shaders/scene.frag.spv";
+        colorPipeline.vertShader = engine.createShaderModule(vertPath);
+        colorPipeline.fragShader = engine.createShaderModule(fragPath);
+
+        colorPipeline.loadDefaults(engine.colorPass.renderPass);
+
+        // scene.vert decodes octahedral normals when packedVertices is set
+        // scene.frag sizes its texture arrays with materialCount
+        std::array<uint32_t, 2> constants = {packed ? VK_TRUE : VK_FALSE, materialCount()};
+        std::array<vk::SpecializationMapEntry, 2> specializationEntries = {
+            vk::SpecializationMapEntry{0, 0, sizeof(VkBool32)},
+            vk::SpecializationMapEntry{1, sizeof(VkBool32), sizeof(uint32_t)}};
+        vk::SpecializationInfo specializationInfo{specializationEntries.size(), specializationEntries.data(),
+                                                  sizeof(constants), constants.data()};
+        colorPipeline.vertShaderStageInfo.pSpecializationInfo = &specializationInfo;
+        colorPipeline.fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+        colorPipeline.shaderStages = {colorPipeline.vertShaderStageInfo, colorPipeline.fragShaderStageInfo};
+        auto bindingDescription = packed ? PackedVertex::getBindingDescription() : Vertex::getBindingDescription();
+        auto attributeDescrption =
+            packed ? PackedVertex::getAttributeDescriptions() : Vertex::getAttributeDescriptions();
+        colorPipeline.vertexInputInfo.vertexBindingDescriptionCount = 1;
+        colorPipeline.vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+        colorPipeline.vertexInputInfo.vertexAttributeDescriptionCount = attributeDescrption.size();
+        colorPipeline.vertexInputInfo.pVertexAttributeDescriptions = attributeDescrption.data();
+
+        colorPipeline.create();
+
+        if constexpr (Debug::enable)
+        { // only do this if validation is enabled
+            std::string suffix = packed ? " Packed" : "";
+            Debug::setName(engine.device.device, colorPipeline.vertShader, "Scene Vert Shader" + suffix);
+            Debug::setName(engine.device.device, colorPipeline.fragShader, "Scene Frag Shader" + suffix);
+            Debug::setName(engine.device.device, colorPipeline.pipeline, "Scene Color Pipeline" + suffix);
+            Debug::setName(engine.device.device, colorPipeline.pipelineLayout,
+                           "Scene Color PipelineLayout" + suffix);
+        }
     }
 }
 
@@ -391,16 +786,17 @@ void Scene::createShadowPool()
 {
     auto &engine = State::instance().engine;
 
-    std::array<vk::DescriptorPoolSize, 1> poolSizes{};
-    poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
-    // number of models * uniformBuffers * swapchainimages
-    poolSizes[0].descriptorCount = models.size() * 1 * engine.swapChain.count;
+    std::array<vk::DescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = vk::DescriptorType::eUniformBufferDynamic;
+    poolSizes[0].descriptorCount = 1;
+    poolSizes[1].type = vk::DescriptorType::eStorageBufferDynamic;
+    poolSizes[1].descriptorCount = 1;
 
     vk::DescriptorPoolCreateInfo poolInfo{};
     poolInfo.poolSizeCount = poolSizes.size();
     poolInfo.pPoolSizes = poolSizes.data();
-    // number of models * swapchainimages
-    poolInfo.maxSets = models.size() * engine.swapChain.count;
+    // one set for every model
+    poolInfo.maxSets = 1;
 
     shadowPool = engine.device.create(poolInfo);
 
@@ -415,11 +811,19 @@ void Scene::createShadowLayouts()
     vk::DescriptorSetLayoutBinding shadowLayoutBinding{};
     shadowLayoutBinding.binding = 0;
     shadowLayoutBinding.descriptorCount = 1;
-    shadowLayoutBinding.descriptorType = vk::DescriptorType::eUniformBuffer;
+    shadowLayoutBinding.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
     shadowLayoutBinding.pImmutableSamplers = nullptr;
     shadowLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eVertex;
 
-    std::array<vk::DescriptorSetLayoutBinding, 1> layouts = {shadowLayoutBinding};
+    // model instances
+    vk::DescriptorSetLayoutBinding instanceLayoutBinding{};
+    instanceLayoutBinding.binding = 1;
+    instanceLayoutBinding.descriptorCount = 1;
+    instanceLayoutBinding.descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+    instanceLayoutBinding.pImmutableSamplers = nullptr;
+    instanceLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eVertex;
+
+    std::array<vk::DescriptorSetLayoutBinding, 2> layouts = {shadowLayoutBinding, instanceLayoutBinding};
 
     vk::DescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.bindingCount = layouts.size();
@@ -436,44 +840,94 @@ void Scene::createShadowLayouts()
 
 void Scene::createShadowSets()
 {
-    for (auto &model : models)
-    {
-        model->createShadowSets(shadowPool, shadowLayout);
+    auto &engine = State::instance().engine;
+    vk::DescriptorSetAllocateInfo allocInfo{};
+    allocInfo.descriptorPool = shadowPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &shadowLayout;
+
+    shadowSet = engine.device.create(allocInfo)[0];
+
+    if constexpr (Debug::enable)
+    { // only do this if validation is enabled
+        Debug::setName(engine.device.device, shadowSet, "Scene Shadow Set");
     }
+
+    // offsets into the arena are supplied when the set is bound
+    vk::DescriptorBufferInfo shadowInfo{};
+    shadowInfo.buffer = uniforms.buffer();
+    shadowInfo.offset = 0;
+    shadowInfo.range = sizeof(UniformShad);
+
+    vk::DescriptorBufferInfo instanceInfo{};
+    instanceInfo.buffer = uniforms.buffer();
+    instanceInfo.offset = 0;
+    instanceInfo.range = instances.size() * sizeof(ModelInstance);
+
+    std::vector<vk::WriteDescriptorSet> descriptorWrites(2);
+
+    // shadow
+    descriptorWrites[0].dstSet = shadowSet;
+    descriptorWrites[0].dstBinding = 0;
+    descriptorWrites[0].dstArrayElement = 0;
+    descriptorWrites[0].descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].pBufferInfo = &shadowInfo;
+
+    // model instances
+    descriptorWrites[1].dstSet = shadowSet;
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].dstArrayElement = 0;
+    descriptorWrites[1].descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].pBufferInfo = &instanceInfo;
+
+    engine.device.update(descriptorWrites);
 }
 
 void Scene::createShadowPipeline()
 {
     auto &engine = State::instance().engine;
-    shadowPipeline.descriptorSetLayout = &shadowLayout;
 
-    auto vertPath = "assets/shaders/shadow.vert.spv";
-    auto fragPath = "assets/shaders/shadow.frag.spv";
-    shadowPipeline.vertShader = engine.createShaderModule(vertPath);
-    shadowPipeline.fragShader = engine.createShaderModule(fragPath);
+    for (uint32_t i = 0; i < vertexLayoutCount; ++i)
+    {
+        auto &shadowPipeline = shadowPipelines[i];
+        auto packed = static_cast<VertexLayout>(i) == VertexLayout::Packed;
+        shadowPipeline.descriptorSetLayout = &shadowLayout;
 
-    shadowPipeline.loadDefaults(engine.shadowPass.renderPass);
+        // only reads positions, which the model matrix unpacks, so no decode needed
+        auto vertPath = "assets/shaders/shadow.vert.spv";
+        auto fragPath = "assets/shaders/shadow.frag.spv";
+        shadowPipeline.vertShader = engine.createShaderModule(vertPath);
+        shadowPipeline.fragShader = engine.createShaderModule(fragPath);
 
-    shadowPipeline.shaderStages = {shadowPipeline.vertShaderStageInfo, shadowPipeline.fragShaderStageInfo};
+        shadowPipeline.loadDefaults(engine.shadowPass.renderPass);
 
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescrption = Vertex::getAttributeDescriptions();
-    shadowPipeline.vertexInputInfo.vertexBindingDescriptionCount = 1;
-    shadowPipeline.vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    shadowPipeline.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescrption.size());
-    shadowPipeline.vertexInputInfo.pVertexAttributeDescriptions = attributeDescrption.data();
+        shadowPipeline.shaderStages = {shadowPipeline.vertShaderStageInfo, shadowPipeline.fragShaderStageInfo};
 
-    shadowPipeline.multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
-    shadowPipeline.rasterizer.cullMode = vk::CullModeFlagBits::eFront;
+        auto bindingDescription = packed ? PackedVertex::getBindingDescription() : Vertex::getBindingDescription();
+        auto attributeDescrption =
+            packed ? PackedVertex::getAttributeDescriptions() : Vertex::getAttributeDescriptions();
+        shadowPipeline.vertexInputInfo.vertexBindingDescriptionCount = 1;
+        shadowPipeline.vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+        shadowPipeline.vertexInputInfo.vertexAttributeDescriptionCount =
+            static_cast<uint32_t>(attributeDescrption.size());
+        shadowPipeline.vertexInputInfo.pVertexAttributeDescriptions = attributeDescrption.data();
 
-    shadowPipeline.create();
+        shadowPipeline.multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+        shadowPipeline.rasterizer.cullMode = vk::CullModeFlagBits::eFront;
 
-    if constexpr (Debug::enable)
-    { // only do this if validation is enabled
-        Debug::setName(engine.device.device, shadowPipeline.vertShader, "Scene Shadow Vert Shader");
-        Debug::setName(engine.device.device, shadowPipeline.fragShader, "Scene Shadow Frag Shader");
-        Debug::setName(engine.device.device, shadowPipeline.pipeline, "Scene Shadow Pipeline");
-        Debug::setName(engine.device.device, shadowPipeline.pipelineLayout, "Scene Shadow PipelineLayout");
+        shadowPipeline.create();
+
+        if constexpr (Debug::enable)
+        { // only do this if validation is enabled
+            std::string suffix = packed ? " Packed" : "";
+            Debug::setName(engine.device.device, shadowPipeline.vertShader, "Scene Shadow Vert Shader" + suffix);
+            Debug::setName(engine.device.device, shadowPipeline.fragShader, "Scene Shadow Frag Shader" + suffix);
+            Debug::setName(engine.device.device, shadowPipeline.pipeline, "Scene Shadow Pipeline" + suffix);
+            Debug::setName(engine.device.device, shadowPipeline.pipelineLayout,
+                           "Scene Shadow PipelineLayout" + suffix);
+        }
     }
 }
 
@@ -0,0 +1,123 @@
+#include "Simulation.hpp"
+#include "State.hpp"
+#include "Timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+void Simulation::create()
+{
+    auto &state = State::instance();
+    auto &settings = state.settings;
+    step = 1.F / settings.simulationRate;
+    // headless runs step from their fixed frame time so every run simulates the same steps
+    threaded = settings.simulationThread && !state.engine.headless;
+    accumulator = 0.F;
+    lastStep = Timer::time();
+
+    if (threaded)
+    {
+        running = true;
+        thread = std::thread([this]() { run(); });
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Simulation at {} steps per second{}", 1.F / step, threaded ? " on its own thread" : "");
+    }
+}
+
+void Simulation::destroy()
+{
+    if (thread.joinable())
+    {
+        running = false;
+        thread.join();
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Destroyed Simulation");
+    }
+}
+
+void Simulation::update(float frameTime)
+{
+    if (threaded)
+    {
+        return;
+    }
+
+    accumulator += std::min(frameTime, maxSteps * step);
+    while (accumulator >= step)
+    {
+        stepOnce();
+        accumulator -= step;
+    }
+}
+
+void Simulation::setInput(glm::vec2 direction, glm::vec3 rotation, bool jump)
+{
+    auto guard = lock();
+    input.direction = direction;
+    input.rotation = rotation;
+    // keep a jump until a step sees it
+    input.jump = input.jump || jump;
+}
+
+auto Simulation::alpha() -> float
+{
+    if (threaded)
+    {
+        return std::clamp((Timer::time() - lastStep) / step, 0.F, 1.F);
+    }
+    return accumulator / step;
+}
+
+void Simulation::stepOnce()
+{
+    auto &state = State::instance();
+
+    if (input.jump)
+    {
+        state.player.jump();
+        input.jump = false;
+    }
+    // still move player with no direction for friction
+    state.player.move(input.direction, input.rotation, step);
+    state.player.update(step);
+    state.scene.step(step);
+}
+
+void Simulation::run()
+{
+    auto next = Timer::time();
+    while (running)
+    {
+        auto now = Timer::time();
+        if (now < next)
+        {
+            std::this_thread::sleep_for(std::chrono::duration<float>(next - now));
+            continue;
+        }
+
+        {
+            auto guard = lock();
+            stepOnce();
+            lastStep = next;
+        }
+
+        next += step;
+        if (Timer::time() - next > maxSteps * step)
+        { // too far behind, drop the backlog
+            next = Timer::time();
+        }
+    }
+}
+
+} // namespace tat
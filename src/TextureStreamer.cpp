@@ -0,0 +1,332 @@
+#include "TextureStreamer.hpp"
+#include "State.hpp"
+#include "engine/Debug.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+void TextureStreamer::create(const std::vector<Model *> &models)
+{
+    auto &settings = State::instance().settings;
+    budget = settings.textureBudget * 1024 * 1024;
+    if (settings.textureStartSize == 0)
+    { // every level was loaded, nothing to stream
+        return;
+    }
+    this->models = models;
+
+    // every image of every material in the scene once, with the models that draw it
+    std::map<Material *, size_t> first{};
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        auto *material = models[i]->getMaterial();
+        auto [it, inserted] = first.try_emplace(material, textures.size());
+        if (inserted)
+        {
+            for (auto *image : material->images())
+            {
+                Texture texture{};
+                texture.image = image;
+                texture.coarsest = image->firstLevel;
+                texture.wanted = image->firstLevel;
+                resident += image->residentSize(image->firstLevel);
+                textures.push_back(texture);
+            }
+        }
+        for (size_t j = 0; j < material->images().size(); ++j)
+        {
+            textures[it->second + j].models.push_back(i);
+        }
+    }
+
+    pool.create(2);
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Texture Streamer for {} textures, {} of {} MiB resident", textures.size(),
+                     resident / 1024 / 1024, budget / 1024 / 1024);
+    }
+}
+
+void TextureStreamer::destroy()
+{
+    // lets decodes in flight finish so no worker writes to an image destroyed here
+    pool.destroy();
+    for (auto &job : decoding)
+    {
+        job.image->destroy();
+    }
+    for (auto &job : uploaded)
+    {
+        job.image->destroy();
+    }
+    for (auto &image : retired)
+    {
+        image.destroy();
+    }
+    decoding.clear();
+    uploaded.clear();
+    retired.clear();
+    textures.clear();
+    models.clear();
+    resident = 0;
+}
+
+auto TextureStreamer::update(const std::vector<float> &pixels) -> bool
+{
+    ++frame;
+    if (textures.empty())
+    {
+        return false;
+    }
+
+    if (!retired.empty() && frame > retireFrame)
+    { // every frame that could sample them has finished
+        for (auto &image : retired)
+        {
+            image.destroy();
+        }
+        retired.clear();
+    }
+
+    finish();
+    auto swapped = !uploaded.empty() && retired.empty();
+    if (swapped)
+    { // the spare set hasn't been bound since the last swap retired
+        swap();
+    }
+
+    for (auto &texture : textures)
+    {
+        texture.wanted = texture.coarsest;
+        for (auto i : texture.models)
+        {
+            texture.wanted = std::min(texture.wanted, levelFor(texture, *models[i], pixels[i]));
+        }
+    }
+
+    size_t evicted = 0;
+    while (decoding.size() < maxJobs)
+    {
+        // texture missing the most levels it needs goes first
+        auto best = textures.size();
+        uint32_t missing = 0;
+        for (size_t i = 0; i < textures.size(); ++i)
+        {
+            auto &texture = textures[i];
+            if (!texture.busy && texture.wanted < texture.image->firstLevel &&
+                texture.image->firstLevel - texture.wanted > missing)
+            {
+                best = i;
+                missing = texture.image->firstLevel - texture.wanted;
+            }
+        }
+        if (best == textures.size())
+        {
+            break;
+        }
+
+        auto &image = *textures[best].image;
+        auto level = textures[best].wanted;
+        auto current = image.residentSize(image.firstLevel);
+        // make room by dropping levels nothing needs, then settle for coarser levels
+        while (resident - current + image.residentSize(level) > budget && evicted < maxJobs)
+        {
+            if (!evict())
+            {
+                break;
+            }
+            ++evicted;
+        }
+        while (level < image.firstLevel && resident - current + image.residentSize(level) > budget)
+        {
+            ++level;
+        }
+        if (level == image.firstLevel)
+        { // the budget is full of levels that are needed
+            break;
+        }
+        schedule(best, level);
+    }
+    return swapped;
+}
+
+void TextureStreamer::detach(Material *material)
+{
+    auto images = material->images();
+    auto owned = [this, &images](const Job &job) {
+        return std::find(images.begin(), images.end(), textures[job.texture].image) != images.end();
+    };
+    for (auto *jobs : {&decoding, &uploaded})
+    {
+        for (auto it = jobs->begin(); it != jobs->end();)
+        {
+            if (!owned(*it))
+            {
+                ++it;
+                continue;
+            }
+            if (it->decoded.valid())
+            { // the worker may still be writing to the job's image
+                it->decoded.wait();
+            }
+            auto &texture = textures[it->texture];
+            auto &current = *texture.image;
+            resident = resident - current.residentSize(it->level) + current.residentSize(current.firstLevel);
+            texture.busy = false;
+            it->image->destroy();
+            it = jobs->erase(it);
+        }
+    }
+
+    for (auto &texture : textures)
+    {
+        if (std::find(images.begin(), images.end(), texture.image) != images.end())
+        {
+            resident -= texture.image->residentSize(texture.image->firstLevel);
+        }
+    }
+}
+
+void TextureStreamer::attach(Material *material)
+{
+    auto images = material->images();
+    for (auto &texture : textures)
+    {
+        if (std::find(images.begin(), images.end(), texture.image) != images.end())
+        {
+            texture.coarsest = texture.image->firstLevel;
+            texture.wanted = texture.image->firstLevel;
+            resident += texture.image->residentSize(texture.image->firstLevel);
+        }
+    }
+}
+
+auto TextureStreamer::levelFor(const Texture &texture, Model &model, float pixels) -> uint32_t
+{
+    if (pixels <= 0.F)
+    {
+        return texture.coarsest;
+    }
+    // the material repeats uvScale times across the model
+    auto &extent = texture.image->fileExtent;
+    auto texels = static_cast<float>(std::max(extent.width, extent.height)) * model.uvScale();
+    auto level = std::floor(std::log2(std::max(texels / pixels, 1.F)));
+    return std::min(static_cast<uint32_t>(level), static_cast<uint32_t>(texture.image->levelSizes.size() - 1));
+}
+
+auto TextureStreamer::prepare(size_t index, uint32_t level) -> Job
+{
+    auto &texture = textures[index];
+    auto &current = *texture.image;
+    texture.busy = true;
+    resident = resident + current.residentSize(level) - current.residentSize(current.firstLevel);
+
+    Job job{};
+    job.texture = index;
+    job.level = level;
+    job.image = std::make_unique<Image>();
+    job.image->imageInfo.usage = current.imageInfo.usage;
+    job.image->memUsage = current.memUsage;
+    job.image->imageViewInfo = current.imageViewInfo;
+    job.image->samplerInfo = current.samplerInfo;
+    return job;
+}
+
+void TextureStreamer::schedule(size_t index, uint32_t level)
+{
+    auto job = prepare(index, level);
+    auto *image = job.image.get();
+    auto file = textures[index].image->file();
+    job.decoded = pool.submit([image, file]() { image->decode(file); });
+    decoding.push_back(std::move(job));
+}
+
+auto TextureStreamer::evict() -> bool
+{
+    // texture whose unneeded levels take the most memory
+    auto best = textures.size();
+    vk::DeviceSize freed = 0;
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        auto &texture = textures[i];
+        auto &image = *texture.image;
+        if (!texture.busy && texture.wanted > image.firstLevel &&
+            image.residentSize(image.firstLevel) - image.residentSize(texture.wanted) > freed)
+        {
+            best = i;
+            freed = image.residentSize(image.firstLevel) - image.residentSize(texture.wanted);
+        }
+    }
+    if (best == textures.size())
+    {
+        return false;
+    }
+
+    // every level still needed is already resident, so nothing is read from disk
+    auto job = prepare(best, textures[best].wanted);
+    job.image->copy(*textures[best].image, job.level);
+    job.image->samplerInfo.maxLod = static_cast<float>(job.image->imageInfo.mipLevels);
+    job.image->createSampler();
+    // swapped in on a later update, after the copy has been flushed
+    uploaded.push_back(std::move(job));
+    return true;
+}
+
+void TextureStreamer::finish()
+{
+    for (auto it = decoding.begin(); it != decoding.end();)
+    {
+        if (it->decoded.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+        // rethrows what the decode threw
+        it->decoded.get();
+
+        auto &texture = textures[it->texture];
+        Material::uploadImage(it->image.get(), it->level);
+        if (!it->image->image)
+        { // file couldn't be read, it already warned so keep what is resident
+            auto &current = *texture.image;
+            resident = resident - current.residentSize(it->level) + current.residentSize(current.firstLevel);
+            texture.busy = false;
+            it->image->destroy();
+        }
+        else
+        {
+            uploaded.push_back(std::move(*it));
+        }
+        it = decoding.erase(it);
+    }
+}
+
+void TextureStreamer::swap()
+{
+    for (auto &job : uploaded)
+    {
+        auto &texture = textures[job.texture];
+        retired.push_back(*texture.image);
+        *texture.image = *job.image;
+        texture.busy = false;
+    }
+    retireFrame = frame + Engine::maxFramesInFlight;
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Streamed {} textures, {} of {} MiB resident", uploaded.size(), resident / 1024 / 1024,
+                     budget / 1024 / 1024);
+    }
+    uploaded.clear();
+}
+
+} // namespace tat
@@ -4,8 +4,12 @@
 #include "State.hpp"
 #include "Timer.hpp"
 
+#include <algorithm>
 #include <exception>
+#include <fstream>
 #include <memory>
+#include <numeric>
+#include <set>
 
 #include <spdlog/spdlog.h>
 
@@ -18,7 +22,7 @@ static void resizeWindow(GLFWwindow * /*window*/, int width, int height)
     State::instance().engine.resize(width, height);
 };
 
-VulkansEye::VulkansEye(const std::string &configPath)
+VulkansEye::VulkansEye(const std::string &configPath, int32_t headlessFrames)
 {
     // init state
     auto &state = State::instance();
@@ -39,10 +43,16 @@ VulkansEye::VulkansEye(const std::string &configPath)
     config.create(configPath);
 
     // get settings
-    auto &settings = state.at("settings");
+    auto &settings = state.settings;
+    if (headlessFrames > 0)
+    {
+        settings.headless = true;
+        settings.headlessFrames = headlessFrames;
+    }
+    state.engine.headless = settings.headless;
 
     // load display settings
-    if (settings.at("vsync").get<bool>())
+    if (settings.vsync)
     {
         state.engine.defaultPresentMode = vk::PresentModeKHR::eFifo;
     }
@@ -51,30 +61,22 @@ VulkansEye::VulkansEye(const std::string &configPath)
         state.engine.defaultPresentMode = vk::PresentModeKHR::eMailbox;
     }
 
-    // load glfw window
-    auto &window = settings.at("window");
-    state.window.create(this, window.at(0), window.at(1), "Vulkans Eye");
-    state.window.setWindowSizeCallBack(&resizeWindow);
-
-    // setup input
-    Input::getInstance();
-    state.window.setKeyCallBack(&Input::keyCallback);
-    state.window.setMouseButtonCallback(&Input::mouseButtonCallback);
-    state.window.setCursorPosCallback(&Input::cursorPosCallback);
-    state.window.setCharCallback(&Input::charCallback);
-    state.window.setScrollCallback(&Input::scrollCallback);
-    state.window.setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    state.window.setInputMode(GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
-
-    if constexpr (Debug::enable)
+    auto &window = settings.window;
+    if (state.engine.headless)
+    { // no window or input, size is still used for the offscreen images
+        state.window.width = window[0];
+        state.window.height = window[1];
+    }
+    else
     {
-        spdlog::info("Created Input");
+        createWindow(window[0], window[1]);
     }
 
     // create engine
     state.engine.create();
 
-    // create collections
+    // create collections, their entries look in the cache before importing
+    state.cache.create(settings.cachePath);
     state.backdrops.create("backdrops");
     if constexpr (Debug::enable)
     {
@@ -100,15 +102,55 @@ VulkansEye::VulkansEye(const std::string &configPath)
     state.player.create();
     state.camera.create();
     state.scene.create();
-    state.overlay.create();
+    if (!state.engine.headless)
+    {
+        state.overlay.create();
+    }
 
     // prepare engine
     state.engine.prepare();
+
+    // watches the files of what was just loaded
+    state.hotReload.create();
+    state.residency.create();
+
+    // start physics last so it only steps fully created objects
+    state.simulation.create();
+}
+
+void VulkansEye::createWindow(int width, int height)
+{
+    auto &state = State::instance();
+
+    // load glfw window
+    state.window.create(this, width, height, "Vulkans Eye");
+    state.window.setWindowSizeCallBack(&resizeWindow);
+
+    // setup input
+    Input::getInstance();
+    state.window.setKeyCallBack(&Input::keyCallback);
+    state.window.setMouseButtonCallback(&Input::mouseButtonCallback);
+    state.window.setCursorPosCallback(&Input::cursorPosCallback);
+    state.window.setCharCallback(&Input::charCallback);
+    state.window.setScrollCallback(&Input::scrollCallback);
+    state.window.setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    state.window.setInputMode(GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Input");
+    }
 }
 
 void VulkansEye::run()
 {
     auto &state = State::instance();
+    if (state.engine.headless)
+    {
+        runHeadless();
+        return;
+    }
+
     if constexpr (Debug::enable)
     {
         spdlog::info("Begin Main Loop");
@@ -120,13 +162,15 @@ void VulkansEye::run()
         auto deltaTime = now - lastFrameTime;
         lastFrameTime = now;
 
-        handleInput(deltaTime);
+        handleInput();
 
-        state.player.update(deltaTime);
-        state.camera.setPosition(-1.F * state.player.position());
-        state.camera.update();
+        state.simulation.update(deltaTime);
+        updateCamera();
         state.overlay.update(deltaTime);
-        state.engine.drawFrame(deltaTime);
+        // between frames so nothing it replaces is in use
+        state.hotReload.update();
+        state.residency.update();
+        state.engine.drawFrame();
     }
 
     state.engine.device.wait();
@@ -140,10 +184,15 @@ void VulkansEye::cleanup()
 {
     auto &state = State::instance();
 
+    state.simulation.destroy();
+    state.hotReload.destroy();
     Camera::destroy();
     Player::destroy();
 
-    state.overlay.destroy();
+    if (!state.engine.headless)
+    {
+        state.overlay.destroy();
+    }
     state.scene.destroy();
 
     state.backdrops.destroy();
@@ -153,14 +202,107 @@ void VulkansEye::cleanup()
 
     state.engine.destroy();
 
-    // dump state
+    // dump state, with what changed in the typed records written back
     if constexpr (Debug::enable)
     {
+        state["settings"] = state.settings;
+        state["player"] = state.playerRecord;
+        state["scene"] = state.sceneRecord;
         spdlog::get("state")->info(State::instance().dump(4));
     }
 }
 
-void VulkansEye::handleInput(float deltaTime)
+void VulkansEye::runHeadless()
+{
+    auto &state = State::instance();
+    auto &settings = state.settings;
+    auto frames = settings.headlessFrames;
+    std::set<int32_t> dumpFrames(settings.dumpFrames.begin(), settings.dumpFrames.end());
+    auto &dumpPath = settings.dumpPath;
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Begin Headless Loop for {} frames", frames);
+    }
+
+    // fixed frame time so every run simulates the same steps
+    constexpr auto deltaTime = 1.F / 60.F;
+    std::vector<float> frameTimes(frames);
+    auto startTime = Timer::time();
+    for (int32_t frame = 0; frame < frames; ++frame)
+    {
+        auto frameStart = Timer::time();
+
+        // no input, player still steps for gravity and friction
+        state.simulation.update(deltaTime);
+        updateCamera();
+        state.residency.update();
+        state.engine.drawFrame();
+
+        // captures stall the gpu so they aren't counted
+        frameTimes[frame] = Timer::time() - frameStart;
+        if (dumpFrames.count(frame) > 0)
+        {
+            state.engine.capture(fmt::format("{}frame{}.ppm", dumpPath, frame));
+        }
+    }
+
+    state.engine.device.wait();
+    writeStats(frameTimes, Timer::time() - startTime);
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("End Headless Loop");
+    }
+}
+
+void VulkansEye::writeStats(std::vector<float> &frameTimes, float totalTime)
+{
+    if (frameTimes.empty())
+    {
+        return;
+    }
+
+    auto &statsPath = State::instance().settings.statsPath;
+
+    // per frame times in milliseconds
+    std::ofstream file(statsPath);
+    if (!file.is_open())
+    {
+        spdlog::error("Unable to open {}", statsPath);
+        throw std::runtime_error("Unable to open stats file");
+    }
+    file << "frame,ms\n";
+    for (size_t i = 0; i < frameTimes.size(); ++i)
+    {
+        file << i << "," << frameTimes[i] * 1000.F << "\n";
+    }
+
+    auto average = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.F) / frameTimes.size();
+    std::sort(frameTimes.begin(), frameTimes.end());
+    auto percentile = [&frameTimes](float p) {
+        return frameTimes[static_cast<size_t>(p * static_cast<float>(frameTimes.size() - 1))];
+    };
+
+    auto summary = fmt::format("{} frames in {:.3f}s, {:.1f} fps, ms avg {:.3f} min {:.3f} median {:.3f} p95 {:.3f} "
+                               "p99 {:.3f} max {:.3f}",
+                               frameTimes.size(), totalTime, frameTimes.size() / totalTime, average * 1000.F,
+                               frameTimes.front() * 1000.F, percentile(0.5F) * 1000.F, percentile(0.95F) * 1000.F,
+                               percentile(0.99F) * 1000.F, frameTimes.back() * 1000.F);
+    spdlog::info(summary);
+}
+
+void VulkansEye::updateCamera()
+{
+    auto &state = State::instance();
+    {
+        // player may be mid step on the simulation thread
+        auto lock = state.simulation.lock();
+        state.camera.setPosition(-1.F * state.player.position(state.simulation.alpha()));
+    }
+    state.camera.update();
+}
+
+void VulkansEye::handleInput()
 {
     glfwPollEvents();
 
@@ -192,6 +334,7 @@ void VulkansEye::handleInput(float deltaTime)
     state.camera.look(Input::getMouseX(), Input::getMouseY());
 
     auto moveDir = glm::vec2(0.F);
+    auto jump = false;
     if (Input::getMode() != InputMode::Insert)
     { // don't move camera/character in insert mode
 
@@ -200,13 +343,10 @@ void VulkansEye::handleInput(float deltaTime)
         moveDir.x += static_cast<float>(Input::isKeyPressed(GLFW_KEY_A));
         moveDir.x -= static_cast<float>(Input::isKeyPressed(GLFW_KEY_D));
 
-        if (Input::isKeyPressed(GLFW_KEY_SPACE) != 0)
-        {
-            state.player.jump();
-        }
+        jump = Input::isKeyPressed(GLFW_KEY_SPACE) != 0;
     }
-    // still update player for friction
-    state.player.move(moveDir, deltaTime);
+    // applied on the next simulation step
+    state.simulation.setInput(moveDir, state.camera.rotation(), jump);
 }
 
 void VulkansEye::switchToNormalMode()
@@ -220,7 +360,6 @@ void VulkansEye::switchToNormalMode()
     state.overlay.settings.showPaused = false;
 
     state.engine.showOverlay = false;
-    state.engine.updateCommandBuffer = true;
     Input::popMode();
     Input::pushMode(InputMode::Normal);
 
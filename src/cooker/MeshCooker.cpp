@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "MappedFile.hpp"
+#include "MeshData.hpp"
+
+using json = nlohmann::json;
+
+constexpr auto defaultMeshes = "assets/meshes/";
+
+// Cooks every mesh under the meshes directory into a binary file next to its source
+// Meshes with a current cooked file are skipped unless forced
+auto main(int argc, char *argv[]) -> int
+{
+    std::string meshesPath = defaultMeshes;
+    auto force = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--force")
+        {
+            force = true;
+        }
+        else if (std::filesystem::is_directory(arg))
+        {
+            meshesPath = arg;
+        }
+        else
+        {
+            std::cout << "Usage: MeshCooker [meshes directory] [--force]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto cooked = 0;
+    auto failed = 0;
+    for (auto &entry : std::filesystem::directory_iterator(meshesPath))
+    {
+        auto config = entry.path() / "mesh.json";
+        if (!entry.is_directory() || !std::filesystem::exists(config))
+        {
+            continue;
+        }
+
+        try
+        {
+            std::ifstream configFile(config);
+            auto mesh = json::parse(configFile);
+            auto source = (entry.path() / mesh.at("file").get<std::string>()).string();
+            // same defaults as the engine's mesh config
+            auto requested = mesh.value("vertexLayout", "auto");
+            auto positionTolerance = mesh.value("positionTolerance", 0.001F);
+            auto uvTolerance = mesh.value("uvTolerance", 0.001F);
+            auto settings = tat::MeshData::importSettings(requested, positionTolerance, uvTolerance);
+
+            if (!force)
+            {
+                tat::MappedFile file{};
+                if (file.open(tat::MeshData::cookedPath(source)) &&
+                    tat::MeshData::cooked(file, source, settings) != nullptr)
+                {
+                    spdlog::info("{} is current", source);
+                    continue;
+                }
+            }
+
+            tat::MeshData data{};
+            data.import(source);
+            data.selectLayout(requested, positionTolerance, uvTolerance);
+            data.cook(source, settings, tat::MeshData::cookedPath(source));
+            ++cooked;
+            spdlog::info("Cooked {} : {} vertices {} indices, {} layout", source, data.vertices.size(),
+                         data.indices.size(), data.layout == tat::VertexLayout::Packed ? "packed" : "full");
+            for (size_t i = 1; i < data.lods.size(); ++i)
+            {
+                spdlog::info("    LOD {} : {} triangles, error {:.4f}", i, data.lods[i].indexCount / 3,
+                             data.lods[i].error);
+            }
+            spdlog::info("    ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", data.original.acmr, data.optimized.acmr,
+                         data.original.atvr, data.optimized.atvr);
+        }
+        catch (const std::exception &e)
+        {
+            ++failed;
+            spdlog::error("Unable to cook {} : {}", entry.path().string(), e.what());
+        }
+    }
+
+    spdlog::info("Cooked {} meshes, {} failed", cooked, failed);
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "MaterialData.hpp"
+
+using json = nlohmann::json;
+
+constexpr auto defaultMaterials = "assets/materials/";
+
+// Packs the ao, roughness and metallic maps of every material under the materials directory into one texture
+// Materials with a current packed map are skipped unless forced
+auto main(int argc, char *argv[]) -> int
+{
+    std::string materialsPath = defaultMaterials;
+    auto force = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--force")
+        {
+            force = true;
+        }
+        else if (std::filesystem::is_directory(arg))
+        {
+            materialsPath = arg;
+        }
+        else
+        {
+            std::cout << "Usage: TextureCooker [materials directory] [--force]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto cooked = 0;
+    auto failed = 0;
+    for (auto &entry : std::filesystem::directory_iterator(materialsPath))
+    {
+        auto config = entry.path() / "material.json";
+        if (!entry.is_directory() || !std::filesystem::exists(config))
+        {
+            continue;
+        }
+
+        try
+        {
+            std::ifstream configFile(config);
+            auto material = json::parse(configFile);
+            // same defaults as the engine's material config
+            auto ao = (entry.path() / material.value("ao", "ao.dds")).string();
+            auto roughness = (entry.path() / material.value("roughness", "roughness.dds")).string();
+            auto metallic = (entry.path() / material.value("metallic", "metallic.dds")).string();
+            auto orm = (entry.path() / material.value("orm", tat::MaterialData::ormFile)).string();
+
+            if (!force && tat::MaterialData::current(orm, {ao, roughness, metallic}))
+            {
+                spdlog::info("{} is current", orm);
+                continue;
+            }
+
+            tat::MaterialData data{};
+            data.pack(ao, roughness, metallic);
+            data.cook(orm);
+            ++cooked;
+            spdlog::info("Cooked {} : {}x{}, {} levels, {} KiB", orm, data.width, data.height, data.levels,
+                         data.blocks.size() / 1024);
+        }
+        catch (const std::exception &e)
+        {
+            ++failed;
+            spdlog::error("Unable to cook {} : {}", entry.path().string(), e.what());
+        }
+    }
+
+    spdlog::info("Cooked {} materials, {} failed", cooked, failed);
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
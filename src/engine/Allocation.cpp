@@ -50,4 +50,17 @@ void Allocation::flush(size_t size, size_t offset)
     throw std::runtime_error("Unable to flush memory, allocation not found");
 }
 
+void Allocation::invalidate(size_t size, size_t offset)
+{
+    // Only invalidate if allocation is valid
+    if (descriptor >= 0 && allocation != nullptr && allocator != nullptr)
+    {
+        vmaInvalidateAllocation(allocator, allocation, offset, size);
+        return;
+    }
+
+    spdlog::error("Unable to invalidate memory, allocation {} not found", descriptor);
+    throw std::runtime_error("Unable to invalidate memory, allocation not found");
+}
+
 } // namespace tat
\ No newline at end of file
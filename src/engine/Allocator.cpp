@@ -1,6 +1,7 @@
 #include "engine/Allocator.hpp"
 #include "State.hpp"
 
+#include <array>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
 
@@ -20,11 +21,18 @@ inline auto isBufferCreateInfo(const HandleCreateInfo &createInfo) -> bool
     return std::holds_alternative<vk::BufferCreateInfo>(createInfo);
 }
 
-void Allocator::create(vk::PhysicalDevice physicalDevice, vk::Device device)
+void Allocator::create(vk::Instance instance, vk::PhysicalDevice physicalDevice, vk::Device device, bool memoryBudget)
 {
     VmaAllocatorCreateInfo allocatorInfo{};
+    allocatorInfo.instance = instance;
     allocatorInfo.physicalDevice = physicalDevice;
     allocatorInfo.device = device;
+    // matches the instance, the budget is queried with the core memory properties 2
+    allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_1;
+    if (memoryBudget)
+    {
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
 
     if (vmaCreateAllocator(&allocatorInfo, &allocator) != VK_SUCCESS)
     {
@@ -66,6 +74,30 @@ void Allocator::destroy()
     }
 }
 
+auto Allocator::budget() -> Budget
+{
+    const VkPhysicalDeviceMemoryProperties *properties = nullptr;
+    vmaGetMemoryProperties(allocator, &properties);
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+    vmaGetBudget(allocator, budgets.data());
+
+    Budget total{};
+    for (uint32_t heap = 0; heap < properties->memoryHeapCount; ++heap)
+    {
+        if ((properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0U)
+        {
+            total.usage += budgets[heap].usage;
+            total.budget += budgets[heap].budget;
+        }
+    }
+    return total;
+}
+
+void Allocator::setFrame(uint64_t frame)
+{
+    vmaSetCurrentFrameIndex(allocator, static_cast<uint32_t>(frame));
+}
+
 auto Allocator::create(HandleCreateInfo createInfo, VmaAllocationCreateInfo &memInfo, VmaAllocationInfo *allocInfo)
     -> Allocation *
 {
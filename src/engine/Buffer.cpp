@@ -64,27 +64,14 @@ void Buffer::update(void *t, size_t s)
     allocation->unmap();
 }
 
-void Buffer::copyTo(Buffer &destination)
-{
-    // if destination buffer is a different size than source buffer reaclloate
-    if (size != destination.size)
-    {
-        destination.create(size);
-    }
-
-    auto &engine = State::instance().engine;
-    auto commandBuffer = engine.beginSingleTimeCommands();
-
-    vk::BufferCopy copyRegion{};
-    copyRegion.size = size;
-    commandBuffer.copyBuffer(buffer, destination.buffer, 1, &copyRegion);
-
-    engine.endSingleTimeCommands(commandBuffer);
-}
-
 void Buffer::flush(size_t size, vk::DeviceSize offset)
 {
     allocation->flush(size, offset);
 };
 
+void Buffer::invalidate(size_t size, vk::DeviceSize offset)
+{
+    allocation->invalidate(size, offset);
+};
+
 } // namespace tat
\ No newline at end of file
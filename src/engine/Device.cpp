@@ -15,7 +15,8 @@ void Device::create()
     auto indices = SwapChain::findQueueFamiles(engine.physicalDevice.device);
 
     std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos{};
-    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value(),
+                                              indices.transferFamily.value()};
 
     float queuePriority = 1.F;
     for (auto queueFamily : uniqueQueueFamilies)
@@ -31,6 +32,11 @@ void Device::create()
     deviceFeatures.samplerAnisotropy = VK_TRUE;
     deviceFeatures.sampleRateShading = VK_TRUE;
     deviceFeatures.geometryShader = VK_TRUE;
+    deviceFeatures.multiDrawIndirect = VK_TRUE;
+    deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+    deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+    // optional, used by the profiler
+    deviceFeatures.pipelineStatisticsQuery = engine.physicalDevice.features.pipelineStatisticsQuery;
 
     vk::DeviceCreateInfo createInfo{};
     createInfo.queueCreateInfoCount = queueCreateInfos.size();
@@ -45,6 +51,7 @@ void Device::create()
 
     graphicsQueue = device.getQueue(indices.graphicsFamily.value(), 0);
     presentQueue = device.getQueue(indices.presentFamily.value(), 0);
+    transferQueue = device.getQueue(indices.transferFamily.value(), 0);
 
     if constexpr (Debug::enable)
     {
@@ -76,6 +83,16 @@ auto Device::reset(vk::Fence &fence) -> vk::Result
     return device.resetFences(1, &fence);
 }
 
+auto Device::ready(vk::Fence &fence) -> bool
+{
+    return device.getFenceStatus(fence) == vk::Result::eSuccess;
+}
+
+void Device::reset(vk::CommandPool &pool)
+{
+    device.resetCommandPool(pool, {});
+}
+
 auto Device::acquireNextImage(vk::SwapchainKHR &swapChain, vk::Semaphore &semaphore, uint32_t &currentBuffer)
     -> vk::Result
 {
@@ -92,6 +109,13 @@ auto Device::getSwapchainImages(const vk::SwapchainKHR &swapChain) -> std::vecto
     return device.getSwapchainImagesKHR(swapChain);
 }
 
+auto Device::getResults(vk::QueryPool pool, uint32_t first, uint32_t count, std::vector<uint64_t> &data,
+                        vk::DeviceSize stride, vk::QueryResultFlags flags) -> vk::Result
+{
+    // not ready is expected when some queries were never written
+    return device.getQueryPoolResults(pool, first, count, data.size() * sizeof(uint64_t), data.data(), stride, flags);
+}
+
 auto Device::create(const vk::CommandBufferAllocateInfo &allocInfo) -> std::vector<vk::CommandBuffer>
 {
     return device.allocateCommandBuffers(allocInfo);
@@ -157,6 +181,11 @@ auto Device::create(const vk::GraphicsPipelineCreateInfo &createInfo, vk::Pipeli
     return device.createGraphicsPipeline(cache, createInfo);
 }
 
+auto Device::create(const vk::ComputePipelineCreateInfo &createInfo, vk::PipelineCache cache) -> vk::Pipeline
+{
+    return device.createComputePipeline(cache, createInfo);
+}
+
 auto Device::create(const vk::PipelineCacheCreateInfo &createInfo) -> vk::PipelineCache
 {
     return device.createPipelineCache(createInfo);
@@ -172,6 +201,11 @@ auto Device::create(const vk::SemaphoreCreateInfo &createInfo) -> vk::Semaphore
     return device.createSemaphore(createInfo);
 }
 
+auto Device::create(const vk::QueryPoolCreateInfo &createInfo) -> vk::QueryPool
+{
+    return device.createQueryPool(createInfo);
+}
+
 void Device::destroy(vk::CommandPool pool, std::vector<vk::CommandBuffer> &commandBuffers)
 {
     device.freeCommandBuffers(pool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
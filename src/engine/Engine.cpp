@@ -3,6 +3,7 @@
 
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <memory>
 #include <set>
 #include <stdexcept>
@@ -24,18 +25,21 @@ void Engine::create()
     {
         debug.create(&instance);
     }
-    surface = state.window.createSurface(instance);
+    if (!headless)
+    {
+        surface = state.window.createSurface(instance);
+    }
     physicalDevice.pick(instance);
 
     device.create();
 
-    allocator.create(physicalDevice.device, device.device);
+    allocator.create(instance, physicalDevice.device, device.device, physicalDevice.memoryBudget);
+    uploader.create();
     swapChain.create();
     shadowPass.loadShadow();
     shadowPass.create();
     colorPass.loadColor();
     colorPass.create();
-    createCommandPool();
     pipelineCache.create();
 
     if constexpr (Debug::enable)
@@ -51,8 +55,11 @@ void Engine::prepare()
     presentSemaphores.resize(maxFramesInFlight);
     renderSemaphores.resize(maxFramesInFlight);
     waitFences.resize(maxFramesInFlight);
+    imageFences.assign(swapChain.count, nullptr);
 
     createCommandBuffers();
+    // the recorder and the main thread record different sections, so one query slot each is enough
+    profiler.create(maxFramesInFlight, 1);
     prepared = true;
 
     if constexpr (Debug::enable)
@@ -73,14 +80,25 @@ void Engine::destroy()
         debug.destroy();
     }
 
-    if (!commandBuffers.empty())
+    profiler.destroy();
+    uploader.destroy();
+
+    // destroying the pools frees the command buffers allocated from them
+    recordThread.destroy();
+    for (auto &pool : recorder.pools)
     {
-        device.destroy(commandPool, commandBuffers);
+        device.destroy(pool);
     }
-    if (commandPool)
+    recorder = {};
+    recordModelsOnThread = false;
+    backdropBuffers.clear();
+    overlayBuffers.clear();
+    for (auto &pool : framePools)
     {
-        device.destroy(commandPool);
+        device.destroy(pool);
     }
+    framePools.clear();
+    commandBuffers.clear();
 
     renderSemaphores.clear();
     presentSemaphores.clear();
@@ -111,7 +129,7 @@ void Engine::destroy()
     }
 }
 
-void Engine::renderShadows(vk::CommandBuffer commandBuffer, int32_t currentImage)
+void Engine::setShadowViewport(vk::CommandBuffer commandBuffer)
 {
     auto &state = State::instance();
     vk::Viewport viewport{};
@@ -129,6 +147,31 @@ void Engine::renderShadows(vk::CommandBuffer commandBuffer, int32_t currentImage
     commandBuffer.setScissor(0, 1, &scissor);
 
     commandBuffer.setLineWidth(1.0F);
+}
+
+void Engine::setColorViewport(vk::CommandBuffer commandBuffer)
+{
+    auto &state = State::instance();
+    vk::Viewport viewport{};
+    viewport.width = state.window.width;
+    viewport.height = state.window.height;
+    viewport.minDepth = 0.0F;
+    viewport.maxDepth = 1.0F;
+    commandBuffer.setViewport(0, 1, &viewport);
+
+    vk::Rect2D scissor{};
+    scissor.extent = swapChain.extent;
+    scissor.offset.x = 0;
+    scissor.offset.y = 0;
+    commandBuffer.setScissor(0, 1, &scissor);
+
+    commandBuffer.setLineWidth(1.0F);
+}
+
+void Engine::renderShadows(vk::CommandBuffer commandBuffer, int32_t currentImage)
+{
+    auto &state = State::instance();
+    setShadowViewport(commandBuffer);
 
     std::array<vk::ClearValue, 2> clearValues{};
     clearValues[0].color = std::array<float, 4>{0.F, 0.F, 0.F, 0.F};
@@ -143,28 +186,25 @@ void Engine::renderShadows(vk::CommandBuffer commandBuffer, int32_t currentImage
     shadowPassBeginInfo.pClearValues = clearValues.data();
     shadowPassBeginInfo.framebuffer = shadowFramebuffers[currentImage].framebuffer;
 
-    commandBuffer.beginRenderPass(shadowPassBeginInfo, vk::SubpassContents::eInline);
-    state.scene.drawShadow(commandBuffer, currentImage);
+    if (!recordModelsOnThread)
+    {
+        commandBuffer.beginRenderPass(shadowPassBeginInfo, vk::SubpassContents::eInline);
+        profiler.begin(commandBuffer, currentFrame, Section::Shadow);
+        state.scene.drawShadow(commandBuffer, currentImage);
+        profiler.end(commandBuffer, currentFrame, Section::Shadow);
+        commandBuffer.endRenderPass();
+        return;
+    }
+
+    commandBuffer.beginRenderPass(shadowPassBeginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+    commandBuffer.executeCommands(recorder.shadowBuffers[currentFrame]);
     commandBuffer.endRenderPass();
 }
 
 void Engine::renderColors(vk::CommandBuffer commandBuffer, int32_t currentImage)
 {
     auto &state = State::instance();
-    vk::Viewport viewport{};
-    viewport.width = state.window.width;
-    viewport.height = state.window.height;
-    viewport.minDepth = 0.0F;
-    viewport.maxDepth = 1.0F;
-    commandBuffer.setViewport(0, 1, &viewport);
-
-    vk::Rect2D scissor{};
-    scissor.extent = swapChain.extent;
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    commandBuffer.setScissor(0, 1, &scissor);
-
-    commandBuffer.setLineWidth(1.0F);
+    setColorViewport(commandBuffer);
 
     std::array<vk::ClearValue, 2> clearValues{};
     clearValues[0].color = std::array<float, 4>{0.0F, 0.0F, 0.0F, 0.0F};
@@ -178,120 +218,322 @@ void Engine::renderColors(vk::CommandBuffer commandBuffer, int32_t currentImage)
     colorPassBeginInfo.pClearValues = clearValues.data();
     colorPassBeginInfo.framebuffer = colorFramebuffers[currentImage].framebuffer;
 
-    commandBuffer.beginRenderPass(colorPassBeginInfo, vk::SubpassContents::eInline);
-    state.scene.drawColor(commandBuffer, currentImage);
+    if (!recordModelsOnThread)
+    {
+        commandBuffer.beginRenderPass(colorPassBeginInfo, vk::SubpassContents::eInline);
+        profiler.begin(commandBuffer, currentFrame, Section::Backdrop);
+        state.scene.backdrop->draw(commandBuffer, currentImage);
+        profiler.end(commandBuffer, currentFrame, Section::Backdrop);
+        profiler.begin(commandBuffer, currentFrame, Section::Models);
+        state.scene.drawColor(commandBuffer, currentImage);
+        profiler.end(commandBuffer, currentFrame, Section::Models);
+        if (showOverlay)
+        {
+            profiler.begin(commandBuffer, currentFrame, Section::Overlay);
+            state.overlay.draw(commandBuffer, currentImage);
+            profiler.end(commandBuffer, currentFrame, Section::Overlay);
+        }
+        commandBuffer.endRenderPass();
+        return;
+    }
+
+    // backdrop first, then models, then overlay on top
+    std::vector<vk::CommandBuffer> secondaries{backdropBuffers[currentFrame], recorder.colorBuffers[currentFrame]};
     if (showOverlay)
     {
-        state.overlay.draw(commandBuffer, currentImage);
+        secondaries.push_back(overlayBuffers[currentFrame]);
     }
+
+    commandBuffer.beginRenderPass(colorPassBeginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+    commandBuffer.executeCommands(secondaries);
     commandBuffer.endRenderPass();
 }
 
 void Engine::createCommandBuffers()
 {
-    commandBuffers.resize(colorFramebuffers.size());
+    auto queueFamilyIndices = SwapChain::findQueueFamiles(physicalDevice.device);
 
-    vk::CommandBufferAllocateInfo allocInfo{};
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = vk::CommandBufferLevel::ePrimary;
-    allocInfo.commandBufferCount = commandBuffers.size();
-    commandBuffers = device.create(allocInfo);
+    framePools.resize(maxFramesInFlight);
+    commandBuffers.resize(maxFramesInFlight);
+    for (int32_t i = 0; i < maxFramesInFlight; ++i)
+    {
+        vk::CommandPoolCreateInfo poolInfo{};
+        poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+        framePools[i] = device.create(poolInfo);
+
+        vk::CommandBufferAllocateInfo allocInfo{};
+        allocInfo.commandPool = framePools[i];
+        allocInfo.level = vk::CommandBufferLevel::ePrimary;
+        allocInfo.commandBufferCount = 1;
+        commandBuffers[i] = device.create(allocInfo)[0];
+
+        if constexpr (Debug::enable)
+        {
+            Debug::setName(device.device, framePools[i], fmt::format("Frame {} Pool", i));
+            Debug::setName(device.device, commandBuffers[i], fmt::format("Frame {} Commands", i));
+        }
+    }
 
-    for (uint32_t i = 0; i < commandBuffers.size(); ++i)
+    if (State::instance().settings.recordModelsOnThread)
     {
-        auto commandBuffer = commandBuffers[i];
-        vk::CommandBufferBeginInfo beginInfo{};
-        commandBuffer.begin(beginInfo);
-        // draw shadows
-        renderShadows(commandBuffer, i);
-        // draw colors
-        renderColors(commandBuffer, i);
-        commandBuffer.end();
+        createRecorder();
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Command Buffers");
     }
 }
 
-void Engine::drawFrame(float deltaTime)
+void Engine::createRecorder()
+{
+    auto queueFamilyIndices = SwapChain::findQueueFamiles(physicalDevice.device);
+
+    // models are a few indirect draws whatever their number, so a single thread records all of them
+    // while the main thread records the backdrop and overlay
+    recordModelsOnThread = true;
+    recorder.pools.resize(maxFramesInFlight);
+    recorder.shadowBuffers.resize(maxFramesInFlight);
+    recorder.colorBuffers.resize(maxFramesInFlight);
+    for (int32_t i = 0; i < maxFramesInFlight; ++i)
+    {
+        vk::CommandPoolCreateInfo poolInfo{};
+        poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+        recorder.pools[i] = device.create(poolInfo);
+
+        vk::CommandBufferAllocateInfo allocInfo{};
+        allocInfo.commandPool = recorder.pools[i];
+        allocInfo.level = vk::CommandBufferLevel::eSecondary;
+        allocInfo.commandBufferCount = 2;
+        auto buffers = device.create(allocInfo);
+        recorder.shadowBuffers[i] = buffers[0];
+        recorder.colorBuffers[i] = buffers[1];
+
+        if constexpr (Debug::enable)
+        {
+            Debug::setName(device.device, recorder.pools[i], fmt::format("Recorder Frame {} Pool", i));
+            Debug::setName(device.device, recorder.shadowBuffers[i], fmt::format("Recorder Frame {} Shadows", i));
+            Debug::setName(device.device, recorder.colorBuffers[i], fmt::format("Recorder Frame {} Colors", i));
+        }
+    }
+
+    // backdrop and overlay secondaries come from the main thread's frame pools
+    backdropBuffers.resize(maxFramesInFlight);
+    overlayBuffers.resize(maxFramesInFlight);
+    for (int32_t i = 0; i < maxFramesInFlight; ++i)
+    {
+        vk::CommandBufferAllocateInfo allocInfo{};
+        allocInfo.commandPool = framePools[i];
+        allocInfo.level = vk::CommandBufferLevel::eSecondary;
+        allocInfo.commandBufferCount = 2;
+        auto buffers = device.create(allocInfo);
+        backdropBuffers[i] = buffers[0];
+        overlayBuffers[i] = buffers[1];
+    }
+
+    recordThread.create(1);
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Command Recorder");
+    }
+}
+
+void Engine::beginSecondary(vk::CommandBuffer commandBuffer, vk::RenderPass renderPass, vk::Framebuffer framebuffer)
+{
+    vk::CommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.renderPass = renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = framebuffer;
+
+    vk::CommandBufferBeginInfo beginInfo{};
+    beginInfo.flags =
+        vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    commandBuffer.begin(beginInfo);
+}
+
+void Engine::recordModels(uint32_t currentBuffer)
+{
+    // runs on the recorder thread, only touches the recorder's pool and the model sections' queries
+    auto &state = State::instance();
+    device.reset(recorder.pools[currentFrame]);
+
+    auto shadowBuffer = recorder.shadowBuffers[currentFrame];
+    beginSecondary(shadowBuffer, shadowPass.renderPass, shadowFramebuffers[currentBuffer].framebuffer);
+    setShadowViewport(shadowBuffer);
+    profiler.begin(shadowBuffer, currentFrame, Section::Shadow);
+    state.scene.drawShadow(shadowBuffer, currentBuffer);
+    profiler.end(shadowBuffer, currentFrame, Section::Shadow);
+    shadowBuffer.end();
+
+    auto colorBuffer = recorder.colorBuffers[currentFrame];
+    beginSecondary(colorBuffer, colorPass.renderPass, colorFramebuffers[currentBuffer].framebuffer);
+    setColorViewport(colorBuffer);
+    profiler.begin(colorBuffer, currentFrame, Section::Models);
+    state.scene.drawColor(colorBuffer, currentBuffer);
+    profiler.end(colorBuffer, currentFrame, Section::Models);
+    colorBuffer.end();
+}
+
+void Engine::recordSecondaries(uint32_t currentBuffer)
 {
     auto &state = State::instance();
 
-    if (showOverlay || updateCommandBuffer)
+    auto models = recordThread.submit([this, currentBuffer]() { recordModels(currentBuffer); });
+
+    // backdrop and overlay are recorded here while the recorder runs
+    auto backdropBuffer = backdropBuffers[currentFrame];
+    beginSecondary(backdropBuffer, colorPass.renderPass, colorFramebuffers[currentBuffer].framebuffer);
+    setColorViewport(backdropBuffer);
+    profiler.begin(backdropBuffer, currentFrame, Section::Backdrop);
+    state.scene.backdrop->draw(backdropBuffer, currentBuffer);
+    profiler.end(backdropBuffer, currentFrame, Section::Backdrop);
+    backdropBuffer.end();
+
+    if (showOverlay)
     {
-        updateCommandBuffers();
-        updateCommandBuffer = false;
+        auto overlayBuffer = overlayBuffers[currentFrame];
+        beginSecondary(overlayBuffer, colorPass.renderPass, colorFramebuffers[currentBuffer].framebuffer);
+        setColorViewport(overlayBuffer);
+        profiler.begin(overlayBuffer, currentFrame, Section::Overlay);
+        state.overlay.draw(overlayBuffer, currentBuffer);
+        profiler.end(overlayBuffer, currentFrame, Section::Overlay);
+        overlayBuffer.end();
     }
 
-    if (device.wait(waitFences[currentImage].fence) != vk::Result::eSuccess)
+    // rethrows anything thrown while recording the models
+    models.get();
+}
+
+void Engine::recordCommandBuffer(uint32_t currentBuffer)
+{
+    // fence for this frame has been waited on so nothing in its pool is in use
+    // and its queries from last time are ready
+    device.reset(framePools[currentFrame]);
+    profiler.collect(currentFrame);
+
+    if (recordModelsOnThread)
+    {
+        recordSecondaries(currentBuffer);
+    }
+
+    auto commandBuffer = commandBuffers[currentFrame];
+    vk::CommandBufferBeginInfo beginInfo{};
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    commandBuffer.begin(beginInfo);
+    profiler.reset(commandBuffer, currentFrame);
+    // write this frame's indirect draws
+    State::instance().scene.cull(commandBuffer, currentBuffer);
+    // draw shadows
+    renderShadows(commandBuffer, currentBuffer);
+    // draw colors
+    renderColors(commandBuffer, currentBuffer);
+    commandBuffer.end();
+}
+
+void Engine::drawFrame()
+{
+    auto &state = State::instance();
+
+    // wait for the last submission that used this frame's resources
+    if (device.wait(waitFences[currentFrame].fence) != vk::Result::eSuccess)
     {
         spdlog::error("Unable to wait for fences");
         throw std::runtime_error("Unable to wait for fences");
         return;
     }
-    if (device.reset(waitFences[currentImage].fence) != vk::Result::eSuccess)
+    allocator.setFrame(frameCount);
+
+    uint32_t currentBuffer = (lastBuffer + 1) % swapChain.count;
+    auto result = vk::Result::eSuccess;
+    if (!headless)
     {
-        spdlog::error("Unable to reset fences");
-        throw std::runtime_error("Unable to reset fences");
-        return;
+        result =
+            device.acquireNextImage(swapChain.swapChain, presentSemaphores[currentFrame].semaphore, currentBuffer);
     }
 
-    uint32_t currentBuffer;
-    auto result =
-        device.acquireNextImage(swapChain.swapChain, presentSemaphores[currentImage].semaphore, currentBuffer);
-
-    if ((result == vk::Result::eErrorOutOfDateKHR) || (result == vk::Result::eSuboptimalKHR))
-    {
-        updateCommandBuffers();
+    if (result == vk::Result::eErrorOutOfDateKHR)
+    { // swapchain is recreated by the resize callback
         return;
     }
-    if (result != vk::Result::eSuccess)
+    if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR)
     {
         spdlog::error("Unable to draw command buffer. Error code {}", result);
         throw std::runtime_error("Unable to draw command buffer");
         return;
     }
+    lastBuffer = currentBuffer;
 
-    state.scene.update(currentBuffer, deltaTime);
+    // per image resources (uniforms, overlay buffers) may still be used by another frame in flight
+    if (imageFences[currentBuffer] && imageFences[currentBuffer] != waitFences[currentFrame].fence)
+    {
+        if (device.wait(imageFences[currentBuffer]) != vk::Result::eSuccess)
+        {
+            spdlog::error("Unable to wait for fences");
+            throw std::runtime_error("Unable to wait for fences");
+            return;
+        }
+    }
+    imageFences[currentBuffer] = waitFences[currentFrame].fence;
+
+    if (device.reset(waitFences[currentFrame].fence) != vk::Result::eSuccess)
+    {
+        spdlog::error("Unable to reset fences");
+        throw std::runtime_error("Unable to reset fences");
+        return;
+    }
+
+    state.scene.update(currentBuffer);
+    recordCommandBuffer(currentBuffer);
+
+    // uploads recorded since the last frame go first so this frame can use them
+    uploader.flush();
+    uploader.collect();
 
     const vk::PipelineStageFlags waitStages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
     vk::SubmitInfo submitInfo{};
     submitInfo.pWaitDstStageMask = &waitStages;
-    submitInfo.pWaitSemaphores = &presentSemaphores[currentImage].semaphore;
+    submitInfo.pWaitSemaphores = &presentSemaphores[currentFrame].semaphore;
     submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &renderSemaphores[currentImage].semaphore;
+    submitInfo.pSignalSemaphores = &renderSemaphores[currentFrame].semaphore;
     submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers[currentBuffer];
+    submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
     submitInfo.commandBufferCount = 1;
-    device.graphicsQueue.submit(1, &submitInfo, waitFences[currentImage].fence);
+    if (headless)
+    { // nothing acquired or presented to sync with
+        submitInfo.waitSemaphoreCount = 0;
+        submitInfo.signalSemaphoreCount = 0;
+    }
+    device.graphicsQueue.submit(1, &submitInfo, waitFences[currentFrame].fence);
+    ++frameCount;
+
+    if (headless)
+    {
+        currentFrame = (currentFrame + 1) % maxFramesInFlight;
+        return;
+    }
 
     vk::PresentInfoKHR presentInfo{};
     presentInfo.pNext = nullptr;
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &swapChain.swapChain;
     presentInfo.pImageIndices = &currentBuffer;
-    presentInfo.pWaitSemaphores = &renderSemaphores[currentImage].semaphore;
+    presentInfo.pWaitSemaphores = &renderSemaphores[currentFrame].semaphore;
     presentInfo.waitSemaphoreCount = 1;
     result = device.presentQueue.presentKHR(&presentInfo);
 
-    if (result == vk::Result::eErrorOutOfDateKHR)
-    {
-        updateCommandBuffers();
-        return;
-    }
-    if (result != vk::Result::eSuccess)
+    currentFrame = (currentFrame + 1) % maxFramesInFlight;
+
+    if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR &&
+        result != vk::Result::eErrorOutOfDateKHR)
     {
         spdlog::error("Unable to present command buffer. Error code {}", result);
         throw std::runtime_error("Unable to present command buffer");
         return;
     }
-
-    currentImage = (currentImage + 1) % maxFramesInFlight;
-}
-
-void Engine::updateCommandBuffers()
-{
-    device.wait();
-    device.destroy(commandPool, commandBuffers);
-    createCommandBuffers();
-    device.wait();
 }
 
 void Engine::resize(int width, int height)
@@ -304,33 +546,32 @@ void Engine::resize(int width, int height)
     auto &state = State::instance();
     state.window.resize(width, height);
 
+    uploader.wait();
     device.wait();
 
     // Steps to resize
-    // 1: free commandBuffers
-    device.destroy(commandPool, commandBuffers);
-    // 2: destroy color framebuffers
+    // command buffers are recorded every frame so they don't need to be touched
+    // 1: destroy color framebuffers
     colorFramebuffers.clear();
-    // 3: destroy color renderpass
+    // 2: destroy color renderpass
     colorPass.destroy();
-    // 4: destroy swapchain
+    // 3: destroy swapchain
     swapChain.destroy();
-    // 5: cleanup scene
+    // 4: cleanup scene
     state.scene.cleanup();
-    // 6: cleanup overlay
+    // 5: cleanup overlay
     state.overlay.cleanup();
-    // 7: create swap chain
+    // 6: create swap chain
     swapChain.create();
-    // 8: create color renderpass
+    imageFences.assign(swapChain.count, nullptr);
+    // 7: create color renderpass
     colorPass.create();
-    // 9: recreate scene
+    // 8: recreate scene
     state.scene.recreate();
-    // 10: recreate overlay
+    // 9: recreate overlay
     state.overlay.recreate();
-    // 11: create color framebuffers
+    // 10: create color framebuffers
     createColorFramebuffers();
-    // 12: create commandbuffers
-    createCommandBuffers();
 
     device.wait();
 
@@ -340,6 +581,86 @@ void Engine::resize(int width, int height)
     }
 }
 
+void Engine::capture(const std::string &path)
+{
+    // wait for the frame to finish so the image holds its final contents
+    device.wait();
+
+    Buffer buffer{};
+    buffer.flags = vk::BufferUsageFlagBits::eTransferDst;
+    buffer.memUsage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+    buffer.memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    if constexpr (Debug::enable)
+    {
+        buffer.name = path + " Capture";
+    }
+    buffer.create(static_cast<vk::DeviceSize>(swapChain.extent.width) * swapChain.extent.height * 4);
+
+    auto commandBuffer = uploader.commands();
+
+    // make the render pass writes visible to the copy
+    vk::ImageMemoryBarrier barrier{};
+    barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+    barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = swapChain.images[lastBuffer];
+    barrier.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
+    barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                  vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barrier);
+
+    vk::BufferImageCopy region{};
+    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = vk::Extent3D(swapChain.extent.width, swapChain.extent.height, 1);
+    commandBuffer.copyImageToBuffer(swapChain.images[lastBuffer], vk::ImageLayout::eTransferSrcOptimal,
+                                    buffer.buffer, 1, &region);
+
+    vk::BufferMemoryBarrier hostBarrier{};
+    hostBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    hostBarrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+    hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.buffer = buffer.buffer;
+    hostBarrier.size = VK_WHOLE_SIZE;
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {},
+                                  nullptr, hostBarrier, nullptr);
+
+    uploader.wait();
+    buffer.invalidate();
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        spdlog::error("Unable to open {}", path);
+        throw std::runtime_error("Unable to open capture file");
+    }
+
+    // binary ppm, swizzle bgra to rgb
+    file << "P6\n" << swapChain.extent.width << " " << swapChain.extent.height << "\n255\n";
+    auto bgr = swapChain.format == vk::Format::eB8G8R8A8Unorm;
+    auto *pixels = static_cast<uint8_t *>(buffer.mapped);
+    std::vector<char> row(swapChain.extent.width * 3);
+    for (uint32_t y = 0; y < swapChain.extent.height; ++y)
+    {
+        for (uint32_t x = 0; x < swapChain.extent.width; ++x)
+        {
+            auto *pixel = pixels + (static_cast<size_t>(y) * swapChain.extent.width + x) * 4;
+            row[x * 3 + 0] = static_cast<char>(bgr ? pixel[2] : pixel[0]);
+            row[x * 3 + 1] = static_cast<char>(pixel[1]);
+            row[x * 3 + 2] = static_cast<char>(bgr ? pixel[0] : pixel[2]);
+        }
+        file.write(row.data(), row.size());
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Captured frame to {}", path);
+    }
+}
+
 void Engine::createInstance()
 {
     vk::ApplicationInfo appInfo{};
@@ -349,10 +670,13 @@ void Engine::createInstance()
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.apiVersion = VK_API_VERSION_1_1;
 
-    uint32_t glfwExtensionCount = 0;
-    auto glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char *> extensions{};
+    if (!headless)
+    { // surface extensions
+        uint32_t glfwExtensionCount = 0;
+        auto glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
     if constexpr (Debug::enable)
     {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -452,51 +776,6 @@ void Engine::createColorFramebuffers()
     }
 }
 
-void Engine::createCommandPool()
-{
-    auto QueueFamilyIndices = SwapChain::findQueueFamiles(physicalDevice.device);
-
-    vk::CommandPoolCreateInfo poolInfo{};
-    poolInfo.queueFamilyIndex = QueueFamilyIndices.graphicsFamily.value();
-
-    commandPool = device.create(poolInfo);
-
-    if constexpr (Debug::enable)
-    {
-        spdlog::info("Created Command Pool");
-    }
-}
-
-auto Engine::beginSingleTimeCommands() -> vk::CommandBuffer
-{
-    vk::CommandBufferAllocateInfo allocInfo{};
-    allocInfo.level = vk::CommandBufferLevel::ePrimary;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
-
-    auto commandBuffer = device.create(allocInfo);
-
-    vk::CommandBufferBeginInfo beginInfo = {};
-    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-
-    commandBuffer[0].begin(beginInfo);
-
-    return commandBuffer[0];
-};
-
-void Engine::endSingleTimeCommands(vk::CommandBuffer commandBuffer)
-{
-    commandBuffer.end();
-
-    vk::SubmitInfo submitInfo{};
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    device.graphicsQueue.submit(submitInfo, nullptr);
-    device.graphicsQueue.waitIdle();
-    device.destroy(commandPool, commandBuffer);
-};
-
 auto Engine::createShaderModule(const std::string &filename) -> vk::ShaderModule
 {
     if (!std::filesystem::exists(filename))
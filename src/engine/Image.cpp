@@ -1,10 +1,13 @@
 #include "engine/Image.hpp"
 #include "State.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
+#include <memory>
 #include <stdexcept>
+#include <utility>
 
-#include <gli/gli.hpp>
 #include <spdlog/spdlog.h>
 #include <vk_mem_alloc.h>
 
@@ -87,52 +90,82 @@ void Image::destroy()
 
 void Image::load(const std::string &path)
 {
-    auto &engine = State::instance().engine;
+    decode(path);
+    upload();
+}
+
+void Image::decode(const std::string &path)
+{
     this->path = path;
+    decoded.reset();
     if (!std::filesystem::exists(path))
     {
         spdlog::warn("Unable to load {}", path);
         return;
     }
 
-    auto texture = gli::load(this->path);
-
-    // this really isn't out of range, the enum in gli is weird
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wtautological-constant-out-of-range-compare"
-    if (texture.target() == gli::TARGET_INVALID) // NOLINT
-#pragma clang diagnostic pop
+    // dds and ktx files are mapped, their levels are only read when copied into staging
+    auto texture = std::make_shared<TextureFile>();
+    if (!texture->open(this->path))
     {
         spdlog::warn("Unable to load {}", this->path);
         return;
     }
 
-    Buffer stagingBuffer{};
-    stagingBuffer.flags = vk::BufferUsageFlagBits::eTransferSrc;
-    stagingBuffer.memUsage = VMA_MEMORY_USAGE_CPU_ONLY;
-    if constexpr (Debug::enable)
+    fileExtent = texture->extent;
+    levelSizes.resize(texture->levels);
+    for (uint32_t level = 0; level < texture->levels; ++level)
     {
-        stagingBuffer.name = path + " Staging";
+        levelSizes[level] = texture->size(level) * texture->layers;
     }
-    stagingBuffer.update(texture.data(), texture.size());
+    decoded = std::move(texture);
+}
 
-    imageInfo.extent.width = texture.extent().x;
-    imageInfo.extent.height = texture.extent().y;
-    imageInfo.extent.depth = texture.extent().z;
-    imageInfo.mipLevels = static_cast<uint32_t>(texture.levels());
-    if (texture.target() == gli::TARGET_CUBE)
+auto Image::levelFor(uint32_t maxExtent) const -> uint32_t
+{
+    uint32_t level = 0;
+    if (maxExtent == 0 || levelSizes.empty())
     {
-        imageInfo.arrayLayers = texture.faces();
+        return level;
     }
-    else
+    while (level + 1 < levelSizes.size() &&
+           std::max(fileExtent.width >> level, fileExtent.height >> level) > maxExtent)
     {
-        imageInfo.arrayLayers = texture.layers();
+        ++level;
     }
-    imageInfo.format = static_cast<vk::Format>(texture.format());
+    return level;
+}
 
-    create();
+auto Image::residentSize(uint32_t level) const -> vk::DeviceSize
+{
+    vk::DeviceSize size = 0;
+    for (auto i = static_cast<size_t>(level); i < levelSizes.size(); ++i)
+    {
+        size += levelSizes[i];
+    }
+    return size;
+}
 
-    transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+void Image::upload(uint32_t firstLevel)
+{
+    if (!decoded)
+    { // decode failed, it already warned
+        return;
+    }
+    auto &engine = State::instance().engine;
+    auto &texture = *decoded;
+    auto levels = texture.levels;
+    this->firstLevel = std::min(firstLevel, levels - 1);
+
+    // only the levels kept are staged, the file's level firstLevel becomes level 0 of the image
+    auto staging = engine.uploader.stage(residentSize(this->firstLevel));
+
+    imageInfo.extent = texture.levelExtent(this->firstLevel);
+    imageInfo.mipLevels = levels - this->firstLevel;
+    imageInfo.arrayLayers = texture.layers;
+    imageInfo.format = texture.format;
+
+    create();
 
     imageViewInfo.image = image;
     imageViewInfo.format = imageInfo.format;
@@ -140,50 +173,95 @@ void Image::load(const std::string &path)
     imageViewInfo.subresourceRange.layerCount = imageInfo.arrayLayers;
     imageView = engine.device.create(imageViewInfo);
 
-    auto commandBuffer = engine.beginSingleTimeCommands();
-
     std::vector<vk::BufferImageCopy> bufferCopyRegions;
-    // loop through faces/mipLevels in gli loaded texture and create regions
-    uint32_t offset = 0;
-    for (uint32_t layer = 0; layer < imageViewInfo.subresourceRange.layerCount; layer++)
+    // loop through faces/mipLevels of the file and create regions
+    // each level is copied once, straight from the mapped file into staging
+    auto *destination = static_cast<uint8_t *>(staging.mapped);
+    vk::DeviceSize offset = 0;
+    for (uint32_t layer = 0; layer < imageInfo.arrayLayers; layer++)
     {
-        for (uint32_t level = 0; level < imageInfo.mipLevels; level++)
+        for (uint32_t level = this->firstLevel; level < levels; level++)
         {
-            auto extent(texture.extent(level));
+            auto size = texture.size(level);
+            std::memcpy(destination + offset, texture.data(layer, level), size);
+            auto extent(texture.levelExtent(level));
 
             vk::BufferImageCopy bufferCopyRegion{};
             bufferCopyRegion.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-            bufferCopyRegion.imageSubresource.mipLevel = level;
+            bufferCopyRegion.imageSubresource.mipLevel = level - this->firstLevel;
             bufferCopyRegion.imageSubresource.baseArrayLayer = layer;
             bufferCopyRegion.imageSubresource.layerCount = 1;
-            bufferCopyRegion.imageExtent.width = extent.x;
-            bufferCopyRegion.imageExtent.height = extent.y;
-            bufferCopyRegion.imageExtent.depth = extent.z;
+            bufferCopyRegion.imageExtent = extent;
             bufferCopyRegion.bufferOffset = offset;
 
             bufferCopyRegions.push_back(bufferCopyRegion);
 
-            offset += texture.size(level);
+            offset += size;
         }
     }
 
-    vk::ImageSubresourceRange subresourceRange{};
-    subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    subresourceRange.baseMipLevel = 0;
-    subresourceRange.levelCount = imageInfo.mipLevels;
-    subresourceRange.layerCount = imageViewInfo.subresourceRange.layerCount;
+    // copy the file's levels to image using regions created, runs with the next flush
+    engine.uploader.copy(staging, *this, bufferCopyRegions, vk::ImageLayout::eShaderReadOnlyOptimal);
+    // the file is in staging now, this unmaps it
+    decoded.reset();
 
-    // copy gli loaded texture to image using regious created
-    commandBuffer.copyBufferToImage(stagingBuffer.buffer, image, vk::ImageLayout::eTransferDstOptimal,
-                                    bufferCopyRegions.size(), bufferCopyRegions.data());
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Loaded Image  {} : {}", allocation->descriptor, this->path);
+    }
+}
 
-    engine.endSingleTimeCommands(commandBuffer);
+void Image::copy(Image &source, uint32_t firstLevel)
+{
+    auto &engine = State::instance().engine;
+    path = source.path;
+    fileExtent = source.fileExtent;
+    levelSizes = source.levelSizes;
+    auto levels = static_cast<uint32_t>(levelSizes.size());
+    this->firstLevel = std::clamp(firstLevel, source.firstLevel, levels - 1);
+    // level of source that becomes level 0
+    auto skipped = this->firstLevel - source.firstLevel;
+
+    imageInfo.extent = source.imageInfo.extent;
+    imageInfo.extent.width = std::max(fileExtent.width >> this->firstLevel, 1U);
+    imageInfo.extent.height = std::max(fileExtent.height >> this->firstLevel, 1U);
+    imageInfo.mipLevels = levels - this->firstLevel;
+    imageInfo.arrayLayers = source.imageInfo.arrayLayers;
+    imageInfo.format = source.imageInfo.format;
 
-    transitionImageLayout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+    create();
+
+    imageViewInfo.image = image;
+    imageViewInfo.format = imageInfo.format;
+    imageViewInfo.subresourceRange.levelCount = imageInfo.mipLevels;
+    imageViewInfo.subresourceRange.layerCount = imageInfo.arrayLayers;
+    imageView = engine.device.create(imageViewInfo);
+
+    std::vector<vk::ImageCopy> regions(imageInfo.mipLevels);
+    for (uint32_t level = 0; level < imageInfo.mipLevels; ++level)
+    {
+        auto &region = regions[level];
+        region.srcSubresource = {vk::ImageAspectFlagBits::eColor, skipped + level, 0, imageInfo.arrayLayers};
+        region.dstSubresource = {vk::ImageAspectFlagBits::eColor, level, 0, imageInfo.arrayLayers};
+        // whole levels, so block compressed sizes needn't be a multiple of the block
+        region.extent = vk::Extent3D(std::max(imageInfo.extent.width >> level, 1U),
+                                     std::max(imageInfo.extent.height >> level, 1U), imageInfo.extent.depth);
+    }
+
+    // frames submitted before this may still be sampling source, the barriers wait for them
+    auto commands = engine.uploader.commands();
+    source.transitionImageLayout(commands, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                 vk::ImageLayout::eTransferSrcOptimal);
+    transitionImageLayout(commands, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+    commands.copyImage(source.image, vk::ImageLayout::eTransferSrcOptimal, image,
+                       vk::ImageLayout::eTransferDstOptimal, regions);
+    transitionImageLayout(commands, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+    source.transitionImageLayout(commands, vk::ImageLayout::eTransferSrcOptimal,
+                                 vk::ImageLayout::eShaderReadOnlyOptimal);
 
     if constexpr (Debug::enable)
     {
-        spdlog::info("Loaded Image  {} : {}", allocation->descriptor, this->path);
+        spdlog::info("Copied Image  {} : {} from level {}", allocation->descriptor, path, this->firstLevel);
     }
 }
 
@@ -220,10 +298,7 @@ void Image::resize(int width, int height)
 
 void Image::transitionImageLayout(vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
 {
-    auto &engine = State::instance().engine;
-    vk::CommandBuffer commandBuffer = engine.beginSingleTimeCommands();
-    transitionImageLayout(commandBuffer, oldLayout, newLayout);
-    engine.endSingleTimeCommands(commandBuffer);
+    State::instance().engine.uploader.transition(*this, oldLayout, newLayout);
 }
 
 void Image::transitionImageLayout(vk::CommandBuffer commandBuffer, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
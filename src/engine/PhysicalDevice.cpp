@@ -12,11 +12,18 @@ namespace tat
 
 void PhysicalDevice::pick(const vk::Instance &instance)
 {
+    extensions.clear();
+    if (!State::instance().engine.headless)
+    {
+        extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
+
     for (const auto &physicalDevice : instance.enumeratePhysicalDevices())
     {
         if (isDeviceSuitable(physicalDevice))
         {
             properties = physicalDevice.getProperties();
+            features = physicalDevice.getFeatures();
 
             if constexpr (Debug::enable)
             {
@@ -29,6 +36,21 @@ void PhysicalDevice::pick(const vk::Instance &instance)
 
             device = physicalDevice;
             msaaSamples = getMaxUsableSampleCount();
+
+            for (const auto &deviceExtension : physicalDevice.enumerateDeviceExtensionProperties())
+            {
+                std::string name = deviceExtension.extensionName;
+                if (name == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+                { // lets the allocator report what the driver has in use and available instead of estimating
+                    memoryBudget = true;
+                    extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+                }
+                else if (name == VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)
+                { // lets the cull pass decide how many draws are issued
+                    drawIndirectCount = true;
+                    extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+                }
+            }
             return;
         }
     }
@@ -45,7 +67,11 @@ auto PhysicalDevice::isDeviceSuitable(vk::PhysicalDevice const &physicalDevice)
     auto indiciesComplete = SwapChain::findQueueFamiles(physicalDevice).isComplete();
 
     auto swapChainAdequate = false;
-    if (checkDeviceExtensionsSupport(physicalDevice))
+    if (State::instance().engine.headless)
+    { // nothing is presented
+        swapChainAdequate = checkDeviceExtensionsSupport(physicalDevice);
+    }
+    else if (checkDeviceExtensionsSupport(physicalDevice))
     {
         auto swapChainSupport = SwapChain::querySwapChainSupport(physicalDevice);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -55,6 +81,11 @@ auto PhysicalDevice::isDeviceSuitable(vk::PhysicalDevice const &physicalDevice)
     auto featuresSupported = true;
     featuresSupported = featuresSupported && (supportedFeatures.samplerAnisotropy != VK_FALSE);
     featuresSupported = featuresSupported && (supportedFeatures.geometryShader != VK_FALSE);
+    // models are drawn by a few indirect draws, each reading its model's data with its first instance
+    // and indexing the material textures with it
+    featuresSupported = featuresSupported && (supportedFeatures.multiDrawIndirect != VK_FALSE);
+    featuresSupported = featuresSupported && (supportedFeatures.drawIndirectFirstInstance != VK_FALSE);
+    featuresSupported = featuresSupported && (supportedFeatures.shaderSampledImageArrayDynamicIndexing != VK_FALSE);
 
     return indiciesComplete && swapChainAdequate && featuresSupported;
 };
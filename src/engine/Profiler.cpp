@@ -0,0 +1,246 @@
+#include "engine/Profiler.hpp"
+#include "State.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+void Profiler::create(uint32_t frames, uint32_t slots)
+{
+    auto &state = State::instance();
+    auto &engine = state.engine;
+    auto &settings = state.settings;
+
+    enabled = settings.profiler;
+    if (!enabled)
+    {
+        return;
+    }
+
+    frameCount = frames;
+    slotCount = slots;
+
+    // timestamps need support on the graphics queue
+    auto indices = SwapChain::findQueueFamiles(engine.physicalDevice.device);
+    auto queueFamilies = engine.physicalDevice.device.getQueueFamilyProperties();
+    auto validBits = queueFamilies[indices.graphicsFamily.value()].timestampValidBits;
+    if (validBits == 0)
+    {
+        spdlog::warn("Timestamps not supported on graphics queue, disabling profiler");
+        enabled = false;
+        return;
+    }
+    timestampMask = validBits >= 64 ? ~0ULL : (1ULL << validBits) - 1;
+    timestampPeriod = engine.physicalDevice.properties.limits.timestampPeriod;
+
+    // a begin and end timestamp for every query
+    vk::QueryPoolCreateInfo timestampInfo{};
+    timestampInfo.queryType = vk::QueryType::eTimestamp;
+    timestampInfo.queryCount = frameCount * queriesPerFrame() * 2;
+    timestampPool = engine.device.create(timestampInfo);
+
+    statisticsEnabled = engine.physicalDevice.features.pipelineStatisticsQuery == VK_TRUE;
+    if (statisticsEnabled)
+    {
+        vk::QueryPoolCreateInfo statisticInfo{};
+        statisticInfo.queryType = vk::QueryType::ePipelineStatistics;
+        statisticInfo.queryCount = frameCount * queriesPerFrame();
+        // order matches statisticNames
+        statisticInfo.pipelineStatistics = vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+                                           vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+                                           vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+                                           vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+                                           vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+        statisticPool = engine.device.create(statisticInfo);
+    }
+
+    pending.assign(frameCount, false);
+
+    auto &path = settings.profilerLog;
+    if (!path.empty())
+    {
+        log.open(path);
+        if (!log.is_open())
+        {
+            spdlog::error("Unable to open {}", path);
+            throw std::runtime_error("Unable to open profiler log");
+        }
+        log << "frame";
+        for (auto &section : sectionNames)
+        {
+            log << "," << section << " ms";
+            for (auto &statistic : statisticNames)
+            {
+                log << "," << section << " " << statistic;
+            }
+        }
+        log << "\n";
+    }
+
+    if constexpr (Debug::enable)
+    {
+        Debug::setName(engine.device.device, timestampPool, "Profiler Timestamps");
+        if (statisticsEnabled)
+        {
+            Debug::setName(engine.device.device, statisticPool, "Profiler Statistics");
+        }
+        spdlog::info("Created Profiler with {} slots", slotCount);
+    }
+}
+
+void Profiler::destroy()
+{
+    auto &device = State::instance().engine.device;
+    if (timestampPool)
+    {
+        device.destroy(timestampPool);
+        timestampPool = nullptr;
+    }
+    if (statisticPool)
+    {
+        device.destroy(statisticPool);
+        statisticPool = nullptr;
+    }
+    if (log.is_open())
+    {
+        log.close();
+    }
+    pending.clear();
+    enabled = false;
+}
+
+void Profiler::collect(uint32_t frame)
+{
+    if (!enabled || !pending[frame])
+    {
+        return;
+    }
+
+    auto &device = State::instance().engine.device;
+    auto first = query(frame, Section::Shadow, 0);
+    auto count = queriesPerFrame();
+
+    // value then availability for each query, slots nothing was recorded into come back unavailable
+    std::vector<uint64_t> timestamps(count * 2 * 2);
+    device.getResults(timestampPool, first * 2, count * 2, timestamps, 2 * sizeof(uint64_t),
+                      vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+    constexpr auto statisticStride = statisticCount + 1;
+    std::vector<uint64_t> statistics{};
+    if (statisticsEnabled)
+    {
+        statistics.resize(count * statisticStride);
+        device.getResults(statisticPool, first, count, statistics, statisticStride * sizeof(uint64_t),
+                          vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+    }
+
+    for (uint32_t section = 0; section < sectionCount; ++section)
+    {
+        Result result{};
+
+        // slots are recorded one after another so the section spans the earliest begin to the latest end
+        auto beginTime = UINT64_MAX;
+        uint64_t endTime = 0;
+        for (uint32_t slot = 0; slot < slotCount; ++slot)
+        {
+            auto index = section * slotCount + slot;
+            auto *timestamp = &timestamps[index * 4];
+            if (timestamp[1] != 0 && timestamp[3] != 0)
+            {
+                beginTime = std::min(beginTime, timestamp[0] & timestampMask);
+                endTime = std::max(endTime, timestamp[2] & timestampMask);
+            }
+
+            if (statisticsEnabled)
+            {
+                auto *statistic = &statistics[index * statisticStride];
+                if (statistic[statisticCount] != 0)
+                {
+                    for (uint32_t i = 0; i < statisticCount; ++i)
+                    {
+                        result.statistics[i] += statistic[i];
+                    }
+                }
+            }
+        }
+
+        if (endTime > beginTime)
+        {
+            result.milliseconds = static_cast<float>(endTime - beginTime) * timestampPeriod / 1000000.F;
+        }
+        results[section] = result;
+    }
+
+    writeLog();
+}
+
+void Profiler::reset(vk::CommandBuffer commandBuffer, uint32_t frame)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    auto first = query(frame, Section::Shadow, 0);
+    commandBuffer.resetQueryPool(timestampPool, first * 2, queriesPerFrame() * 2);
+    if (statisticsEnabled)
+    {
+        commandBuffer.resetQueryPool(statisticPool, first, queriesPerFrame());
+    }
+    pending[frame] = true;
+}
+
+void Profiler::begin(vk::CommandBuffer commandBuffer, uint32_t frame, Section section, uint32_t slot)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    auto index = query(frame, section, slot);
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, timestampPool, index * 2);
+    if (statisticsEnabled)
+    {
+        commandBuffer.beginQuery(statisticPool, index, {});
+    }
+}
+
+void Profiler::end(vk::CommandBuffer commandBuffer, uint32_t frame, Section section, uint32_t slot)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    auto index = query(frame, section, slot);
+    if (statisticsEnabled)
+    {
+        commandBuffer.endQuery(statisticPool, index);
+    }
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, timestampPool, index * 2 + 1);
+}
+
+void Profiler::writeLog()
+{
+    if (!log.is_open())
+    {
+        return;
+    }
+
+    log << collected++;
+    for (auto &result : results)
+    {
+        log << "," << result.milliseconds;
+        for (auto &statistic : result.statistics)
+        {
+            log << "," << statistic;
+        }
+    }
+    log << "\n";
+}
+
+} // namespace tat
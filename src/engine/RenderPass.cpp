@@ -60,7 +60,9 @@ void RenderPass::loadColor()
     attachments[2].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
     attachments[2].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
     attachments[2].initialLayout = vk::ImageLayout::eUndefined;
-    attachments[2].finalLayout = vk::ImageLayout::ePresentSrcKHR;
+    // headless targets are copied out instead of presented
+    attachments[2].finalLayout =
+        engine.headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
 
     resolveReference.attachment = 2;
     resolveReference.layout = vk::ImageLayout::eColorAttachmentOptimal;
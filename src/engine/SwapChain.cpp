@@ -12,6 +12,12 @@ void SwapChain::create()
     auto &engine = state.engine;
     auto &window = state.window;
 
+    if (engine.headless)
+    {
+        createOffscreen();
+        return;
+    }
+
     auto swapChainSupport = querySwapChainSupport(engine.physicalDevice.device);
     auto surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
     format = surfaceFormat.format;
@@ -80,10 +86,56 @@ void SwapChain::create()
     }
 }
 
+void SwapChain::createOffscreen()
+{
+    auto &state = State::instance();
+
+    // same format a window surface would normally get
+    format = vk::Format::eB8G8R8A8Unorm;
+    extent = vk::Extent2D(state.window.width, state.window.height);
+    count = offscreenCount;
+
+    targets.resize(count);
+    images.resize(count);
+    imageViews.resize(count);
+    for (int32_t i = 0; i < count; ++i)
+    {
+        auto &target = targets[i];
+        target.imageInfo.format = format;
+        target.imageInfo.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+        target.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+        target.resize(extent);
+        images[i] = target.image;
+        imageViews[i] = target.imageView;
+
+        if constexpr (Debug::enable)
+        {
+            Debug::setName(state.engine.device.device, target.image, fmt::format("Offscreen {}", i));
+        }
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Offscreen SwapChain");
+    }
+}
+
 void SwapChain::destroy()
 {
     auto &device = State::instance().engine.device;
 
+    if (!targets.empty())
+    { // image views are owned by the targets
+        for (auto &target : targets)
+        {
+            target.destroy();
+        }
+        targets.clear();
+        images.clear();
+        imageViews.clear();
+        return;
+    }
+
     for (auto imageView : imageViews)
     {
         device.destroy(imageView);
@@ -99,7 +151,7 @@ void SwapChain::destroy()
 
 auto SwapChain::findQueueFamiles(vk::PhysicalDevice const &physicalDevice) -> QueueFamilyIndices
 {
-    auto &surface = State::instance().engine.surface;
+    auto &engine = State::instance().engine;
 
     QueueFamilyIndices indices;
 
@@ -107,23 +159,42 @@ auto SwapChain::findQueueFamiles(vk::PhysicalDevice const &physicalDevice) -> Qu
 
     for (int i = 0; i < queueFamilies.size(); ++i)
     {
-        if (queueFamilies[i].queueCount > 0 && (queueFamilies[i].queueFlags & vk::QueueFlagBits::eGraphics))
+        if (queueFamilies[i].queueCount == 0)
         {
-            indices.graphicsFamily = i;
+            continue;
         }
 
-        auto presentSupport = physicalDevice.getSurfaceSupportKHR(i, surface);
+        auto flags = queueFamilies[i].queueFlags;
+        if (!indices.graphicsFamily.has_value() && (flags & vk::QueueFlagBits::eGraphics))
+        {
+            indices.graphicsFamily = i;
+        }
 
-        if (queueFamilies[i].queueCount > 0 && (presentSupport != VK_FALSE))
+        // dedicated transfer families map to the copy engine and run alongside graphics
+        if (!indices.transferFamily.has_value() && (flags & vk::QueueFlagBits::eTransfer) &&
+            !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
         {
-            indices.presentFamily = i;
+            indices.transferFamily = i;
         }
 
-        if (indices.isComplete())
+        if (!engine.headless && !indices.presentFamily.has_value())
         {
-            break;
+            auto presentSupport = physicalDevice.getSurfaceSupportKHR(i, engine.surface);
+            if (presentSupport != VK_FALSE)
+            {
+                indices.presentFamily = i;
+            }
         }
     }
+
+    if (engine.headless)
+    { // nothing is presented, graphics queue stands in
+        indices.presentFamily = indices.graphicsFamily;
+    }
+    if (!indices.transferFamily.has_value())
+    { // graphics queues always support transfer
+        indices.transferFamily = indices.graphicsFamily;
+    }
     return indices;
 }
 
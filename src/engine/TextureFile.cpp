@@ -0,0 +1,421 @@
+#include "engine/TextureFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+
+#include <gli/gli.hpp>
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+namespace
+{
+
+// formats read in place, anything else goes through gli
+struct FormatInfo
+{
+    uint32_t dxgi;
+    uint32_t gl; // internal format, 0 when ktx files don't use it
+    vk::Format format;
+    uint32_t blockExtent; // 4 for block compressed formats
+    uint32_t blockSize;   // bytes per block or pixel
+};
+
+constexpr std::array<FormatInfo, 21> formats{{
+    {28, 0x8058, vk::Format::eR8G8B8A8Unorm, 1, 4},
+    {29, 0x8C43, vk::Format::eR8G8B8A8Srgb, 1, 4},
+    {87, 0, vk::Format::eB8G8R8A8Unorm, 1, 4},
+    {91, 0, vk::Format::eB8G8R8A8Srgb, 1, 4},
+    {61, 0x8229, vk::Format::eR8Unorm, 1, 1},
+    {49, 0x822B, vk::Format::eR8G8Unorm, 1, 2},
+    {34, 0x822F, vk::Format::eR16G16Sfloat, 1, 4},
+    {10, 0x881A, vk::Format::eR16G16B16A16Sfloat, 1, 8},
+    {2, 0x8814, vk::Format::eR32G32B32A32Sfloat, 1, 16},
+    {71, 0x83F1, vk::Format::eBc1RgbaUnormBlock, 4, 8},
+    {72, 0x8C4D, vk::Format::eBc1RgbaSrgbBlock, 4, 8},
+    {74, 0x83F2, vk::Format::eBc2UnormBlock, 4, 16},
+    {75, 0x8C4E, vk::Format::eBc2SrgbBlock, 4, 16},
+    {77, 0x83F3, vk::Format::eBc3UnormBlock, 4, 16},
+    {78, 0x8C4F, vk::Format::eBc3SrgbBlock, 4, 16},
+    {80, 0x8DBB, vk::Format::eBc4UnormBlock, 4, 8},
+    {83, 0x8DBD, vk::Format::eBc5UnormBlock, 4, 16},
+    {95, 0x8E8F, vk::Format::eBc6HUfloatBlock, 4, 16},
+    {96, 0x8E8E, vk::Format::eBc6HSfloatBlock, 4, 16},
+    {98, 0x8E8C, vk::Format::eBc7UnormBlock, 4, 16},
+    {99, 0x8E8D, vk::Format::eBc7SrgbBlock, 4, 16},
+}};
+
+auto findFormat(vk::Format format) -> const FormatInfo *
+{
+    auto it = std::find_if(formats.begin(), formats.end(), [format](auto &info) { return info.format == format; });
+    return it != formats.end() ? &*it : nullptr;
+}
+
+auto fromDxgi(uint32_t dxgi) -> vk::Format
+{
+    auto it = std::find_if(formats.begin(), formats.end(), [dxgi](auto &info) { return info.dxgi == dxgi; });
+    return it != formats.end() ? it->format : vk::Format::eUndefined;
+}
+
+auto fromGl(uint32_t gl) -> vk::Format
+{
+    auto it = std::find_if(formats.begin(), formats.end(), [gl](auto &info) { return info.gl == gl && gl != 0; });
+    return it != formats.end() ? it->format : vk::Format::eUndefined;
+}
+
+constexpr auto fourCC(char a, char b, char c, char d) -> uint32_t
+{
+    return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8U | static_cast<uint32_t>(c) << 16U |
+           static_cast<uint32_t>(d) << 24U;
+}
+
+struct DdsPixelFormat
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t bitCount;
+    uint32_t rMask;
+    uint32_t gMask;
+    uint32_t bMask;
+    uint32_t aMask;
+};
+
+struct DdsHeader
+{
+    uint32_t magic;
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitch;
+    uint32_t depth;
+    uint32_t mipCount;
+    uint32_t reserved[11];
+    DdsPixelFormat format;
+    uint32_t caps[4];
+    uint32_t reserved2;
+};
+
+struct DdsHeaderDx10
+{
+    uint32_t format;
+    uint32_t dimension;
+    uint32_t miscFlags;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+struct KtxHeader
+{
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t arrayElements;
+    uint32_t faces;
+    uint32_t mipLevels;
+    uint32_t keyValueBytes;
+};
+
+constexpr uint32_t ddsFourCC = 0x4;
+constexpr uint32_t ddsRgb = 0x40;
+constexpr uint32_t ddsDepth = 0x800000;
+constexpr uint32_t ddsCubeMap = 0x200;
+constexpr uint32_t ddsCubeFaces = 0xFC00;
+constexpr uint32_t dx10CubeMap = 0x4;
+constexpr std::array<uint8_t, 12> ktxIdentifier{0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+} // namespace
+
+auto TextureFile::open(const std::string &path) -> bool
+{
+    if (map(path))
+    {
+        // the levels are copied out on the main thread, have them read in by then
+        file.prefetch();
+        return true;
+    }
+    return openGli(path);
+}
+
+auto TextureFile::map(const std::string &path) -> bool
+{
+    pointers.clear();
+    sizes.clear();
+    texture.reset();
+
+    if (file.open(path) && (openDds() || openKtx()))
+    {
+        return true;
+    }
+    file.close();
+    return false;
+}
+
+auto TextureFile::save(const std::string &path) const -> bool
+{
+    auto *info = findFormat(format);
+    if (info == nullptr || extent.depth > 1)
+    {
+        return false;
+    }
+
+    DdsHeader header{};
+    header.magic = fourCC('D', 'D', 'S', ' ');
+    header.size = sizeof(DdsHeader) - sizeof(uint32_t);
+    // caps, height, width, pixel format and mip count are set
+    header.flags = 0x1U | 0x2U | 0x4U | 0x1000U | 0x20000U;
+    header.height = extent.height;
+    header.width = extent.width;
+    header.mipCount = levels;
+    header.format.size = sizeof(DdsPixelFormat);
+    header.format.flags = ddsFourCC;
+    header.format.fourCC = fourCC('D', 'X', '1', '0');
+    // texture, mipmap and complex caps
+    header.caps[0] = 0x1000U | 0x400000U | 0x8U;
+    header.caps[1] = cube ? ddsCubeMap | ddsCubeFaces : 0U;
+
+    DdsHeaderDx10 dx10{};
+    dx10.format = info->dxgi;
+    dx10.dimension = 3; // texture 2d
+    dx10.miscFlags = cube ? dx10CubeMap : 0U;
+    dx10.arraySize = cube ? layers / 6 : layers;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(&dx10), sizeof(dx10));
+    // same order openDds reads them in
+    for (uint32_t layer = 0; layer < layers; ++layer)
+    {
+        for (uint32_t level = 0; level < levels; ++level)
+        {
+            out.write(reinterpret_cast<const char *>(data(layer, level)), static_cast<std::streamsize>(sizes[level]));
+        }
+    }
+    return out.good();
+}
+
+auto TextureFile::levelExtent(uint32_t level) const -> vk::Extent3D
+{
+    return vk::Extent3D(std::max(extent.width >> level, 1U), std::max(extent.height >> level, 1U),
+                        std::max(extent.depth >> level, 1U));
+}
+
+auto TextureFile::computeSizes() -> bool
+{
+    auto *info = findFormat(format);
+    if (info == nullptr)
+    {
+        return false;
+    }
+    sizes.resize(levels);
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        auto size = levelExtent(level);
+        auto blocksWide = (size.width + info->blockExtent - 1) / info->blockExtent;
+        auto blocksHigh = (size.height + info->blockExtent - 1) / info->blockExtent;
+        sizes[level] = static_cast<vk::DeviceSize>(blocksWide) * blocksHigh * size.depth * info->blockSize;
+    }
+    return true;
+}
+
+auto TextureFile::openDds() -> bool
+{
+    if (file.size() < sizeof(DdsHeader))
+    {
+        return false;
+    }
+    DdsHeader header{};
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != fourCC('D', 'D', 'S', ' ') || header.size != sizeof(DdsHeader) - sizeof(uint32_t))
+    {
+        return false;
+    }
+    size_t offset = sizeof(DdsHeader);
+
+    extent = vk::Extent3D(header.width, std::max(header.height, 1U),
+                          (header.flags & ddsDepth) != 0 ? std::max(header.depth, 1U) : 1U);
+    levels = std::max(header.mipCount, 1U);
+    cube = (header.caps[1] & ddsCubeMap) != 0;
+    auto arraySize = 1U;
+    format = vk::Format::eUndefined;
+
+    auto &pixel = header.format;
+    if ((pixel.flags & ddsFourCC) != 0)
+    {
+        switch (pixel.fourCC)
+        {
+        case fourCC('D', 'X', '1', '0'): {
+            if (file.size() < offset + sizeof(DdsHeaderDx10))
+            {
+                return false;
+            }
+            DdsHeaderDx10 dx10{};
+            std::memcpy(&dx10, file.data() + offset, sizeof(dx10));
+            offset += sizeof(dx10);
+            format = fromDxgi(dx10.format);
+            arraySize = std::max(dx10.arraySize, 1U);
+            cube = cube || (dx10.miscFlags & dx10CubeMap) != 0;
+            break;
+        }
+        case fourCC('D', 'X', 'T', '1'):
+            format = vk::Format::eBc1RgbaUnormBlock;
+            break;
+        case fourCC('D', 'X', 'T', '3'):
+            format = vk::Format::eBc2UnormBlock;
+            break;
+        case fourCC('D', 'X', 'T', '5'):
+            format = vk::Format::eBc3UnormBlock;
+            break;
+        case fourCC('A', 'T', 'I', '1'):
+        case fourCC('B', 'C', '4', 'U'):
+            format = vk::Format::eBc4UnormBlock;
+            break;
+        case fourCC('A', 'T', 'I', '2'):
+        case fourCC('B', 'C', '5', 'U'):
+            format = vk::Format::eBc5UnormBlock;
+            break;
+        case 112: // D3DFMT_G16R16F
+            format = vk::Format::eR16G16Sfloat;
+            break;
+        case 113: // D3DFMT_A16B16G16R16F
+            format = vk::Format::eR16G16B16A16Sfloat;
+            break;
+        case 116: // D3DFMT_A32B32G32R32F
+            format = vk::Format::eR32G32B32A32Sfloat;
+            break;
+        default:
+            break;
+        }
+    }
+    else if ((pixel.flags & ddsRgb) != 0 && pixel.bitCount == 32)
+    {
+        if (pixel.rMask == 0x000000FF && pixel.gMask == 0x0000FF00 && pixel.bMask == 0x00FF0000)
+        {
+            format = vk::Format::eR8G8B8A8Unorm;
+        }
+        else if (pixel.rMask == 0x00FF0000 && pixel.gMask == 0x0000FF00 && pixel.bMask == 0x000000FF)
+        {
+            format = vk::Format::eB8G8R8A8Unorm;
+        }
+    }
+    if (!computeSizes())
+    {
+        return false;
+    }
+    layers = arraySize * (cube ? 6 : 1);
+
+    // every level of a face before the next face, every face of a layer before the next layer
+    pointers.resize(static_cast<size_t>(layers) * levels);
+    for (uint32_t layer = 0; layer < layers; ++layer)
+    {
+        for (uint32_t level = 0; level < levels; ++level)
+        {
+            if (offset + sizes[level] > file.size())
+            {
+                spdlog::warn("Truncated DDS file");
+                return false;
+            }
+            pointers[layer * levels + level] = file.data() + offset;
+            offset += sizes[level];
+        }
+    }
+    return true;
+}
+
+auto TextureFile::openKtx() -> bool
+{
+    if (file.size() < sizeof(KtxHeader))
+    {
+        return false;
+    }
+    KtxHeader header{};
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.identifier, ktxIdentifier.data(), ktxIdentifier.size()) != 0 ||
+        header.endianness != 0x04030201)
+    { // files written on the other endianness go through gli
+        return false;
+    }
+
+    extent = vk::Extent3D(header.width, std::max(header.height, 1U), std::max(header.depth, 1U));
+    levels = std::max(header.mipLevels, 1U);
+    cube = header.faces == 6;
+    format = fromGl(header.glInternalFormat);
+    if (!computeSizes())
+    {
+        return false;
+    }
+    layers = std::max(header.arrayElements, 1U) * header.faces;
+
+    // every layer and face of a level after its size, faces of a cube that isn't an array are padded to 4 bytes
+    pointers.resize(static_cast<size_t>(layers) * levels);
+    size_t offset = sizeof(KtxHeader) + header.keyValueBytes;
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        offset += sizeof(uint32_t);
+        auto stride = cube && header.arrayElements == 0 ? (sizes[level] + 3) / 4 * 4 : sizes[level];
+        if (offset + stride * layers > file.size())
+        {
+            spdlog::warn("Truncated KTX file");
+            return false;
+        }
+        for (uint32_t layer = 0; layer < layers; ++layer)
+        {
+            pointers[layer * levels + level] = file.data() + offset;
+            offset += stride;
+        }
+        // levels start 4 byte aligned
+        offset = (offset + 3) / 4 * 4;
+    }
+    return true;
+}
+
+auto TextureFile::openGli(const std::string &path) -> bool
+{
+    texture = std::make_shared<gli::texture>(gli::load(path));
+
+    // this really isn't out of range, the enum in gli is weird
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wtautological-constant-out-of-range-compare"
+    if (texture->target() == gli::TARGET_INVALID) // NOLINT
+#pragma clang diagnostic pop
+    {
+        texture.reset();
+        return false;
+    }
+
+    format = static_cast<vk::Format>(texture->format());
+    extent = vk::Extent3D(texture->extent().x, texture->extent().y, texture->extent().z);
+    levels = static_cast<uint32_t>(texture->levels());
+    cube = texture->target() == gli::TARGET_CUBE;
+    auto faces = static_cast<uint32_t>(texture->faces());
+    layers = static_cast<uint32_t>(texture->layers()) * faces;
+
+    sizes.resize(levels);
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        sizes[level] = texture->size(level);
+    }
+    pointers.resize(static_cast<size_t>(layers) * levels);
+    for (uint32_t layer = 0; layer < layers; ++layer)
+    {
+        for (uint32_t level = 0; level < levels; ++level)
+        {
+            pointers[layer * levels + level] =
+                static_cast<const uint8_t *>(texture->data(layer / faces, layer % faces, level));
+        }
+    }
+    return true;
+}
+
+} // namespace tat
@@ -0,0 +1,73 @@
+#include "engine/UniformArena.hpp"
+#include "State.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+void UniformArena::create(uint32_t frames, vk::DeviceSize frameSize)
+{
+    auto &engine = State::instance().engine;
+    auto &limits = engine.physicalDevice.properties.limits;
+    alignment = std::max<vk::DeviceSize>(
+        {1, limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment});
+    regionSize = align(frameSize);
+    regionStart = 0;
+    cursor = 0;
+
+    memory.flags = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer;
+    memory.memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    memory.memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    if constexpr (Debug::enable)
+    {
+        memory.name = "Uniform Arena";
+    }
+    memory.create(regionSize * frames);
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Created Uniform Arena of {} bytes per frame", regionSize);
+    }
+}
+
+void UniformArena::destroy()
+{
+    memory.destroy();
+}
+
+auto UniformArena::align(vk::DeviceSize size) -> vk::DeviceSize
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void UniformArena::begin(uint32_t currentImage)
+{
+    regionStart = regionSize * currentImage;
+    cursor = 0;
+}
+
+auto UniformArena::push(const void *data, vk::DeviceSize size) -> uint32_t
+{
+    if (cursor + size > regionSize)
+    {
+        spdlog::error("Uniform Arena out of space, {} of {} bytes used", cursor, regionSize);
+        throw std::runtime_error("Uniform Arena out of space");
+    }
+
+    auto offset = regionStart + cursor;
+    std::memcpy(static_cast<uint8_t *>(memory.mapped) + offset, data, size);
+    cursor += align(size);
+    return static_cast<uint32_t>(offset);
+}
+
+void UniformArena::end()
+{
+    memory.flush(cursor, regionStart);
+}
+
+} // namespace tat
@@ -0,0 +1,393 @@
+#include "engine/Uploader.hpp"
+#include "State.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+namespace tat
+{
+
+void Uploader::create()
+{
+    auto &engine = State::instance().engine;
+    auto indices = SwapChain::findQueueFamiles(engine.physicalDevice.device);
+    graphicsFamily = indices.graphicsFamily.value();
+    transferFamily = indices.transferFamily.value();
+    dedicated = graphicsFamily != transferFamily;
+
+    vk::CommandPoolCreateInfo poolInfo{};
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    poolInfo.queueFamilyIndex = transferFamily;
+    transferPool = engine.device.create(poolInfo);
+    poolInfo.queueFamilyIndex = graphicsFamily;
+    graphicsPool = engine.device.create(poolInfo);
+
+    // copies into images need offsets aligned to the texel block, 16 covers every format loaded
+    alignment = std::max<vk::DeviceSize>(16, engine.physicalDevice.properties.limits.optimalBufferCopyOffsetAlignment);
+    ringSize = State::instance().settings.stagingSize * 1024 * 1024;
+    ring.flags = vk::BufferUsageFlagBits::eTransferSrc;
+    ring.memUsage = VMA_MEMORY_USAGE_CPU_ONLY;
+    ring.memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    if constexpr (Debug::enable)
+    {
+        ring.name = "Uploader Staging Ring";
+    }
+    ring.create(ringSize);
+    ringHead = 0;
+    ringTail = 0;
+    ringUsed = 0;
+
+    if constexpr (Debug::enable)
+    {
+        Debug::setName(engine.device.device, transferPool, "Uploader Transfer Pool");
+        Debug::setName(engine.device.device, graphicsPool, "Uploader Graphics Pool");
+        spdlog::info("Created Uploader with {} MiB staging {}", ringSize / (1024 * 1024),
+                     dedicated ? "on dedicated transfer queue" : "on graphics queue");
+    }
+}
+
+void Uploader::destroy()
+{
+    auto &device = State::instance().engine.device;
+    if (graphicsPool)
+    {
+        wait();
+        ring.destroy();
+        device.destroy(transferPool);
+        device.destroy(graphicsPool);
+        transferPool = nullptr;
+        graphicsPool = nullptr;
+    }
+
+    if constexpr (Debug::enable)
+    {
+        spdlog::info("Destroyed Uploader");
+    }
+}
+
+auto Uploader::current() -> Batch &
+{
+    if (recording)
+    {
+        return batch;
+    }
+
+    auto &device = State::instance().engine.device;
+
+    vk::CommandBufferAllocateInfo allocInfo{};
+    allocInfo.level = vk::CommandBufferLevel::ePrimary;
+    allocInfo.commandBufferCount = 1;
+    allocInfo.commandPool = transferPool;
+    batch.transfer = device.create(allocInfo)[0];
+    allocInfo.commandPool = graphicsPool;
+    batch.graphics = device.create(allocInfo)[0];
+
+    vk::CommandBufferBeginInfo beginInfo{};
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    batch.transfer.begin(beginInfo);
+    batch.graphics.begin(beginInfo);
+
+    recording = true;
+    return batch;
+}
+
+auto Uploader::stage(vk::DeviceSize size) -> Staging
+{
+    Staging staging{};
+    staging.size = size;
+
+    if (size > ringSize)
+    { // would never fit, give it a buffer of its own that lives as long as the batch
+        auto &buffer = current().staging.emplace_back(std::make_unique<Buffer>());
+        buffer->flags = vk::BufferUsageFlagBits::eTransferSrc;
+        buffer->memUsage = VMA_MEMORY_USAGE_CPU_ONLY;
+        buffer->memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        if constexpr (Debug::enable)
+        {
+            buffer->name = "Uploader Staging";
+        }
+        buffer->create(size);
+
+        staging.buffer = buffer->buffer;
+        staging.mapped = buffer->mapped;
+        return staging;
+    }
+
+    auto &device = State::instance().engine.device;
+    auto used = ringUsed;
+    while (!allocate(size, staging.offset))
+    {
+        if (recording && batch.ringUsed > 0)
+        { // the current batch holds ring space, submit it so it can be waited on
+            flush();
+        }
+        if (inFlight.empty())
+        {
+            spdlog::error("Unable to allocate {} bytes of staging memory", size);
+            throw std::runtime_error("Unable to allocate staging memory");
+        }
+
+        // oldest batch frees the space the ring head runs into next
+        auto &oldest = inFlight.front();
+        if (device.wait(oldest.fence) != vk::Result::eSuccess)
+        {
+            spdlog::error("Unable to wait for upload");
+            throw std::runtime_error("Unable to wait for upload");
+        }
+        release(oldest);
+        inFlight.pop_front();
+        used = ringUsed;
+    }
+
+    auto &current = this->current();
+    current.ringUsed += ringUsed - used;
+    current.ringEnd = ringHead;
+
+    staging.buffer = ring.buffer;
+    staging.mapped = static_cast<uint8_t *>(ring.mapped) + staging.offset;
+    return staging;
+}
+
+auto Uploader::stage(const void *data, vk::DeviceSize size) -> Staging
+{
+    auto staging = stage(size);
+    std::memcpy(staging.mapped, data, size);
+    return staging;
+}
+
+auto Uploader::allocate(vk::DeviceSize size, vk::DeviceSize &offset) -> bool
+{
+    if (ringUsed == 0)
+    { // nothing in use, start over so the whole ring is one free block
+        ringHead = 0;
+        ringTail = 0;
+    }
+
+    auto aligned = (ringHead + alignment - 1) / alignment * alignment;
+    auto wrapped = false;
+    if (ringUsed == 0 || ringHead > ringTail)
+    { // free space runs from the head to the end, then from the start to the tail
+        if (aligned + size <= ringSize)
+        {
+            offset = aligned;
+        }
+        else if (size <= ringTail)
+        {
+            offset = 0;
+            wrapped = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else
+    { // head has wrapped, free space runs up to the tail, none when they meet
+        if (aligned + size > ringTail)
+        {
+            return false;
+        }
+        offset = aligned;
+    }
+
+    // padding skipped at the end of the ring or for alignment counts as used until the batch finishes
+    ringUsed += wrapped ? ringSize - ringHead + size : offset + size - ringHead;
+    ringHead = offset + size;
+    return true;
+}
+
+void Uploader::copy(const Staging &source, Buffer &destination)
+{
+    auto &current = this->current();
+
+    vk::BufferCopy copyRegion{};
+    copyRegion.srcOffset = source.offset;
+    copyRegion.size = source.size;
+    current.transfer.copyBuffer(source.buffer, destination.buffer, 1, &copyRegion);
+
+    vk::BufferMemoryBarrier barrier{};
+    barrier.buffer = destination.buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    if (!dedicated)
+    {
+        current.transfer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                         vk::PipelineStageFlagBits::eAllCommands, {}, nullptr, barrier, nullptr);
+        return;
+    }
+
+    // release on transfer, acquire on graphics
+    barrier.srcQueueFamilyIndex = transferFamily;
+    barrier.dstQueueFamilyIndex = graphicsFamily;
+    barrier.dstAccessMask = {};
+    current.transfer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+                                     {}, nullptr, barrier, nullptr);
+    barrier.srcAccessMask = {};
+    barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+    current.graphics.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands,
+                                     {}, nullptr, barrier, nullptr);
+}
+
+void Uploader::copy(const Staging &source, Image &destination, std::vector<vk::BufferImageCopy> &regions,
+                    vk::ImageLayout finalLayout)
+{
+    auto &current = this->current();
+
+    vk::ImageMemoryBarrier barrier{};
+    barrier.image = destination.image;
+    barrier.subresourceRange.aspectMask = destination.imageViewInfo.subresourceRange.aspectMask;
+    barrier.subresourceRange.levelCount = destination.imageInfo.mipLevels;
+    barrier.subresourceRange.layerCount = destination.imageInfo.arrayLayers;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+    // contents are replaced so the old layout doesn't matter
+    barrier.oldLayout = vk::ImageLayout::eUndefined;
+    barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    current.transfer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+                                     {}, nullptr, nullptr, barrier);
+
+    for (auto &region : regions)
+    {
+        region.bufferOffset += source.offset;
+    }
+    current.transfer.copyBufferToImage(source.buffer, destination.image, vk::ImageLayout::eTransferDstOptimal,
+                                       regions);
+
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.newLayout = finalLayout;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+    if (!dedicated)
+    {
+        current.transfer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                         vk::PipelineStageFlagBits::eAllCommands, {}, nullptr, nullptr, barrier);
+    }
+    else
+    { // release on transfer, acquire on graphics, both do the same layout change
+        barrier.srcQueueFamilyIndex = transferFamily;
+        barrier.dstQueueFamilyIndex = graphicsFamily;
+        barrier.dstAccessMask = {};
+        current.transfer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                         vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr, barrier);
+        barrier.srcAccessMask = {};
+        barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+        current.graphics.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                         vk::PipelineStageFlagBits::eAllCommands, {}, nullptr, nullptr, barrier);
+    }
+
+    destination.currentLayout = finalLayout;
+}
+
+void Uploader::transition(Image &image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
+{
+    image.transitionImageLayout(current().graphics, oldLayout, newLayout);
+}
+
+auto Uploader::commands() -> vk::CommandBuffer
+{
+    return current().graphics;
+}
+
+void Uploader::flush()
+{
+    if (!recording)
+    {
+        return;
+    }
+
+    auto &engine = State::instance().engine;
+    batch.transfer.end();
+    batch.graphics.end();
+    batch.fence = engine.device.create(vk::FenceCreateInfo{});
+
+    if (dedicated)
+    {
+        batch.semaphore = engine.device.create(vk::SemaphoreCreateInfo{});
+
+        vk::SubmitInfo transferInfo{};
+        transferInfo.commandBufferCount = 1;
+        transferInfo.pCommandBuffers = &batch.transfer;
+        transferInfo.signalSemaphoreCount = 1;
+        transferInfo.pSignalSemaphores = &batch.semaphore;
+        engine.device.transferQueue.submit(transferInfo, nullptr);
+
+        const vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+        vk::SubmitInfo graphicsInfo{};
+        graphicsInfo.waitSemaphoreCount = 1;
+        graphicsInfo.pWaitSemaphores = &batch.semaphore;
+        graphicsInfo.pWaitDstStageMask = &waitStage;
+        graphicsInfo.commandBufferCount = 1;
+        graphicsInfo.pCommandBuffers = &batch.graphics;
+        engine.device.graphicsQueue.submit(graphicsInfo, batch.fence);
+    }
+    else
+    { // same queue, barriers recorded with the copies order everything
+        std::array<vk::CommandBuffer, 2> commandBuffers = {batch.transfer, batch.graphics};
+        vk::SubmitInfo submitInfo{};
+        submitInfo.commandBufferCount = commandBuffers.size();
+        submitInfo.pCommandBuffers = commandBuffers.data();
+        engine.device.graphicsQueue.submit(submitInfo, batch.fence);
+    }
+
+    inFlight.push_back(std::move(batch));
+    batch = Batch{};
+    recording = false;
+}
+
+void Uploader::collect()
+{
+    auto &device = State::instance().engine.device;
+    // ring space is reclaimed in order so stop at the first batch still running
+    while (!inFlight.empty() && device.ready(inFlight.front().fence))
+    {
+        release(inFlight.front());
+        inFlight.pop_front();
+    }
+}
+
+void Uploader::wait()
+{
+    flush();
+
+    auto &device = State::instance().engine.device;
+    for (auto &pending : inFlight)
+    {
+        if (device.wait(pending.fence) != vk::Result::eSuccess)
+        {
+            spdlog::error("Unable to wait for upload");
+            throw std::runtime_error("Unable to wait for upload");
+        }
+        release(pending);
+    }
+    inFlight.clear();
+}
+
+void Uploader::release(Batch &finished)
+{
+    auto &device = State::instance().engine.device;
+    device.destroy(transferPool, finished.transfer);
+    device.destroy(graphicsPool, finished.graphics);
+    device.destroy(finished.fence);
+    if (finished.semaphore)
+    {
+        device.destroy(finished.semaphore);
+    }
+    finished.staging.clear();
+
+    ringUsed -= finished.ringUsed;
+    if (finished.ringUsed > 0)
+    {
+        ringTail = finished.ringEnd;
+    }
+}
+
+} // namespace tat
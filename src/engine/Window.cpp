@@ -38,9 +38,7 @@ void Window::resize(int width, int height)
     this->width = width;
     this->height = height;
 
-    auto &state = State::instance();
-    state.at("settings").at("window").at(0) = width;
-    state.at("settings").at("window").at(1) = height;
+    State::instance().settings.window = {width, height};
 }
 
 void Window::setWindowSizeCallBack(GLFWwindowsizefun callback)
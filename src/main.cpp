@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <memory>
 #include <system_error>
 #include <filesystem>
@@ -22,23 +23,32 @@ auto main(int argc, char *argv[]) -> int
         try
         {
             std::string config = defaultConfig;
-            switch (argc)
+            int32_t headlessFrames = 0;
+            auto usage = false;
+            for (int i = 1; i < argc && !usage; ++i)
             {
-            case 0:
-            case 1:
-                break;
-            case 2:
-                if (std::filesystem::exists(argv[1]))
+                std::string arg = argv[i];
+                if (arg == "--headless" && i + 1 < argc)
                 {
-                    config = argv[1];
-                    break;
-                } // fall through if doesn't exist
-            default:
-                std::cout << "Usage: VulkansEye [config]" << std::endl;
+                    headlessFrames = std::atoi(argv[++i]);
+                    usage = headlessFrames <= 0;
+                }
+                else if (config == defaultConfig && std::filesystem::exists(arg))
+                {
+                    config = arg;
+                }
+                else
+                {
+                    usage = true;
+                }
+            }
+            if (usage)
+            {
+                std::cout << "Usage: VulkansEye [config] [--headless frames]" << std::endl;
                 return EXIT_FAILURE;
             }
 
-            tat::VulkansEye app(config);
+            tat::VulkansEye app(config, headlessFrames);
             tat::VulkansEye::run();
             tat::VulkansEye::cleanup();
         }
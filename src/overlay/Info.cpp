@@ -10,6 +10,7 @@ void Info::create()
 {
     player = &State::instance().player;
     camera = &State::instance().camera;
+    profiler = &State::instance().engine.profiler;
 }
 
 void Info::show(float deltaTime)
@@ -20,10 +21,14 @@ void Info::show(float deltaTime)
     {
         data.lastUpdateTime = frameTime;
         data.fps = 1.F / deltaTime;
+        auto lock = State::instance().simulation.lock();
         data.position = player->position();
         data.rotation = camera->rotation();
+        data.sections = profiler->results;
     }
-    ImGui::SetNextWindowSize(ImVec2(320, 120));
+    // room for a line per profiled section
+    auto height = profiler->enabled ? 120.F + 16.F * (Profiler::sectionCount + 1) : 120.F;
+    ImGui::SetNextWindowSize(ImVec2(320, height));
     ImGui::SetNextWindowPos(ImVec2(0, 0));
     auto windowFlags = ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
                        ImGuiWindowFlags_NoSavedSettings;
@@ -32,6 +37,17 @@ void Info::show(float deltaTime)
     ImGui::InputFloat3("Position", &data.position.x, "%.1f", ImGuiInputTextFlags_ReadOnly);
     ImGui::InputFloat3("Rotation", &data.rotation.x, "%.1f", ImGuiInputTextFlags_ReadOnly);
     ImGui::InputText("Test", data.buffer.data(), data.buffer.size());
+    if (profiler->enabled)
+    { // gpu time, vertex and fragment shader invocations
+        ImGui::Text("%-8s %8s %10s %10s", "GPU", "ms", "VS", "FS");
+        for (uint32_t i = 0; i < Profiler::sectionCount; ++i)
+        {
+            auto &section = data.sections[i];
+            ImGui::Text("%-8s %8.3f %10llu %10llu", Profiler::sectionNames[i].data(), section.milliseconds,
+                        static_cast<unsigned long long>(section.statistics[2]),
+                        static_cast<unsigned long long>(section.statistics[4]));
+        }
+    }
     ImGui::End();
 }
 
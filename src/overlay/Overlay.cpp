@@ -121,8 +121,8 @@ void Overlay::destroy()
     auto &device = State::instance().engine.device;
 
     fontImage.destroy();
-    vertexBuffer.destroy();
-    indexBuffer.destroy();
+    vertexBuffers.clear();
+    indexBuffers.clear();
     device.destroy(descriptorSetLayout);
     device.destroy(descriptorPool);
     pipeline.destroy();
@@ -140,6 +140,7 @@ void Overlay::recreate()
     createDescriptorPool();
     createDescriptorSets();
     createPipeline();
+    createBuffers();
 }
 
 void Overlay::cleanup()
@@ -149,20 +150,37 @@ void Overlay::cleanup()
     pipeline.destroy();
 }
 
+void Overlay::reloadPipeline()
+{
+    pipeline.destroy();
+    createPipeline();
+}
+
 void Overlay::createBuffers()
 {
-    vertexBuffer.flags = vk::BufferUsageFlagBits::eVertexBuffer;
-    vertexBuffer.memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-    vertexBuffer.memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    auto &engine = State::instance().engine;
 
-    indexBuffer.flags = vk::BufferUsageFlagBits::eIndexBuffer;
-    indexBuffer.memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-    indexBuffer.memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    // clear before resizing so no buffer is copied
+    vertexBuffers.clear();
+    indexBuffers.clear();
+    vertexBuffers.resize(engine.swapChain.count);
+    indexBuffers.resize(engine.swapChain.count);
 
-    if constexpr (Debug::enable)
+    for (size_t i = 0; i < engine.swapChain.count; ++i)
     {
-        vertexBuffer.name = "Overlay Vert";
-        indexBuffer.name = "Overlay index";
+        vertexBuffers[i].flags = vk::BufferUsageFlagBits::eVertexBuffer;
+        vertexBuffers[i].memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+        vertexBuffers[i].memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        indexBuffers[i].flags = vk::BufferUsageFlagBits::eIndexBuffer;
+        indexBuffers[i].memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+        indexBuffers[i].memFlags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        if constexpr (Debug::enable)
+        {
+            vertexBuffers[i].name = fmt::format("Overlay Vert {}", i);
+            indexBuffers[i].name = fmt::format("Overlay Index {}", i);
+        }
     }
 }
 
@@ -179,35 +197,20 @@ void Overlay::createFont()
     fontImage.imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
     fontImage.memUsage = VMA_MEMORY_USAGE_GPU_ONLY;
     fontImage.resize(texWidth, texHeight);
-    fontImage.transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
 
-    // Staging buffers for font data upload
-    Buffer stagingBuffer{};
-    stagingBuffer.flags = vk::BufferUsageFlagBits::eTransferSrc;
-    stagingBuffer.memUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-    if constexpr (Debug::enable)
-    {
-        stagingBuffer.name = "Overlay Staging";
-    }
-    stagingBuffer.update(fontData, uploadSize);
+    // Staging memory for font data upload
+    auto staging = engine.uploader.stage(fontData, uploadSize);
 
     // Copy buffer data to font image
-    auto copyCmd = engine.beginSingleTimeCommands();
-
-    // Copy
-    vk::BufferImageCopy bufferCopyRegion{};
+    std::vector<vk::BufferImageCopy> bufferCopyRegions(1);
+    auto &bufferCopyRegion = bufferCopyRegions[0];
     bufferCopyRegion.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
     bufferCopyRegion.imageSubresource.layerCount = 1;
     bufferCopyRegion.imageExtent.width = texWidth;
     bufferCopyRegion.imageExtent.height = texHeight;
     bufferCopyRegion.imageExtent.depth = 1;
 
-    copyCmd.copyBufferToImage(stagingBuffer.buffer, fontImage.image, vk::ImageLayout::eTransferDstOptimal, 1,
-                              &bufferCopyRegion);
-
-    engine.endSingleTimeCommands(copyCmd);
-
-    fontImage.transitionImageLayout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+    engine.uploader.copy(staging, fontImage, bufferCopyRegions, vk::ImageLayout::eShaderReadOnlyOptimal);
 
     // Font texture Sampler
     fontImage.samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
@@ -397,51 +400,53 @@ void Overlay::update(float deltaTime)
     }
 
     ImGui::Render();
+}
 
+void Overlay::upload(uint32_t currentImage)
+{
     auto *imDrawData = ImGui::GetDrawData();
-    if (imDrawData != nullptr)
+    auto &vertexBuffer = vertexBuffers[currentImage];
+    auto &indexBuffer = indexBuffers[currentImage];
+
+    // recreate buffers only if they are too small
+    // the frame that used this image has finished so the old buffers can go
+    auto vertexBufferSize = imDrawData->TotalVtxCount * sizeof(ImDrawVert);
+    auto indexBufferSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
+    if (vertexBuffer.getSize() < vertexBufferSize)
     {
-        // recreate buffers only if vertex or index size has been changed
-        auto vertexBufferSize = imDrawData->TotalVtxCount * sizeof(ImDrawVert);
-        auto indexBufferSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
-        auto &engine = State::instance().engine;
-        if (vertexBuffer.getSize() < vertexBufferSize)
-        {
-            engine.device.wait();
-            vertexBuffer.create(vertexBufferSize);
-            engine.updateCommandBuffer = true;
-        }
-        if (indexBuffer.getSize() < indexBufferSize)
-        {
-            engine.device.wait();
-            indexBuffer.create(indexBufferSize);
-            engine.updateCommandBuffer = true;
-        }
-
-        // Upload data
-        auto *vtxDst = reinterpret_cast<ImDrawVert *>(vertexBuffer.mapped);
-        auto *idxDst = reinterpret_cast<ImDrawVert *>(indexBuffer.mapped);
-        for (int n = 0; n < imDrawData->CmdListsCount; n++)
-        {
-            const auto *cmd_list = imDrawData->CmdLists[n];
-            memcpy(vtxDst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-            memcpy(idxDst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-            vtxDst += cmd_list->VtxBuffer.Size;
-            idxDst += cmd_list->IdxBuffer.Size;
-        }
+        vertexBuffer.create(vertexBufferSize);
+    }
+    if (indexBuffer.getSize() < indexBufferSize)
+    {
+        indexBuffer.create(indexBufferSize);
+    }
 
-        // Flush to make writes visible to GPU
-        vertexBuffer.flush();
-        indexBuffer.flush();
+    // Upload data
+    auto *vtxDst = reinterpret_cast<ImDrawVert *>(vertexBuffer.mapped);
+    auto *idxDst = reinterpret_cast<ImDrawIdx *>(indexBuffer.mapped);
+    for (int n = 0; n < imDrawData->CmdListsCount; n++)
+    {
+        const auto *cmd_list = imDrawData->CmdLists[n];
+        memcpy(vtxDst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        memcpy(idxDst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        vtxDst += cmd_list->VtxBuffer.Size;
+        idxDst += cmd_list->IdxBuffer.Size;
     }
+
+    // Flush to make writes visible to GPU
+    vertexBuffer.flush();
+    indexBuffer.flush();
 }
 
 void Overlay::draw(vk::CommandBuffer commandBuffer, uint32_t currentImage)
 {
-    if ((!vertexBuffer.buffer) || (!indexBuffer.buffer))
-    {
-        update(0.F);
+    auto *imDrawData = ImGui::GetDrawData();
+    if (imDrawData == nullptr || imDrawData->TotalVtxCount == 0 || imDrawData->TotalIdxCount == 0)
+    { // nothing to draw
+        return;
     }
+    upload(currentImage);
+
     auto &io = ImGui::GetIO();
     commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.pipelineLayout, 0, 1,
                                      &descriptorSets[currentImage], 0, nullptr);
@@ -454,13 +459,12 @@ void Overlay::draw(vk::CommandBuffer commandBuffer, uint32_t currentImage)
                                 &pushConstBlock);
 
     // Render commands
-    auto *imDrawData = ImGui::GetDrawData();
     int32_t vertexOffset = 0;
     int32_t indexOffset = 0;
 
     std::array<vk::DeviceSize, 1> offsets{};
-    commandBuffer.bindVertexBuffers(0, 1, &vertexBuffer.buffer, offsets.data());
-    commandBuffer.bindIndexBuffer(indexBuffer.buffer, 0, vk::IndexType::eUint16);
+    commandBuffer.bindVertexBuffers(0, 1, &vertexBuffers[currentImage].buffer, offsets.data());
+    commandBuffer.bindIndexBuffer(indexBuffers[currentImage].buffer, 0, vk::IndexType::eUint16);
 
     for (int32_t i = 0; i < imDrawData->CmdListsCount; i++)
     {